@@ -8,24 +8,193 @@
 
 #include "obr/ambisonic_binaural_decoder/ambisonic_binaural_decoder.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <memory>
+#include <tuple>
+#include <vector>
 
 #include "absl/log/check.h"
+#include "obr/ambisonic_binaural_decoder/direct_form_fir_filter.h"
+#include "obr/ambisonic_binaural_decoder/dsp_utils.h"
 #include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/kernel_cache.h"
+#include "obr/ambisonic_binaural_decoder/non_uniform_partitioned_fft_filter.h"
 #include "obr/ambisonic_binaural_decoder/partitioned_fft_filter.h"
+#include "obr/ambisonic_binaural_decoder/stereo_partitioned_fft_filter.h"
 #include "obr/audio_buffer/audio_buffer.h"
+#include "obr/audio_buffer/simd_utils.h"
+#include "obr/common/ambisonic_utils.h"
 #include "obr/common/constants.h"
-#include "obr/common/misc_math.h"
+#include "obr/common/processing_stats.h"
+#include "obr/common/thread_pool.h"
 
 namespace obr {
 
+namespace {
+
+// Marks the kernel partitions of one ear which can be skipped. Partitions are
+// skipped in order of increasing energy, as long as the energy of all skipped
+// partitions stays `threshold_db` below the energy of all kernels.
+std::vector<std::vector<bool>> FindSkippedPartitions(
+    const AudioBuffer& sh_hrirs, size_t partition_size, float threshold_db) {
+  const size_t num_channels = sh_hrirs.num_channels();
+  const size_t num_frames = sh_hrirs.num_frames();
+  const size_t num_partitions =
+      CeilToMultipleOfFramesPerBuffer(num_frames, partition_size) /
+      partition_size;
+
+  // Energy, channel and index of each partition.
+  std::vector<std::tuple<double, size_t, size_t>> partition_energies;
+  partition_energies.reserve(num_channels * num_partitions);
+  double total_energy = 0.0;
+  for (size_t channel = 0; channel < num_channels; ++channel) {
+    for (size_t partition = 0; partition < num_partitions; ++partition) {
+      const size_t end_frame =
+          std::min(num_frames, (partition + 1) * partition_size);
+      double energy = 0.0;
+      for (size_t frame = partition * partition_size; frame < end_frame;
+           ++frame) {
+        energy += sh_hrirs[channel][frame] * sh_hrirs[channel][frame];
+      }
+      partition_energies.emplace_back(energy, channel, partition);
+      total_energy += energy;
+    }
+  }
+  std::sort(partition_energies.begin(), partition_energies.end());
+
+  std::vector<std::vector<bool>> skipped_partitions(
+      num_channels, std::vector<bool>(num_partitions, false));
+  const double max_skipped_energy =
+      total_energy * std::pow(10.0, threshold_db / 10.0);
+  double skipped_energy = 0.0;
+  for (const auto& [energy, channel, partition] : partition_energies) {
+    if (skipped_energy + energy > max_skipped_energy) {
+      break;
+    }
+    skipped_energy += energy;
+    skipped_partitions[channel][partition] = true;
+  }
+  return skipped_partitions;
+}
+
+// Returns the number of partitions up to the last one which is not skipped in
+// either ear, but at least one.
+size_t GetNumUsedPartitions(const std::vector<bool>& skipped_partitions_L,
+                            const std::vector<bool>& skipped_partitions_R) {
+  size_t num_used_partitions = skipped_partitions_L.size();
+  while (num_used_partitions > 1 &&
+         skipped_partitions_L[num_used_partitions - 1] &&
+         skipped_partitions_R[num_used_partitions - 1]) {
+    --num_used_partitions;
+  }
+  return num_used_partitions;
+}
+
+// Splits SH-HRIRs into their early part, faded out from `tail_begin` to the end
+// of `early_sh_hrirs`, and a late tail for the W channel only. The tail is the
+// W channel SH-HRIR from `tail_begin` on, faded in over the same taps. It is
+// scaled such that in a diffuse sound field, where an SN3D normalized channel
+// of order n carries 1 / (2n + 1) of the power of the W channel, it has the
+// energy of the tails of all channels.
+void SplitEarlyAndLateTail(const AudioBuffer& sh_hrirs, size_t tail_begin,
+                           AudioBuffer* early_sh_hrirs,
+                           AudioBuffer* late_tail) {
+  const size_t num_channels = sh_hrirs.num_channels();
+  const size_t num_frames = sh_hrirs.num_frames();
+  const size_t early_size = early_sh_hrirs->num_frames();
+  const size_t crossfade_size = early_size - tail_begin;
+  DCHECK_LE(tail_begin, early_size);
+  DCHECK_LT(early_size, num_frames);
+  DCHECK_EQ(early_sh_hrirs->num_channels(), num_channels);
+  DCHECK_EQ(late_tail->num_frames(), num_frames);
+
+  double diffuse_tail_energy = 0.0;
+  double w_tail_energy = 0.0;
+  for (size_t channel = 0; channel < num_channels; ++channel) {
+    double energy = 0.0;
+    for (size_t frame = tail_begin; frame < num_frames; ++frame) {
+      energy += sh_hrirs[channel][frame] * sh_hrirs[channel][frame];
+    }
+    const int order = GetPeriphonicAmbisonicOrderForChannel(channel);
+    diffuse_tail_energy += energy / static_cast<double>(2 * order + 1);
+    if (channel == 0) {
+      w_tail_energy = energy;
+    }
+  }
+  const float tail_gain =
+      w_tail_energy > 0.0
+          ? static_cast<float>(std::sqrt(diffuse_tail_energy / w_tail_energy))
+          : 0.0f;
+
+  // Raised cosine fade-in of the tail, the early part fades out accordingly.
+  std::vector<float> fade_in(crossfade_size);
+  for (size_t i = 0; i < crossfade_size; ++i) {
+    fade_in[i] = 0.5f - 0.5f * std::cos(kPi * (static_cast<float>(i) + 0.5f) /
+                                        static_cast<float>(crossfade_size));
+  }
+
+  for (size_t channel = 0; channel < num_channels; ++channel) {
+    auto& early_channel = (*early_sh_hrirs)[channel];
+    for (size_t frame = 0; frame < early_size; ++frame) {
+      early_channel[frame] = sh_hrirs[channel][frame];
+    }
+    for (size_t i = 0; i < crossfade_size; ++i) {
+      early_channel[tail_begin + i] *= 1.0f - fade_in[i];
+    }
+  }
+
+  auto& late_tail_channel = (*late_tail)[0];
+  late_tail->Clear();
+  for (size_t frame = tail_begin; frame < num_frames; ++frame) {
+    late_tail_channel[frame] = tail_gain * sh_hrirs[0][frame];
+  }
+  for (size_t i = 0; i < crossfade_size; ++i) {
+    late_tail_channel[tail_begin + i] *= fade_in[i];
+  }
+}
+
+// Returns true if a channel is disabled or below -120 dB, so its convolution
+// can be skipped.
+bool IsSilent(const AudioBuffer& input, size_t channel) {
+  return !input[channel].IsEnabled() ||
+         IsBelowThreshold(input.num_frames(), kNegative120dbInAmplitude,
+                          input[channel].begin());
+}
+
+}  // namespace
+
+AmbisonicBinauralDecoder::ChannelGroup::ChannelGroup(size_t begin_channel,
+                                                     size_t end_channel,
+                                                     FftManager* fft_manager,
+                                                     size_t frames_per_buffer)
+    : begin_channel(begin_channel),
+      end_channel(end_channel),
+      owned_fft_manager(fft_manager == nullptr
+                            ? std::make_unique<FftManager>(frames_per_buffer)
+                            : nullptr),
+      fft_manager(fft_manager == nullptr ? owned_fft_manager.get()
+                                         : fft_manager),
+      freq_input(kNumMonoChannels, this->fft_manager->GetFftSize()),
+      freq_domain_accumulator(kNumBinauralChannels,
+                              this->fft_manager->GetFftSize()) {}
+
 AmbisonicBinauralDecoder::AmbisonicBinauralDecoder(
     const AudioBuffer& sh_hrirs_L, const AudioBuffer& sh_hrirs_R,
     size_t frames_per_buffer, FftManager* fft_manager)
+    : AmbisonicBinauralDecoder(sh_hrirs_L, sh_hrirs_R, frames_per_buffer,
+                               fft_manager, AmbisonicBinauralDecoderOptions()) {
+}
+
+AmbisonicBinauralDecoder::AmbisonicBinauralDecoder(
+    const AudioBuffer& sh_hrirs_L, const AudioBuffer& sh_hrirs_R,
+    size_t frames_per_buffer, FftManager* fft_manager,
+    const AmbisonicBinauralDecoderOptions& options)
     : fft_manager_(fft_manager),
-      freq_input_(kNumMonoChannels,
-                  NextPowTwo(frames_per_buffer) * kNumStereoChannels),
-      filtered_input_(kNumMonoChannels, frames_per_buffer) {
+      buffer_selector_(0),
+      filtered_time_domain_buffers_(2 * kNumBinauralChannels,
+                                    fft_manager_->GetFftSize()) {
   CHECK_NE(fft_manager_, nullptr);
   CHECK_NE(frames_per_buffer, 0U);
   const size_t num_channels = sh_hrirs_L.num_channels();
@@ -33,52 +202,366 @@ AmbisonicBinauralDecoder::AmbisonicBinauralDecoder(
   CHECK_NE(num_channels, 0U);
   CHECK_NE(filter_size, 0U);
 
-  // Setup left ear filters.
-  sh_hrir_filters_L_.reserve(num_channels);
-  for (size_t i = 0; i < num_channels; ++i) {
-    sh_hrir_filters_L_.emplace_back(
-        new PartitionedFftFilter(filter_size, frames_per_buffer, fft_manager_));
-    sh_hrir_filters_L_[i]->SetTimeDomainKernel(sh_hrirs_L[i]);
+  CHECK_EQ(sh_hrirs_R.num_channels(), num_channels);
+  CHECK_EQ(sh_hrirs_R.num_frames(), filter_size);
+
+  if (options.convolution_mode == ConvolutionMode::kNonUniformPartitioned) {
+    non_uniform_filter_ = std::make_unique<NonUniformPartitionedFftFilter>(
+        sh_hrirs_L, sh_hrirs_R, frames_per_buffer, options.max_partition_size,
+        0);
+    dense_input_ = AudioBuffer(num_channels, frames_per_buffer);
+    return;
   }
 
-  // Setup right ear filters.
-  CHECK_EQ(sh_hrirs_R.num_channels(), num_channels);
-  sh_hrir_filters_R_.reserve(num_channels);
+  if (options.convolution_mode == ConvolutionMode::kTimeDomainHead) {
+    CHECK_NE(options.head_size, 0U);
+    dense_input_ = AudioBuffer(num_channels, frames_per_buffer);
+    const size_t head_size = std::min(options.head_size, filter_size);
+    head_filter_ = std::make_unique<DirectFormFirFilter>(
+        sh_hrirs_L, sh_hrirs_R, head_size, frames_per_buffer);
+    if (head_size < filter_size) {
+      non_uniform_filter_ = std::make_unique<NonUniformPartitionedFftFilter>(
+          sh_hrirs_L, sh_hrirs_R, frames_per_buffer,
+          options.max_partition_size, head_size);
+      tail_output_ = AudioBuffer(kNumBinauralChannels, frames_per_buffer);
+    }
+    return;
+  }
+
+  InitializeChannelGroups(num_channels, frames_per_buffer,
+                          options.num_threads);
+
+  // In hybrid mode, only the early part of the SH-HRIRs is convolved per
+  // channel. The late part is rendered by a shared tail filter on the W
+  // channel.
+  AudioBuffer early_sh_hrirs_L, early_sh_hrirs_R;
+  if (options.shared_late_tail && options.early_size < filter_size) {
+    CHECK_LE(options.late_tail_crossfade_size, options.early_size);
+    const size_t tail_begin =
+        options.early_size - options.late_tail_crossfade_size;
+    early_sh_hrirs_L = AudioBuffer(num_channels, options.early_size);
+    early_sh_hrirs_R = AudioBuffer(num_channels, options.early_size);
+    AudioBuffer late_tail_L(kNumMonoChannels, filter_size);
+    AudioBuffer late_tail_R(kNumMonoChannels, filter_size);
+    SplitEarlyAndLateTail(sh_hrirs_L, tail_begin, &early_sh_hrirs_L,
+                          &late_tail_L);
+    SplitEarlyAndLateTail(sh_hrirs_R, tail_begin, &early_sh_hrirs_R,
+                          &late_tail_R);
+    late_tail_filter_ = std::make_unique<NonUniformPartitionedFftFilter>(
+        late_tail_L, late_tail_R, frames_per_buffer, options.max_partition_size,
+        tail_begin);
+    late_tail_input_ = AudioBuffer(kNumMonoChannels, frames_per_buffer);
+    tail_output_ = AudioBuffer(kNumBinauralChannels, frames_per_buffer);
+  }
+  const AudioBuffer& kernels_L =
+      late_tail_filter_ != nullptr ? early_sh_hrirs_L : sh_hrirs_L;
+  const AudioBuffer& kernels_R =
+      late_tail_filter_ != nullptr ? early_sh_hrirs_R : sh_hrirs_R;
+  const size_t kernel_size = kernels_L.num_frames();
+
+  // Find the kernel partitions which can be skipped.
+  const size_t num_partitions =
+      CeilToMultipleOfFramesPerBuffer(kernel_size, frames_per_buffer) /
+      frames_per_buffer;
+  std::vector<std::vector<bool>> skipped_partitions_L(
+      num_channels, std::vector<bool>(num_partitions, false));
+  std::vector<std::vector<bool>> skipped_partitions_R = skipped_partitions_L;
+  if (options.prune_kernels) {
+    skipped_partitions_L = FindSkippedPartitions(
+        kernels_L, frames_per_buffer, options.kernel_pruning_threshold_db);
+    skipped_partitions_R =
+        options.symmetric_sh_hrirs
+            ? skipped_partitions_L
+            : FindSkippedPartitions(kernels_R, frames_per_buffer,
+                                    options.kernel_pruning_threshold_db);
+  }
+
+  const size_t num_ears =
+      options.symmetric_sh_hrirs ? kNumMonoChannels : kNumBinauralChannels;
+  kernel_pruning_stats_.num_partitions =
+      num_ears * num_channels * num_partitions;
   for (size_t i = 0; i < num_channels; ++i) {
-    sh_hrir_filters_R_.emplace_back(
-        new PartitionedFftFilter(filter_size, frames_per_buffer, fft_manager_));
-    sh_hrir_filters_R_[i]->SetTimeDomainKernel(sh_hrirs_R[i]);
+    kernel_pruning_stats_.num_skipped_partitions +=
+        std::count(skipped_partitions_L[i].begin(),
+                   skipped_partitions_L[i].end(), true);
+    if (!options.symmetric_sh_hrirs) {
+      kernel_pruning_stats_.num_skipped_partitions +=
+          std::count(skipped_partitions_R[i].begin(),
+                     skipped_partitions_R[i].end(), true);
+    }
+  }
+  // Each partition takes `fft_size / 2` complex multiply-accumulates.
+  const size_t flops_per_partition = 4 * fft_manager_->GetFftSize();
+  kernel_pruning_stats_.flops_per_buffer =
+      kernel_pruning_stats_.num_partitions * flops_per_partition;
+  kernel_pruning_stats_.saved_flops_per_buffer =
+      kernel_pruning_stats_.num_skipped_partitions * flops_per_partition;
+
+  if (options.symmetric_sh_hrirs) {
+    symmetric_sh_hrir_filters_.reserve(num_channels);
+    for (const auto& group : channel_groups_) {
+      for (size_t i = group->begin_channel; i < group->end_channel; ++i) {
+        const size_t num_used_partitions = GetNumUsedPartitions(
+            skipped_partitions_L[i], skipped_partitions_L[i]);
+        symmetric_sh_hrir_filters_.emplace_back(new PartitionedFftFilter(
+            kernel_size, frames_per_buffer, kernel_size, group->fft_manager,
+            options.spectrum_precision));
+        symmetric_sh_hrir_filters_[i]->SetTimeDomainKernel(kernels_L[i]);
+        symmetric_sh_hrir_filters_[i]->SetFilterLength(num_used_partitions *
+                                                       frames_per_buffer);
+        symmetric_sh_hrir_filters_[i]->SetSkippedPartitions(
+            std::vector<bool>(
+                skipped_partitions_L[i].begin(),
+                skipped_partitions_L[i].begin() + num_used_partitions));
+      }
+    }
+    filtered_time_domain_buffers_.Clear();
+    return;
+  }
+
+  // Setup filters sharing a single input delay line for both ears. The delay
+  // line only needs to be as long as the longer of the pruned kernels.
+  sh_hrir_filters_.reserve(num_channels);
+  for (const auto& group : channel_groups_) {
+    for (size_t i = group->begin_channel; i < group->end_channel; ++i) {
+      const size_t num_used_partitions = GetNumUsedPartitions(
+          skipped_partitions_L[i], skipped_partitions_R[i]);
+      sh_hrir_filters_.emplace_back(new StereoPartitionedFftFilter(
+          num_used_partitions * frames_per_buffer, frames_per_buffer,
+          group->fft_manager, options.spectrum_precision));
+      sh_hrir_filters_[i]->SetTimeDomainKernels(kernels_L[i], kernels_R[i]);
+      sh_hrir_filters_[i]->SetSkippedPartitions(
+          std::vector<bool>(
+              skipped_partitions_L[i].begin(),
+              skipped_partitions_L[i].begin() + num_used_partitions),
+          std::vector<bool>(
+              skipped_partitions_R[i].begin(),
+              skipped_partitions_R[i].begin() + num_used_partitions));
+    }
+  }
+  filtered_time_domain_buffers_.Clear();
+}
+
+AmbisonicBinauralDecoder::AmbisonicBinauralDecoder(
+    std::shared_ptr<const PartitionedFreqDomainKernels> sh_hrir_spectra_L,
+    std::shared_ptr<const PartitionedFreqDomainKernels> sh_hrir_spectra_R,
+    size_t frames_per_buffer, FftManager* fft_manager,
+    const AmbisonicBinauralDecoderOptions& options)
+    : fft_manager_(fft_manager),
+      buffer_selector_(0),
+      filtered_time_domain_buffers_(2 * kNumBinauralChannels,
+                                    fft_manager_->GetFftSize()) {
+  CHECK_NE(fft_manager_, nullptr);
+  CHECK_NE(frames_per_buffer, 0U);
+  CHECK(options.convolution_mode == ConvolutionMode::kUniformPartitioned);
+  CHECK(!options.symmetric_sh_hrirs);
+  CHECK(!options.prune_kernels);
+  CHECK(!options.shared_late_tail);
+  CHECK_NE(sh_hrir_spectra_L, nullptr);
+  CHECK_NE(sh_hrir_spectra_R, nullptr);
+  const size_t num_channels = sh_hrir_spectra_L->size();
+  CHECK_NE(num_channels, 0U);
+  CHECK_EQ(sh_hrir_spectra_R->size(), num_channels);
+  const size_t num_partitions = (*sh_hrir_spectra_L)[0].num_channels();
+  CHECK_NE(num_partitions, 0U);
+
+  InitializeChannelGroups(num_channels, frames_per_buffer,
+                          options.num_threads);
+
+  kernel_pruning_stats_.num_partitions =
+      kNumBinauralChannels * num_channels * num_partitions;
+  kernel_pruning_stats_.flops_per_buffer =
+      kernel_pruning_stats_.num_partitions * 4 * fft_manager_->GetFftSize();
+
+  sh_hrir_filters_.reserve(num_channels);
+  for (const auto& group : channel_groups_) {
+    for (size_t i = group->begin_channel; i < group->end_channel; ++i) {
+      sh_hrir_filters_.emplace_back(new StereoPartitionedFftFilter(
+          num_partitions * frames_per_buffer, frames_per_buffer,
+          group->fft_manager, options.spectrum_precision));
+      // Each filter references its channel of the spectra and keeps all of
+      // them alive.
+      sh_hrir_filters_[i]->SetSharedFreqDomainKernels(
+          std::shared_ptr<const PartitionedFftFilter::FreqDomainBuffer>(
+              sh_hrir_spectra_L, &(*sh_hrir_spectra_L)[i]),
+          std::shared_ptr<const PartitionedFftFilter::FreqDomainBuffer>(
+              sh_hrir_spectra_R, &(*sh_hrir_spectra_R)[i]));
+    }
+  }
+  filtered_time_domain_buffers_.Clear();
+}
+
+void AmbisonicBinauralDecoder::InitializeChannelGroups(
+    size_t num_channels, size_t frames_per_buffer, size_t num_threads) {
+  // Split the channels into contiguous groups of nearly equal size, one per
+  // thread. Each group uses its own FFT manager, as those are not thread safe.
+  CHECK_NE(num_threads, 0U);
+  const size_t num_groups = std::min(num_threads, num_channels);
+  channel_groups_.reserve(num_groups);
+  for (size_t group = 0; group < num_groups; ++group) {
+    channel_groups_.emplace_back(new ChannelGroup(
+        group * num_channels / num_groups,
+        (group + 1) * num_channels / num_groups,
+        group == 0 ? fft_manager_ : nullptr, frames_per_buffer));
+  }
+  if (num_groups > 1) {
+    thread_pool_ = std::make_unique<ThreadPool>(num_groups - 1);
+  }
+}
+
+void AmbisonicBinauralDecoder::FilterChannelGroup(const AudioBuffer& input,
+                                                  ChannelGroup* group) {
+  AudioBuffer::Channel* freq_input_channel = &group->freq_input[0];
+  AudioBuffer::Channel* accumulator_channel_L =
+      &group->freq_domain_accumulator[0];
+  AudioBuffer::Channel* accumulator_channel_R =
+      &group->freq_domain_accumulator[1];
+  group->freq_domain_accumulator.Clear();
+  DecoderStageTimings* stage_timings = &group->stage_timings;
+  *stage_timings = {};
+  StageTimer timer;
+  timer.Start();
+
+  // Convolution is linear, so the spectra of all spherical harmonic channels
+  // are summed per ear before transforming back to the time domain.
+  if (!symmetric_sh_hrir_filters_.empty()) {
+    for (size_t channel = group->begin_channel; channel < group->end_channel;
+         ++channel) {
+      const bool is_antisymmetric =
+          GetPeriphonicAmbisonicDegreeForChannel(channel) < 0;
+      auto* accumulator_channel =
+          &group->freq_domain_accumulator[is_antisymmetric ? 1 : 0];
+      if (IsSilent(input, channel)) {
+        symmetric_sh_hrir_filters_[channel]->FilterSilenceAndAccumulate(
+            accumulator_channel);
+        timer.Lap(&stage_timings->multiply_accumulate_us);
+        continue;
+      }
+      group->fft_manager->FreqFromTimeDomain(input[channel],
+                                             freq_input_channel);
+      timer.Lap(&stage_timings->forward_fft_us);
+      symmetric_sh_hrir_filters_[channel]->FilterAndAccumulate(
+          *freq_input_channel, accumulator_channel);
+      timer.Lap(&stage_timings->multiply_accumulate_us);
+    }
+    return;
+  }
+
+  for (size_t channel = group->begin_channel; channel < group->end_channel;
+       ++channel) {
+    if (IsSilent(input, channel)) {
+      sh_hrir_filters_[channel]->FilterSilenceAndAccumulate(
+          accumulator_channel_L, accumulator_channel_R);
+      timer.Lap(&stage_timings->multiply_accumulate_us);
+      continue;
+    }
+    group->fft_manager->FreqFromTimeDomain(input[channel], freq_input_channel);
+    timer.Lap(&stage_timings->forward_fft_us);
+    sh_hrir_filters_[channel]->FilterAndAccumulate(
+        *freq_input_channel, accumulator_channel_L, accumulator_channel_R);
+    timer.Lap(&stage_timings->multiply_accumulate_us);
   }
 }
 
+const AudioBuffer& AmbisonicBinauralDecoder::GetDenseInput(
+    const AudioBuffer& input) {
+  bool has_disabled_channels = false;
+  for (size_t channel = 0; channel < input.num_channels(); ++channel) {
+    has_disabled_channels |= !input[channel].IsEnabled();
+  }
+  if (!has_disabled_channels) {
+    return input;
+  }
+  CHECK_EQ(input.num_channels(), dense_input_.num_channels());
+  CHECK_EQ(input.num_frames(), dense_input_.num_frames());
+  for (size_t channel = 0; channel < input.num_channels(); ++channel) {
+    if (input[channel].IsEnabled()) {
+      dense_input_[channel] = input[channel];
+    } else {
+      dense_input_[channel].Clear();
+    }
+  }
+  return dense_input_;
+}
+
 void AmbisonicBinauralDecoder::ProcessAudioBuffer(const AudioBuffer& input,
                                                   AudioBuffer* output) {
-  CHECK_EQ(input.num_channels(), sh_hrir_filters_L_.size());
-  CHECK_EQ(input.num_channels(), sh_hrir_filters_R_.size());
+  stage_timings_ = {};
+  if (head_filter_ != nullptr) {
+    const AudioBuffer& dense_input = GetDenseInput(input);
+    head_filter_->Process(dense_input, output);
+    if (non_uniform_filter_ != nullptr) {
+      non_uniform_filter_->Process(dense_input, &tail_output_);
+      *output += tail_output_;
+    }
+    return;
+  }
+
+  if (non_uniform_filter_ != nullptr) {
+    non_uniform_filter_->Process(GetDenseInput(input), output);
+    return;
+  }
+
+  CHECK_EQ(input.num_channels(), channel_groups_.back()->end_channel);
   CHECK_NE(output, nullptr);
   CHECK_EQ(input.num_frames(), output->num_frames());
   CHECK_EQ(output->num_channels(), kNumBinauralChannels);
 
-  output->Clear();
-  AudioBuffer::Channel* output_channel_0 = &(*output)[0];
-  AudioBuffer::Channel* output_channel_1 = &(*output)[1];
+  if (thread_pool_ != nullptr) {
+    thread_pool_->ParallelFor(channel_groups_.size(), [&](size_t group) {
+      FilterChannelGroup(input, channel_groups_[group].get());
+    });
+  } else {
+    FilterChannelGroup(input, channel_groups_[0].get());
+  }
+  StageTimer timer;
+  timer.Start();
+
+  // Sum the group accumulators in a fixed order, so the output does not
+  // depend on the thread scheduling.
+  auto& freq_domain_accumulator = channel_groups_[0]->freq_domain_accumulator;
+  for (size_t group = 1; group < channel_groups_.size(); ++group) {
+    freq_domain_accumulator += channel_groups_[group]->freq_domain_accumulator;
+  }
+  for (const auto& group : channel_groups_) {
+    stage_timings_.forward_fft_us += group->stage_timings.forward_fft_us;
+    stage_timings_.multiply_accumulate_us +=
+        group->stage_timings.multiply_accumulate_us;
+  }
+
+  if (!symmetric_sh_hrir_filters_.empty()) {
+    // The left ear is the sum and the right ear the difference of the
+    // symmetric and antisymmetric parts.
+    auto& symmetric_part = freq_domain_accumulator[0];
+    auto& antisymmetric_part = freq_domain_accumulator[1];
+    for (size_t i = 0; i < symmetric_part.size(); ++i) {
+      const float symmetric_value = symmetric_part[i];
+      symmetric_part[i] += antisymmetric_part[i];
+      antisymmetric_part[i] = symmetric_value - antisymmetric_part[i];
+    }
+  }
+  timer.Lap(&stage_timings_.multiply_accumulate_us);
 
-  // Separate left/right ear signal processing.
-  AudioBuffer::Channel* freq_input_channel_L = &freq_input_[0];
-  AudioBuffer::Channel* freq_input_channel_R = &freq_input_[0];
-  AudioBuffer::Channel* filtered_input_channel_L = &filtered_input_[0];
-  AudioBuffer::Channel* filtered_input_channel_R = &filtered_input_[0];
+  buffer_selector_ = !buffer_selector_;
+  for (size_t ear = 0; ear < kNumBinauralChannels; ++ear) {
+    auto& curr_block =
+        filtered_time_domain_buffers_[2 * ear + buffer_selector_];
+    const auto& prev_block =
+        filtered_time_domain_buffers_[2 * ear + !buffer_selector_];
+    fft_manager_->TimeFromFreqDomain(freq_domain_accumulator[ear],
+                                     &curr_block);
+    OverlapAdd(curr_block, prev_block, &(*output)[ear]);
+  }
+  timer.Lap(&stage_timings_.inverse_fft_us);
 
-  for (size_t channel = 0; channel < input.num_channels(); ++channel) {
-    fft_manager_->FreqFromTimeDomain(input[channel], freq_input_channel_L);
-    sh_hrir_filters_L_[channel]->Filter(*freq_input_channel_L);
-    sh_hrir_filters_L_[channel]->GetFilteredSignal(filtered_input_channel_L);
-    *output_channel_0 += *filtered_input_channel_L;
-
-    fft_manager_->FreqFromTimeDomain(input[channel], freq_input_channel_R);
-    sh_hrir_filters_R_[channel]->Filter(*freq_input_channel_R);
-    sh_hrir_filters_R_[channel]->GetFilteredSignal(filtered_input_channel_R);
-    *output_channel_1 += *filtered_input_channel_R;
+  if (late_tail_filter_ != nullptr) {
+    if (input[0].IsEnabled()) {
+      late_tail_input_[0] = input[0];
+    } else {
+      late_tail_input_[0].Clear();
+    }
+    late_tail_filter_->Process(late_tail_input_, &tail_output_);
+    *output += tail_output_;
   }
 }
 
@@ -13,13 +13,119 @@
 #include <memory>
 #include <vector>
 
+#include "obr/ambisonic_binaural_decoder/direct_form_fir_filter.h"
 #include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/kernel_cache.h"
+#include "obr/ambisonic_binaural_decoder/non_uniform_partitioned_fft_filter.h"
 #include "obr/ambisonic_binaural_decoder/partitioned_fft_filter.h"
+#include "obr/ambisonic_binaural_decoder/stereo_partitioned_fft_filter.h"
 #include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/processing_stats.h"
+#include "obr/common/thread_pool.h"
 
 // This code is forked from Resonance Audio's `ambisonic_binaural_decoder.h`.
 namespace obr {
 
+/*!\brief Convolution engines available in `AmbisonicBinauralDecoder`. */
+enum class ConvolutionMode {
+  // Uniformly partitioned convolution with partitions of `frames_per_buffer`.
+  kUniformPartitioned,
+  // Non-uniformly partitioned convolution with geometrically growing
+  // partitions, see `NonUniformPartitionedFftFilter`. Preferable for small
+  // buffer sizes with long SH-HRIRs.
+  kNonUniformPartitioned,
+  // Time domain convolution of the first `head_size` taps with a
+  // `DirectFormFirFilter` and non-uniformly partitioned convolution of the
+  // remainder. The FFT partition sizes are then no longer bound to
+  // `frames_per_buffer`, which makes very small buffer sizes affordable.
+  kTimeDomainHead,
+};
+
+/*!\brief Options of an `AmbisonicBinauralDecoder`. */
+struct AmbisonicBinauralDecoderOptions {
+  // Convolution engine used to filter the spherical harmonic channels.
+  ConvolutionMode convolution_mode = ConvolutionMode::kUniformPartitioned;
+
+  // Upper bound for the partition size in frames in
+  // `ConvolutionMode::kNonUniformPartitioned` and
+  // `ConvolutionMode::kTimeDomainHead` modes.
+  size_t max_partition_size = 2048;
+
+  // Number of kernel taps convolved in the time domain in
+  // `ConvolutionMode::kTimeDomainHead` mode.
+  size_t head_size = 64;
+
+  // Number of threads filtering the spherical harmonic channels in
+  // `ConvolutionMode::kUniformPartitioned` mode, including the calling
+  // thread. Values above one create a persistent pool of worker threads.
+  size_t num_threads = 1;
+
+  // Assume a left/right symmetric head in
+  // `ConvolutionMode::kUniformPartitioned` mode. Only the left ear SH-HRIRs
+  // are used; the right ear filters are derived by flipping the sign of the
+  // sin (m < 0) harmonics. This halves the kernel memory and the number of
+  // complex multiply-accumulates. See `AreShHrirsSymmetric`.
+  bool symmetric_sh_hrirs = false;
+
+  // Skip the kernel partitions with the least energy in
+  // `ConvolutionMode::kUniformPartitioned` mode. Per ear, partitions are
+  // skipped in order of increasing energy as long as the energy of all skipped
+  // partitions stays `kernel_pruning_threshold_db` below the energy of all
+  // SH-HRIRs. Trailing skipped partitions also shorten the input delay lines.
+  bool prune_kernels = false;
+  float kernel_pruning_threshold_db = -60.0f;
+
+  // Hybrid decoding in `ConvolutionMode::kUniformPartitioned` mode. Only the
+  // first `early_size` taps of each SH-HRIR are convolved per channel. The
+  // late reverb is rendered by a single non-uniformly partitioned convolution
+  // of the W channel with the remainder of its SH-HRIRs, scaled to the diffuse
+  // field energy of the tails of all channels. The tail fades in over the last
+  // `late_tail_crossfade_size` taps of the early part, which fades out.
+  bool shared_late_tail = false;
+  size_t early_size = 1024;
+  size_t late_tail_crossfade_size = 256;
+
+  // Storage precision of the SH-HRIR spectra and input histories in
+  // `ConvolutionMode::kUniformPartitioned` mode. Half precision halves the
+  // memory traffic of the multiply-accumulates, see `SpectrumPrecision`.
+  SpectrumPrecision spectrum_precision = SpectrumPrecision::kFloat;
+};
+
+/*!\brief Convolution work saved by kernel pruning, see
+ * `AmbisonicBinauralDecoderOptions::prune_kernels`.
+ */
+struct KernelPruningStats {
+  // Number of frequency domain kernel partitions over all channels and ears
+  // without pruning.
+  size_t num_partitions = 0;
+
+  // Number of kernel partitions which are not convolved.
+  size_t num_skipped_partitions = 0;
+
+  // Floating point operations of the frequency domain multiply-accumulates per
+  // buffer without pruning.
+  size_t flops_per_buffer = 0;
+
+  // Floating point operations per buffer saved by skipping partitions.
+  size_t saved_flops_per_buffer = 0;
+};
+
+/*!\brief Processing time of the convolution stages of one buffer in
+ * microseconds, see `AmbisonicBinauralDecoder::GetStageTimings`. Only measured
+ * in `ConvolutionMode::kUniformPartitioned` mode, without the shared late tail.
+ */
+struct DecoderStageTimings {
+  // Forward FFTs of the input channels, summed over all threads.
+  float forward_fft_us = 0.0f;
+
+  // Frequency domain multiply-accumulates, summed over all threads, and the
+  // summation of the per thread accumulators.
+  float multiply_accumulate_us = 0.0f;
+
+  // Inverse FFTs and overlap-add of both ears.
+  float inverse_fft_us = 0.0f;
+};
+
 /*!\brief Decodes an Ambisonic sound field, of an arbitrary order, to binaural
  * audio by performing convolution in the spherical harmonics domain.
  */
@@ -41,28 +147,186 @@ class AmbisonicBinauralDecoder {
                            const AudioBuffer& sh_hrirs_R,
                            size_t frames_per_buffer, FftManager* fft_manager);
 
+  /*!\brief Constructs an `AmbisonicBinauralDecoder` with the given options.
+   *
+   * \param sh_hrirs_L `AudioBuffer` containing time-domain spherical harmonic
+   * encoded left ear HRIR/BRIR filters.
+   * \param sh_hrirs_R `AudioBuffer` containing time-domain spherical harmonic
+   * encoded right ear HRIR/BRIR filters.
+   * \param frames_per_buffer Number of frames in each input/output buffer.
+   * \param fft_manager Pointer to a manager to perform FFT transformations.
+   * \param options Decoder options.
+   */
+  AmbisonicBinauralDecoder(const AudioBuffer& sh_hrirs_L,
+                           const AudioBuffer& sh_hrirs_R,
+                           size_t frames_per_buffer, FftManager* fft_manager,
+                           const AmbisonicBinauralDecoderOptions& options);
+
+  /*!\brief Constructs an `AmbisonicBinauralDecoder` in
+   * `ConvolutionMode::kUniformPartitioned` mode from precomputed partitioned
+   * frequency domain SH-HRIRs, e.g. loaded from a `KernelCache` or shared
+   * through the `KernelRegistry`. The SH-HRIRs are not copied but referenced by
+   * the filters, so decoders with the same SH-HRIRs only hold their own delay
+   * lines and accumulators. Symmetric decoding, kernel pruning and the shared
+   * late tail are not supported, as they need the time domain SH-HRIRs.
+   *
+   * \param sh_hrir_spectra_L Read-only left ear SH-HRIRs partitioned into
+   *        blocks of `frames_per_buffer`, see
+   *        `ComputePartitionedFreqDomainKernels`.
+   * \param sh_hrir_spectra_R Read-only right ear SH-HRIRs partitioned into
+   *        blocks of `frames_per_buffer`.
+   * \param frames_per_buffer Number of frames in each input/output buffer.
+   * \param fft_manager Pointer to a manager to perform FFT transformations.
+   * \param options Decoder options.
+   */
+  AmbisonicBinauralDecoder(
+      std::shared_ptr<const PartitionedFreqDomainKernels> sh_hrir_spectra_L,
+      std::shared_ptr<const PartitionedFreqDomainKernels> sh_hrir_spectra_R,
+      size_t frames_per_buffer, FftManager* fft_manager,
+      const AmbisonicBinauralDecoderOptions& options);
+
   /*!\brief Processes an Ambisonic sound field input and outputs a binaurally
-   * decoded 2-channel buffer.
+   * decoded 2-channel buffer. Disabled input channels are treated as silence
+   * and not read. The convolutions of silent channels are skipped once their
+   * filter histories have decayed.
    *
    * \param input Input buffer to be processed.
    * \param output Pointer to a 2-channel output buffer.
    */
   void ProcessAudioBuffer(const AudioBuffer& input, AudioBuffer* output);
 
+  /*!\brief Returns the convolution work saved by kernel pruning. All counts are
+   * zero in modes other than `ConvolutionMode::kUniformPartitioned`.
+   *
+   * \return Kernel pruning statistics.
+   */
+  const KernelPruningStats& GetKernelPruningStats() const {
+    return kernel_pruning_stats_;
+  }
+
+  /*!\brief Returns the processing time of the convolution stages of the last
+   * `ProcessAudioBuffer()` call. All times are zero in modes other than
+   * `ConvolutionMode::kUniformPartitioned`, or if `OBR_DISABLE_STATS` is
+   * defined.
+   *
+   * \return Stage timings of the last buffer.
+   */
+  const DecoderStageTimings& GetStageTimings() const { return stage_timings_; }
+
  private:
+  // Contiguous range of spherical harmonic channels filtered by one thread,
+  // together with the FFT manager and scratch buffers used by that thread.
+  struct ChannelGroup {
+    ChannelGroup(size_t begin_channel, size_t end_channel,
+                 FftManager* fft_manager, size_t frames_per_buffer);
+
+    // Range of channels `[begin_channel, end_channel)`.
+    const size_t begin_channel;
+    const size_t end_channel;
+
+    // FFT manager owned by the group. Null for the first group, which uses the
+    // decoder's `fft_manager_`.
+    std::unique_ptr<FftManager> owned_fft_manager;
+
+    // Manager for the FFTs of the group.
+    FftManager* const fft_manager;
+
+    // Frequency domain representation of one input channel.
+    PartitionedFftFilter::FreqDomainBuffer freq_input;
+
+    // Frequency domain accumulators holding the sum of the filter outputs of
+    // the group's channels, one channel per ear. With symmetric SH-HRIRs, the
+    // channels hold the sums over the symmetric (m >= 0) and antisymmetric
+    // (m < 0) harmonics instead.
+    PartitionedFftFilter::FreqDomainBuffer freq_domain_accumulator;
+
+    // Processing time of the group in the last buffer.
+    DecoderStageTimings stage_timings;
+  };
+
+  /*!\brief Splits the channels into one group per thread and starts the
+   * worker threads.
+   *
+   * \param num_channels Number of spherical harmonic channels.
+   * \param frames_per_buffer Number of frames in each input/output buffer.
+   * \param num_threads Number of threads, including the calling thread.
+   */
+  void InitializeChannelGroups(size_t num_channels, size_t frames_per_buffer,
+                               size_t num_threads);
+
+  /*!\brief Filters the channels of a group and accumulates the results in the
+   * group's frequency domain accumulators.
+   *
+   * \param input Input buffer to be processed.
+   * \param group Channel group to process.
+   */
+  void FilterChannelGroup(const AudioBuffer& input, ChannelGroup* group);
+
+  /*!\brief Returns the input with its disabled channels replaced by silence,
+   * for the filters which read all channels.
+   *
+   * \param input Input buffer to be processed.
+   * \return `input` if all its channels are enabled, `dense_input_` otherwise.
+   */
+  const AudioBuffer& GetDenseInput(const AudioBuffer& input);
+
   // Manager for all FFT related functionality (not owned).
   FftManager* const fft_manager_;
 
-  // Spherical Harmonic HRIR filter kernels.
-  std::vector<std::unique_ptr<PartitionedFftFilter>> sh_hrir_filters_L_,
-      sh_hrir_filters_R_;
+  // Spherical Harmonic HRIR filter kernels. Each filter holds the left and
+  // right ear kernels of one spherical harmonic channel.
+  std::vector<std::unique_ptr<StereoPartitionedFftFilter>> sh_hrir_filters_;
+
+  // Left ear Spherical Harmonic HRIR filter kernels replacing
+  // `sh_hrir_filters_` when decoding with symmetric SH-HRIRs.
+  std::vector<std::unique_ptr<PartitionedFftFilter>> symmetric_sh_hrir_filters_;
+
+  // Non-uniformly partitioned filter replacing `sh_hrir_filters_` in
+  // `ConvolutionMode::kNonUniformPartitioned` mode. Convolves the tail
+  // following `head_filter_` in `ConvolutionMode::kTimeDomainHead` mode.
+  std::unique_ptr<NonUniformPartitionedFftFilter> non_uniform_filter_;
+
+  // Filter rendering the shared late tail from the W channel when decoding
+  // with `AmbisonicBinauralDecoderOptions::shared_late_tail`.
+  std::unique_ptr<NonUniformPartitionedFftFilter> late_tail_filter_;
+
+  // Mono buffer holding the W channel input of `late_tail_filter_`.
+  AudioBuffer late_tail_input_;
+
+  // Time domain filter for the kernel head in
+  // `ConvolutionMode::kTimeDomainHead` mode.
+  std::unique_ptr<DirectFormFirFilter> head_filter_;
+
+  // Copy of the input with silenced disabled channels, used in
+  // `ConvolutionMode::kNonUniformPartitioned` and
+  // `ConvolutionMode::kTimeDomainHead` mode.
+  AudioBuffer dense_input_;
+
+  // Temporary stereo buffer holding the output of `non_uniform_filter_` in
+  // `ConvolutionMode::kTimeDomainHead` mode, or of `late_tail_filter_`.
+  AudioBuffer tail_output_;
+
+  // Channel groups, one per thread. The accumulators of the first group hold
+  // the sum over all groups after each buffer.
+  std::vector<std::unique_ptr<ChannelGroup>> channel_groups_;
+
+  // Worker threads processing all but the first channel group. Null when
+  // running single threaded.
+  std::unique_ptr<ThreadPool> thread_pool_;
+
+  // Convolution work saved by kernel pruning.
+  KernelPruningStats kernel_pruning_stats_;
+
+  // Processing time of the last buffer.
+  DecoderStageTimings stage_timings_;
 
-  // Frequency domain representation of the input signal.
-  PartitionedFftFilter::FreqDomainBuffer freq_input_;
+  // Buffer selector to switch between two filtered signal buffers.
+  size_t buffer_selector_;
 
-  // Temporary audio buffer to store the convolution output for asymmetric or
-  // symmetric spherical harmonic HRIR.
-  AudioBuffer filtered_input_;
+  // Two buffers per ear that are consecutively filled with the inverse FFT of
+  // the accumulated spectra. Channel `2 * ear + buffer_selector_` holds the
+  // latest output.
+  AudioBuffer filtered_time_domain_buffers_;
 };
 
 }  // namespace obr
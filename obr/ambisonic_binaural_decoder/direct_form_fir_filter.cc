@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+// Prevent Visual Studio from complaining about std::copy_n.
+#if defined(_WIN32)
+#define _SCL_SECURE_NO_WARNINGS
+#endif
+
+#include "obr/ambisonic_binaural_decoder/direct_form_fir_filter.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "absl/log/check.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/audio_buffer/simd_utils.h"
+#include "obr/common/constants.h"
+
+namespace obr {
+
+DirectFormFirFilter::DirectFormFirFilter(const AudioBuffer& kernels_L,
+                                         const AudioBuffer& kernels_R,
+                                         size_t filter_size,
+                                         size_t frames_per_buffer)
+    : filter_size_(filter_size),
+      frames_per_buffer_(frames_per_buffer),
+      kernels_L_(kernels_L.num_channels(), filter_size_),
+      kernels_R_(kernels_R.num_channels(), filter_size_),
+      history_(kernels_L.num_channels(), filter_size_ - 1 + frames_per_buffer) {
+  CHECK_NE(filter_size_, 0U);
+  CHECK_NE(frames_per_buffer_, 0U);
+  CHECK_NE(kernels_L.num_channels(), 0U);
+  CHECK_EQ(kernels_R.num_channels(), kernels_L.num_channels());
+  CHECK_LE(filter_size_, kernels_L.num_frames());
+  CHECK_LE(filter_size_, kernels_R.num_frames());
+
+  for (size_t channel = 0; channel < kernels_L.num_channels(); ++channel) {
+    std::copy_n(kernels_L[channel].begin(), filter_size_,
+                kernels_L_[channel].begin());
+    std::copy_n(kernels_R[channel].begin(), filter_size_,
+                kernels_R_[channel].begin());
+  }
+  Clear();
+}
+
+void DirectFormFirFilter::Clear() { history_.Clear(); }
+
+void DirectFormFirFilter::Process(const AudioBuffer& input,
+                                  AudioBuffer* output) {
+  CHECK_EQ(input.num_channels(), history_.num_channels());
+  CHECK_EQ(input.num_frames(), frames_per_buffer_);
+  CHECK_NE(output, nullptr);
+  CHECK_EQ(output->num_frames(), frames_per_buffer_);
+  CHECK_EQ(output->num_channels(), kNumBinauralChannels);
+
+  output->Clear();
+  float* output_L = (*output)[0].begin();
+  float* output_R = (*output)[1].begin();
+  const size_t num_history_frames = filter_size_ - 1;
+  for (size_t channel = 0; channel < input.num_channels(); ++channel) {
+    auto& history_channel = history_[channel];
+    std::copy_n(input[channel].begin(), frames_per_buffer_,
+                history_channel.begin() + num_history_frames);
+
+    // Each tap scales the input delayed by the tap index and adds it to the
+    // output, which vectorizes over the frames of the buffer.
+    const float* current_input = history_channel.begin() + num_history_frames;
+    const auto& kernel_L = kernels_L_[channel];
+    const auto& kernel_R = kernels_R_[channel];
+    for (size_t tap = 0; tap < filter_size_; ++tap) {
+      ScalarMultiplyAndAccumulate(frames_per_buffer_, kernel_L[tap],
+                                  current_input - tap, output_L);
+      ScalarMultiplyAndAccumulate(frames_per_buffer_, kernel_R[tap],
+                                  current_input - tap, output_R);
+    }
+
+    // Keep the latest input frames for the next buffer.
+    std::copy(history_channel.end() - num_history_frames, history_channel.end(),
+              history_channel.begin());
+  }
+}
+
+}  // namespace obr
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#ifndef OBR_DIRECT_FORM_FIR_FILTER_H_
+#define OBR_DIRECT_FORM_FIR_FILTER_H_
+
+#include <cstddef>
+
+#include "obr/audio_buffer/audio_buffer.h"
+
+namespace obr {
+
+/*!\brief Class performing a time domain (direct form) FIR convolution of a
+ * multi-channel input with one pair of (left and right ear) kernels per input
+ * channel, summing all filtered channels into a stereo output.
+ *
+ * Intended for short kernels, e.g. the head of SH-HRIRs whose remainder is
+ * convolved by a `NonUniformPartitionedFftFilter`.
+ */
+class DirectFormFirFilter {
+ public:
+  /*!\brief Constructor preallocates memory.
+   *
+   * \param kernels_L Time domain left ear kernels, one channel per input
+   *        channel.
+   * \param kernels_R Time domain right ear kernels, one channel per input
+   *        channel.
+   * \param filter_size Number of leading kernel taps to convolve with. Must not
+   *        exceed the number of frames of the kernels.
+   * \param frames_per_buffer Number of frames in each input/output buffer.
+   */
+  DirectFormFirFilter(const AudioBuffer& kernels_L,
+                      const AudioBuffer& kernels_R, size_t filter_size,
+                      size_t frames_per_buffer);
+
+  /*!\brief Filters a block of multi-channel input and writes the sum of all
+   * filtered channels to a stereo output.
+   *
+   * \param input Input buffer with one channel per kernel pair and
+   *        `frames_per_buffer` frames.
+   * \param output Pointer to a 2-channel output buffer.
+   */
+  void Process(const AudioBuffer& input, AudioBuffer* output);
+
+  /*!\brief Resets the filter state.
+   */
+  void Clear();
+
+ private:
+  // Number of kernel taps.
+  const size_t filter_size_;
+
+  // Number of frames in each input/output buffer.
+  const size_t frames_per_buffer_;
+
+  // Left and right ear kernels, one channel per input channel.
+  AudioBuffer kernels_L_, kernels_R_;
+
+  // Input history, one channel per input channel. Holds the last
+  // `filter_size_ - 1` input frames followed by the current input buffer.
+  AudioBuffer history_;
+};
+
+}  // namespace obr
+
+#endif  // OBR_DIRECT_FORM_FIR_FILTER_H_
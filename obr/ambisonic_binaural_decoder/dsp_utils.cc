@@ -11,13 +11,23 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 
 #include "absl/log/check.h"
 #include "obr/audio_buffer/audio_buffer.h"
+#include "obr/audio_buffer/simd_utils.h"
 #include "obr/common/constants.h"
 
 namespace obr {
 
+namespace {
+
+// Limits the exponent of the gains applied before half precision conversion,
+// so that the product of two gains and its inverse remain normal floats.
+const int kMaxHalfGainExponent = 60;
+
+}  // namespace
+
 size_t CeilToMultipleOfFramesPerBuffer(size_t size, size_t frames_per_buffer) {
   DCHECK_NE(frames_per_buffer, 0U);
   const size_t remainder = size % frames_per_buffer;
@@ -41,4 +51,36 @@ void GenerateHannWindow(bool full_window, size_t window_length,
   }
 }
 
+void OverlapAdd(const AudioBuffer::Channel& curr_block,
+                const AudioBuffer::Channel& prev_block,
+                AudioBuffer::Channel* output) {
+  DCHECK_NE(output, nullptr);
+  DCHECK_EQ(curr_block.size(), prev_block.size());
+  const size_t hop_size = output->size();
+  DCHECK_LE(2 * hop_size, curr_block.size());
+
+  // For non power of two hop sizes the previous block is read from an
+  // unaligned offset, which `AddPointwise` handles with unaligned loads.
+  AddPointwise(hop_size, curr_block.begin(), prev_block.begin() + hop_size,
+               output->begin());
+}
+
+float HalfFromFreqDomainChannel(const AudioBuffer::Channel& input,
+                                uint16_t* output) {
+  DCHECK_NE(output, nullptr);
+  float max_magnitude = 0.0f;
+  for (const float value : input) {
+    max_magnitude = std::max(max_magnitude, std::abs(value));
+  }
+  float gain = 1.0f;
+  if (max_magnitude > 0.0f) {
+    int exponent;
+    std::frexp(max_magnitude, &exponent);
+    gain = std::ldexp(1.0f, std::clamp(15 - exponent, -kMaxHalfGainExponent,
+                                       kMaxHalfGainExponent));
+  }
+  HalfFromFloat(input.size(), gain, input.begin(), output);
+  return gain;
+}
+
 }  // namespace obr
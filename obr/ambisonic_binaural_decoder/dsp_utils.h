@@ -10,6 +10,7 @@
 #define OBR_DSP_UTILS_H_
 
 #include <cstddef>
+#include <cstdint>
 
 #include "obr/audio_buffer/audio_buffer.h"
 
@@ -36,6 +37,31 @@ size_t CeilToMultipleOfFramesPerBuffer(size_t size, size_t frames_per_buffer);
 void GenerateHannWindow(bool full_window, size_t window_length,
                         AudioBuffer::Channel* buffer);
 
+/*!\brief Overlap-adds two consecutive time domain blocks of an FFT-based
+ * convolution. The first `output->size()` frames of `curr_block` are added to
+ * the `output->size()` frames following the hop in `prev_block`.
+ *
+ * \param curr_block Time domain block produced by the latest inverse FFT.
+ * \param prev_block Time domain block produced by the previous inverse FFT.
+ * \param output Output block, its size defines the hop size in frames. Must
+ *        not exceed half of the block size.
+ */
+void OverlapAdd(const AudioBuffer::Channel& curr_block,
+                const AudioBuffer::Channel& prev_block,
+                AudioBuffer::Channel* output);
+
+/*!\brief Converts a frequency domain channel to half precision. The channel is
+ * scaled by a power of two such that its largest magnitude lies in [2^14,
+ * 2^15), which keeps the full half precision resolution for spectra of any
+ * level and avoids overflows.
+ *
+ * \param input Frequency domain channel.
+ * \param output Half precision output, `input.size()` values long.
+ * \return Gain applied to `input` before the conversion.
+ */
+float HalfFromFreqDomainChannel(const AudioBuffer::Channel& input,
+                                uint16_t* output);
+
 }  // namespace obr
 
 #endif  // OBR_DSP_UTILS_H_
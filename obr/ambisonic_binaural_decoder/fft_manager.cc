@@ -15,9 +15,15 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <memory>
 
+#include "absl/base/attributes.h"
+#include "absl/base/const_init.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
+#include "absl/synchronization/mutex.h"
 #include "obr/audio_buffer/audio_buffer.h"
 #include "obr/audio_buffer/simd_utils.h"
 #include "obr/common/constants.h"
@@ -32,17 +38,77 @@ namespace {
 // the author of the pffft library.
 const size_t kPffftMaxStackSize = 16384;
 
+// Returns the pffft setup for real FFTs of `fft_size` points. Setups hold the
+// twiddle factors only and may be used by several threads at once, so one
+// setup per FFT size is shared by all managers in the process. It is destroyed
+// once the last manager using it is gone.
+std::shared_ptr<PFFFT_Setup> GetSharedPffftSetup(size_t fft_size) {
+  ABSL_CONST_INIT static absl::Mutex mutex(absl::kConstInit);
+  static auto* const setups =
+      new absl::flat_hash_map<size_t, std::weak_ptr<PFFFT_Setup>>();
+  absl::MutexLock lock(&mutex);
+  std::weak_ptr<PFFFT_Setup>& weak_setup = (*setups)[fft_size];
+  std::shared_ptr<PFFFT_Setup> setup = weak_setup.lock();
+  if (setup == nullptr) {
+    setup = std::shared_ptr<PFFFT_Setup>(
+        pffft_new_setup(static_cast<int>(fft_size), PFFFT_REAL),
+        pffft_destroy_setup);
+    weak_setup = setup;
+  }
+  return setup;
+}
+
+// Returns true if pffft stores spectra in blocks of SIMD vectors, alternating
+// real and imaginary parts, which the fused half precision kernels expect.
+bool HasSimdSpectrumLayout() {
+  return GetSimdLength() > 1 &&
+         static_cast<size_t>(pffft_simd_size()) == GetSimdLength();
+}
+
+inline float GetValue(const float* input, size_t index) {
+  return input[index];
+}
+
+inline float GetValue(const uint16_t* input, size_t index) {
+  float value;
+  FloatFromHalf(1, input + index, &value);
+  return value;
+}
+
+// Equivalent of `pffft_zconvolve_accumulate` with a half precision `input_b`.
+// The DC and Nyquist bins are real and stored at the start of the first real
+// and imaginary blocks, so they are multiplied separately.
+template <typename InputType>
+void HalfZconvolveAccumulate(size_t fft_size, const InputType* input_a,
+                             const uint16_t* input_b, float scale,
+                             float* output) {
+  const size_t nyquist_index = GetSimdLength();
+  const float dc =
+      output[0] + scale * GetValue(input_a, 0) * GetValue(input_b, 0);
+  const float nyquist =
+      output[nyquist_index] + scale * GetValue(input_a, nyquist_index) *
+                                  GetValue(input_b, nyquist_index);
+  ComplexMultiplyAndAccumulateHalf(fft_size, scale, input_a, input_b, output);
+  output[0] = dc;
+  output[nyquist_index] = nyquist;
+}
+
 }  // namespace
 
 // The pffft implementation requires a minimum fft size of 32 samples.
 const size_t FftManager::kMinFftSize = 32;
 
+size_t FftManager::GetSimdSize() {
+  return static_cast<size_t>(pffft_simd_size());
+}
+
 FftManager::FftManager(size_t frames_per_buffer)
     : fft_size_(std::max(NextPowTwo(frames_per_buffer) * 2, kMinFftSize)),
       frames_per_buffer_(frames_per_buffer),
       inverse_fft_scale_(1.0f / static_cast<float>(fft_size_)),
       temp_zeropad_buffer_(kNumMonoChannels, fft_size_),
-      temp_freq_buffer_(kNumMonoChannels, fft_size_) {
+      temp_freq_buffer_(kNumMonoChannels, fft_size_),
+      temp_widened_buffer_(kNumStereoChannels, fft_size_) {
   DCHECK_GT(frames_per_buffer, 0U);
   DCHECK_GE(fft_size_, kMinFftSize);
   DCHECK(!(fft_size_ & (fft_size_ - 1)));  // Ensure it is a power of two.
@@ -54,13 +120,12 @@ FftManager::FftManager(size_t frames_per_buffer)
         reinterpret_cast<float*>(pffft_aligned_malloc(num_bytes));
   }
 
-  fft_ = pffft_new_setup(static_cast<int>(fft_size_), PFFFT_REAL);
+  fft_ = GetSharedPffftSetup(fft_size_);
 
   temp_zeropad_buffer_.Clear();
 }
 
 FftManager::~FftManager() {
-  pffft_destroy_setup(fft_);
   if (pffft_workspace_ != nullptr) {
     pffft_aligned_free(pffft_workspace_);
   }
@@ -74,12 +139,12 @@ void FftManager::FreqFromTimeDomain(const AudioBuffer::Channel& time_channel,
 
   // Perform forward FFT transform.
   if (time_channel.size() == fft_size_) {
-    pffft_transform(fft_, time_channel.begin(), freq_channel->begin(),
+    pffft_transform(fft_.get(), time_channel.begin(), freq_channel->begin(),
                     pffft_workspace_, PFFFT_FORWARD);
   } else {
     std::copy_n(time_channel.begin(), frames_per_buffer_,
                 temp_zeropad_buffer_[0].begin());
-    pffft_transform(fft_, temp_zeropad_buffer_[0].begin(),
+    pffft_transform(fft_.get(), temp_zeropad_buffer_[0].begin(),
                     freq_channel->begin(), pffft_workspace_, PFFFT_FORWARD);
   }
 }
@@ -92,12 +157,12 @@ void FftManager::TimeFromFreqDomain(const AudioBuffer::Channel& freq_channel,
   // Perform reverse FFT transform.
   const size_t time_channel_size = time_channel->size();
   if (time_channel_size == fft_size_) {
-    pffft_transform(fft_, freq_channel.begin(), time_channel->begin(),
+    pffft_transform(fft_.get(), freq_channel.begin(), time_channel->begin(),
                     pffft_workspace_, PFFFT_BACKWARD);
   } else {
     DCHECK_EQ(time_channel_size, frames_per_buffer_);
     auto& temp_channel = temp_freq_buffer_[0];
-    pffft_transform(fft_, freq_channel.begin(), temp_channel.begin(),
+    pffft_transform(fft_.get(), freq_channel.begin(), temp_channel.begin(),
                     pffft_workspace_, PFFFT_BACKWARD);
     std::copy_n(temp_channel.begin(), frames_per_buffer_,
                 time_channel->begin());
@@ -117,14 +182,14 @@ void FftManager::GetCanonicalFormatFreqBuffer(const AudioBuffer::Channel& input,
                                               AudioBuffer::Channel* output) {
   DCHECK_EQ(input.size(), fft_size_);
   DCHECK_EQ(output->size(), fft_size_);
-  pffft_zreorder(fft_, input.begin(), output->begin(), PFFFT_FORWARD);
+  pffft_zreorder(fft_.get(), input.begin(), output->begin(), PFFFT_FORWARD);
 }
 
 void FftManager::GetPffftFormatFreqBuffer(const AudioBuffer::Channel& input,
                                           AudioBuffer::Channel* output) {
   DCHECK_EQ(input.size(), fft_size_);
   DCHECK_EQ(output->size(), fft_size_);
-  pffft_zreorder(fft_, input.begin(), output->begin(), PFFFT_BACKWARD);
+  pffft_zreorder(fft_.get(), input.begin(), output->begin(), PFFFT_BACKWARD);
 }
 
 void FftManager::MagnitudeFromCanonicalFreqBuffer(
@@ -193,8 +258,46 @@ void FftManager::FreqDomainConvolution(const AudioBuffer::Channel& input_a,
   DCHECK_EQ(input_a.size(), fft_size_);
   DCHECK_EQ(input_b.size(), fft_size_);
   DCHECK_EQ(scaled_output->size(), fft_size_);
-  pffft_zconvolve_accumulate(fft_, input_a.begin(), input_b.begin(),
+  pffft_zconvolve_accumulate(fft_.get(), input_a.begin(), input_b.begin(),
                              scaled_output->begin(), inverse_fft_scale_);
 }
 
+void FftManager::FreqDomainConvolution(const AudioBuffer::Channel& input_a,
+                                       const uint16_t* input_b, float gain,
+                                       AudioBuffer::Channel* scaled_output) {
+  DCHECK_EQ(input_a.size(), fft_size_);
+  DCHECK_NE(input_b, nullptr);
+  DCHECK_EQ(scaled_output->size(), fft_size_);
+  if (HasSimdSpectrumLayout()) {
+    HalfZconvolveAccumulate(fft_size_, input_a.begin(), input_b,
+                            gain * inverse_fft_scale_, scaled_output->begin());
+    return;
+  }
+  auto& widened_b = temp_widened_buffer_[1];
+  FloatFromHalf(fft_size_, input_b, widened_b.begin());
+  pffft_zconvolve_accumulate(fft_.get(), input_a.begin(), widened_b.begin(),
+                             scaled_output->begin(),
+                             gain * inverse_fft_scale_);
+}
+
+void FftManager::FreqDomainConvolution(const uint16_t* input_a,
+                                       const uint16_t* input_b, float gain,
+                                       AudioBuffer::Channel* scaled_output) {
+  DCHECK_NE(input_a, nullptr);
+  DCHECK_NE(input_b, nullptr);
+  DCHECK_EQ(scaled_output->size(), fft_size_);
+  if (HasSimdSpectrumLayout()) {
+    HalfZconvolveAccumulate(fft_size_, input_a, input_b,
+                            gain * inverse_fft_scale_, scaled_output->begin());
+    return;
+  }
+  auto& widened_a = temp_widened_buffer_[0];
+  auto& widened_b = temp_widened_buffer_[1];
+  FloatFromHalf(fft_size_, input_a, widened_a.begin());
+  FloatFromHalf(fft_size_, input_b, widened_b.begin());
+  pffft_zconvolve_accumulate(fft_.get(), widened_a.begin(), widened_b.begin(),
+                             scaled_output->begin(),
+                             gain * inverse_fft_scale_);
+}
+
 }  // namespace obr
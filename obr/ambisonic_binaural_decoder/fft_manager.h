@@ -10,6 +10,8 @@
 #define OBR_FFT_MANAGER_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 
 #include "obr/audio_buffer/audio_buffer.h"
 #include "pffft.h"
@@ -156,9 +158,45 @@ class FftManager {
                              const AudioBuffer::Channel& input_b,
                              AudioBuffer::Channel* scaled_output);
 
+  /*!\brief Performs a pointwise complex multiplication of a frequency domain
+   * buffer and a half precision frequency domain buffer, see
+   * `HalfFromFreqDomainChannel`, and accumulates the product scaled by
+   * `gain`/`fft_size_`.
+   *
+   * \param input_a Frequency domain input channel, `fft_size` samples long.
+   * \param input_b Aligned half precision frequency domain input, `fft_size`
+   *        values long.
+   * \param gain Gain applied to the product, e.g. to undo the scaling of
+   *        `input_b`.
+   * \param scaled_output Frequency domain output channel, `fft_size` samples
+   *        long.
+   */
+  void FreqDomainConvolution(const AudioBuffer::Channel& input_a,
+                             const uint16_t* input_b, float gain,
+                             AudioBuffer::Channel* scaled_output);
+
+  /*!\brief Performs a pointwise complex multiplication of two half precision
+   * frequency domain buffers and accumulates the product scaled by
+   * `gain`/`fft_size_`.
+   *
+   * \param input_a Aligned half precision frequency domain input, `fft_size`
+   *        values long.
+   * \param input_b Aligned half precision frequency domain input, `fft_size`
+   *        values long.
+   * \param gain Gain applied to the product.
+   * \param scaled_output Frequency domain output channel, `fft_size` samples
+   *        long.
+   */
+  void FreqDomainConvolution(const uint16_t* input_a, const uint16_t* input_b,
+                             float gain, AudioBuffer::Channel* scaled_output);
+
   // Returns the number of points in the FFT.
   size_t GetFftSize() const { return fft_size_; }
 
+  // Returns the number of floats per SIMD vector of pffft, which determines
+  // the order of the frequency bins in the pffft format.
+  static size_t GetSimdSize();
+
  private:
   // FFT size in samples.
   const size_t fft_size_;
@@ -176,8 +214,13 @@ class FftManager {
   // Temporary freq domain buffer to store.
   AudioBuffer temp_freq_buffer_;
 
-  // pffft states.
-  PFFFT_Setup* fft_;
+  // Temporary freq domain buffers to widen half precision inputs into where
+  // pffft does not use the SIMD spectrum layout.
+  AudioBuffer temp_widened_buffer_;
+
+  // pffft states. The setup is read-only once created and shared by all
+  // managers with the same FFT size.
+  std::shared_ptr<PFFFT_Setup> fft_;
 
   // Workspace for pffft. This pointer should be set to null for `fft_size_`
   // less than 2^14. In which case the stack is used. This is the recommendation
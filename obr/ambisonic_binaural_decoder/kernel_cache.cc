@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/ambisonic_binaural_decoder/kernel_cache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "obr/ambisonic_binaural_decoder/dsp_utils.h"
+#include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/partitioned_fft_filter.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
+
+namespace obr {
+
+namespace {
+
+// Identifies kernel cache files and their layout.
+const char kMagic[4] = {'O', 'B', 'R', 'K'};
+const uint32_t kVersion = 2;
+
+// Written in native byte order, so it reads differently on machines of the
+// other byte order.
+const uint32_t kByteOrderMark = 0x01020304;
+
+// Header of a kernel cache file, followed by the kernels as native floats in
+// channel, partition, frequency bin order.
+struct KernelCacheHeader {
+  char magic[4];
+  uint32_t byte_order_mark;
+  uint32_t version;
+  int32_t ambisonic_order;
+  uint32_t ear;
+  int32_t sampling_rate;
+  uint32_t frames_per_buffer;
+  uint32_t fft_simd_size;
+  uint64_t asset_hash;
+  uint32_t fft_size;
+  uint32_t num_channels;
+  uint32_t num_partitions;
+  // Keeps the kernel data 16 byte aligned.
+  uint32_t padding[3];
+};
+static_assert(sizeof(KernelCacheHeader) == 64);
+
+}  // namespace
+
+uint64_t ComputeKernelAssetHash(absl::string_view asset_data) {
+  uint64_t hash = 14695981039346656037ull;
+  for (const char byte : asset_data) {
+    hash ^= static_cast<uint8_t>(byte);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+PartitionedFreqDomainKernels ComputePartitionedFreqDomainKernels(
+    const AudioBuffer& kernels, size_t frames_per_buffer,
+    FftManager* fft_manager) {
+  DCHECK_NE(fft_manager, nullptr);
+  const size_t num_frames = kernels.num_frames();
+  const size_t num_partitions =
+      CeilToMultipleOfFramesPerBuffer(num_frames, frames_per_buffer) /
+      frames_per_buffer;
+  AudioBuffer padded_chunk(kNumMonoChannels, frames_per_buffer);
+
+  PartitionedFreqDomainKernels freq_domain_kernels;
+  freq_domain_kernels.reserve(kernels.num_channels());
+  for (size_t channel = 0; channel < kernels.num_channels(); ++channel) {
+    freq_domain_kernels.emplace_back(num_partitions,
+                                     fft_manager->GetFftSize());
+    for (size_t partition = 0; partition < num_partitions; ++partition) {
+      const size_t chunk_begin = partition * frames_per_buffer;
+      const size_t num_frames_to_copy =
+          std::min(frames_per_buffer, num_frames - chunk_begin);
+      std::copy_n(kernels[channel].begin() + chunk_begin, num_frames_to_copy,
+                  padded_chunk[0].begin());
+      std::fill(padded_chunk[0].begin() + num_frames_to_copy,
+                padded_chunk[0].end(), 0.0f);
+      fft_manager->FreqFromTimeDomain(
+          padded_chunk[0], &freq_domain_kernels.back()[partition]);
+    }
+  }
+  return freq_domain_kernels;
+}
+
+KernelCache::KernelCache(const std::string& directory)
+    : directory_(directory) {}
+
+std::string KernelCache::GetFilePath(const KernelCacheKey& key) const {
+  const std::string file_name = absl::StrCat(
+      "obr_kernels_", key.ambisonic_order, "oa_", key.ear == 0 ? "l" : "r",
+      "_", key.sampling_rate, "hz_", key.frames_per_buffer, "_simd",
+      key.fft_simd_size,
+      std::endian::native == std::endian::little ? "_le_" : "_be_",
+      absl::Hex(key.asset_hash, absl::kZeroPad16), ".bin");
+  return (std::filesystem::path(directory_) / file_name).string();
+}
+
+absl::StatusOr<PartitionedFreqDomainKernels> KernelCache::Load(
+    const KernelCacheKey& key, size_t fft_size) const {
+  const std::string path = GetFilePath(key);
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream) {
+    return absl::NotFoundError(absl::StrCat("Cannot open ", path));
+  }
+  std::error_code error;
+  const uintmax_t size = std::filesystem::file_size(path, error);
+  if (error) {
+    return absl::InternalError(absl::StrCat("Cannot get size of ", path));
+  }
+
+  KernelCacheHeader header;
+  if (size < sizeof(header) ||
+      !stream.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    return absl::DataLossError(absl::StrCat("Truncated header in ", path));
+  }
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    return absl::DataLossError(absl::StrCat("Unknown file format in ", path));
+  }
+  if (header.byte_order_mark != kByteOrderMark) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("Cache entry of another byte order in ", path));
+  }
+  if (header.version != kVersion) {
+    return absl::DataLossError(absl::StrCat("Unknown file format in ", path));
+  }
+  if (header.ambisonic_order != key.ambisonic_order || header.ear != key.ear ||
+      header.sampling_rate != key.sampling_rate ||
+      header.frames_per_buffer != key.frames_per_buffer ||
+      header.asset_hash != key.asset_hash || header.fft_size != fft_size ||
+      header.fft_simd_size != key.fft_simd_size) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("Mismatching cache entry in ", path));
+  }
+  const size_t num_floats = static_cast<size_t>(header.num_channels) *
+                            header.num_partitions * header.fft_size;
+  if (size != sizeof(header) + num_floats * sizeof(float)) {
+    return absl::DataLossError(absl::StrCat("Truncated kernels in ", path));
+  }
+
+  // The partitions are read straight into the kernel buffers.
+  PartitionedFreqDomainKernels kernels;
+  kernels.reserve(header.num_channels);
+  for (size_t channel = 0; channel < header.num_channels; ++channel) {
+    kernels.emplace_back(header.num_partitions, fft_size);
+    for (size_t partition = 0; partition < header.num_partitions;
+         ++partition) {
+      stream.read(reinterpret_cast<char*>(kernels.back()[partition].begin()),
+                  fft_size * sizeof(float));
+    }
+  }
+  if (!stream) {
+    return absl::DataLossError(absl::StrCat("Cannot read kernels from ", path));
+  }
+  return kernels;
+}
+
+absl::Status KernelCache::Store(
+    const KernelCacheKey& key,
+    const PartitionedFreqDomainKernels& kernels) const {
+  if (kernels.empty()) {
+    return absl::InvalidArgumentError("No kernels to store");
+  }
+  KernelCacheHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.byte_order_mark = kByteOrderMark;
+  header.version = kVersion;
+  header.ambisonic_order = key.ambisonic_order;
+  header.ear = static_cast<uint32_t>(key.ear);
+  header.sampling_rate = key.sampling_rate;
+  header.frames_per_buffer = static_cast<uint32_t>(key.frames_per_buffer);
+  header.asset_hash = key.asset_hash;
+  header.fft_size = static_cast<uint32_t>(kernels[0].num_frames());
+  header.num_channels = static_cast<uint32_t>(kernels.size());
+  header.num_partitions = static_cast<uint32_t>(kernels[0].num_channels());
+  header.fft_simd_size = static_cast<uint32_t>(key.fft_simd_size);
+  std::fill(std::begin(header.padding), std::end(header.padding), 0);
+
+  // Write to a uniquely named temporary file first, so that readers only ever
+  // see complete entries.
+  const std::string path = GetFilePath(key);
+  const std::string temp_path =
+      absl::StrCat(path, ".", std::random_device()(), ".tmp");
+  std::error_code error;
+  {
+    std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+      return absl::PermissionDeniedError(
+          absl::StrCat("Cannot create ", temp_path));
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& kernel : kernels) {
+      if (kernel.num_channels() != header.num_partitions ||
+          kernel.num_frames() != header.fft_size) {
+        stream.close();
+        std::filesystem::remove(temp_path, error);
+        return absl::InvalidArgumentError("Mismatching kernel sizes");
+      }
+      for (size_t partition = 0; partition < kernel.num_channels();
+           ++partition) {
+        stream.write(reinterpret_cast<const char*>(kernel[partition].begin()),
+                     kernel.num_frames() * sizeof(float));
+      }
+    }
+    if (!stream) {
+      stream.close();
+      std::filesystem::remove(temp_path, error);
+      return absl::InternalError(absl::StrCat("Cannot write ", temp_path));
+    }
+  }
+
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    std::filesystem::remove(temp_path, error);
+    return absl::InternalError(absl::StrCat("Cannot rename to ", path));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace obr
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#ifndef OBR_KERNEL_CACHE_H_
+#define OBR_KERNEL_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/partitioned_fft_filter.h"
+#include "obr/audio_buffer/audio_buffer.h"
+
+namespace obr {
+
+/*!\brief Partitioned frequency domain kernels, one `FreqDomainBuffer` per
+ * spherical harmonic channel with one channel per partition, as accepted by
+ * `PartitionedFftFilter::SetFreqDomainKernel`.
+ */
+typedef std::vector<PartitionedFftFilter::FreqDomainBuffer>
+    PartitionedFreqDomainKernels;
+
+/*!\brief Identifies one ear's set of partitioned frequency domain SH-HRIRs. */
+struct KernelCacheKey {
+  // Ambisonic order of the SH-HRIRs.
+  int ambisonic_order = 0;
+
+  // Ear of the SH-HRIRs, 0 for left and 1 for right.
+  size_t ear = 0;
+
+  // Sampling rate the SH-HRIRs were resampled to.
+  int sampling_rate = 0;
+
+  // Frames per buffer, which determines the partition and FFT size.
+  size_t frames_per_buffer = 0;
+
+  // Hash of the SH-HRIR asset, see `ComputeKernelAssetHash`.
+  uint64_t asset_hash = 0;
+
+  // SIMD size of the FFT, which determines the order of the frequency bins.
+  size_t fft_simd_size = FftManager::GetSimdSize();
+};
+
+/*!\brief Computes a hash of an SH-HRIR asset, which is stable across runs and
+ * platforms (64-bit FNV-1a).
+ *
+ * \param asset_data Raw asset data.
+ * \return Hash of the asset.
+ */
+uint64_t ComputeKernelAssetHash(absl::string_view asset_data);
+
+/*!\brief Splits time domain kernels into partitions of `frames_per_buffer`
+ * frames and transforms each partition to the frequency domain.
+ *
+ * \param kernels Time domain kernels, one channel per spherical harmonic.
+ * \param frames_per_buffer Number of frames in each input/output buffer.
+ * \param fft_manager Pointer to a manager to perform FFT transformations.
+ * \return Partitioned frequency domain kernels.
+ */
+PartitionedFreqDomainKernels ComputePartitionedFreqDomainKernels(
+    const AudioBuffer& kernels, size_t frames_per_buffer,
+    FftManager* fft_manager);
+
+/*!\brief Persistent on-disk cache of partitioned frequency domain SH-HRIRs.
+ *
+ * Each entry is stored in its own file named after the `KernelCacheKey` and the
+ * native byte order, as the spectra are stored as native floats. Files are
+ * read straight into the kernel buffers, and written to a temporary file which
+ * is then renamed, so concurrent readers never see partial entries.
+ */
+class KernelCache {
+ public:
+  /*!\brief Constructs a cache storing its files in `directory`.
+   *
+   * \param directory Existing directory for the cache files.
+   */
+  explicit KernelCache(const std::string& directory);
+
+  /*!\brief Returns the path of the cache file for a key.
+   *
+   * \param key Cache key.
+   * \return Path of the cache file.
+   */
+  std::string GetFilePath(const KernelCacheKey& key) const;
+
+  /*!\brief Loads the kernels stored for a key.
+   *
+   * \param key Cache key.
+   * \param fft_size Expected FFT size of the kernels.
+   * \return Partitioned frequency domain kernels. `absl::NotFoundError` if
+   *         there is no entry for the key, or a specific status if the entry
+   *         is invalid.
+   */
+  absl::StatusOr<PartitionedFreqDomainKernels> Load(const KernelCacheKey& key,
+                                                    size_t fft_size) const;
+
+  /*!\brief Stores kernels for a key, replacing any existing entry.
+   *
+   * \param key Cache key.
+   * \param kernels Partitioned frequency domain kernels. All channels must
+   *        have the same number of partitions and FFT size.
+   * \return `absl::OkStatus()` if successful. A specific status on failure.
+   */
+  absl::Status Store(const KernelCacheKey& key,
+                     const PartitionedFreqDomainKernels& kernels) const;
+
+ private:
+  // Directory holding the cache files.
+  const std::string directory_;
+};
+
+}  // namespace obr
+
+#endif  // OBR_KERNEL_CACHE_H_
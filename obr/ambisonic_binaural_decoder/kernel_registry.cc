@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/ambisonic_binaural_decoder/kernel_registry.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+
+namespace obr {
+
+KernelRegistry& KernelRegistry::GetInstance() {
+  static KernelRegistry* const registry = new KernelRegistry();
+  return *registry;
+}
+
+absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>>
+KernelRegistry::GetOrCreate(
+    int ambisonic_order, int sampling_rate, size_t frames_per_buffer,
+    absl::FunctionRef<absl::StatusOr<ShHrirKernelSet>()> create_kernel_set) {
+  const Key key(ambisonic_order, sampling_rate, frames_per_buffer);
+  {
+    absl::MutexLock lock(&mutex_);
+    absl::erase_if(kernel_sets_, [](const auto& entry) {
+      return !entry.second.creating && entry.second.kernel_set.expired();
+    });
+
+    // Wait for a concurrent creation of the same kernel set to finish.
+    while (IsBeingCreated(key)) {
+      creation_finished_.Wait(&mutex_);
+    }
+    Entry& entry = kernel_sets_[key];
+    std::shared_ptr<const ShHrirKernelSet> kernel_set = entry.kernel_set.lock();
+    if (kernel_set != nullptr) {
+      return kernel_set;
+    }
+    entry.creating = true;
+  }
+
+  // The kernels are created without holding the lock, as this may take long.
+  absl::StatusOr<ShHrirKernelSet> new_kernel_set = create_kernel_set();
+  std::shared_ptr<const ShHrirKernelSet> kernel_set;
+  if (new_kernel_set.ok()) {
+    kernel_set =
+        std::make_shared<const ShHrirKernelSet>(*std::move(new_kernel_set));
+  }
+
+  absl::MutexLock lock(&mutex_);
+  creation_finished_.SignalAll();
+  if (kernel_set == nullptr) {
+    // Errors are not cached, the next request tries again.
+    kernel_sets_.erase(key);
+    return new_kernel_set.status();
+  }
+  Entry& entry = kernel_sets_[key];
+  entry.creating = false;
+  entry.kernel_set = kernel_set;
+  return kernel_set;
+}
+
+bool KernelRegistry::IsBeingCreated(const Key& key) const {
+  const auto it = kernel_sets_.find(key);
+  return it != kernel_sets_.end() && it->second.creating;
+}
+
+size_t KernelRegistry::GetNumKernelSets() const {
+  absl::MutexLock lock(&mutex_);
+  size_t num_kernel_sets = 0;
+  for (const auto& entry : kernel_sets_) {
+    if (!entry.second.kernel_set.expired()) {
+      ++num_kernel_sets;
+    }
+  }
+  return num_kernel_sets;
+}
+
+}  // namespace obr
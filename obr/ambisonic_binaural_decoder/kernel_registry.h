@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#ifndef OBR_KERNEL_REGISTRY_H_
+#define OBR_KERNEL_REGISTRY_H_
+
+#include <cstddef>
+#include <memory>
+#include <tuple>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "obr/ambisonic_binaural_decoder/kernel_cache.h"
+
+namespace obr {
+
+/*!\brief Partitioned frequency domain SH-HRIRs of both ears. */
+struct ShHrirKernelSet {
+  PartitionedFreqDomainKernels kernels_L;
+  PartitionedFreqDomainKernels kernels_R;
+};
+
+/*!\brief Process-wide registry of read-only SH-HRIR kernel sets.
+ *
+ * Renderers with the same Ambisonic order, sampling rate and frames per buffer
+ * use identical kernels. The registry hands out reference counted pointers to a
+ * single immutable copy of them, which is released once the last user is gone.
+ * All methods are thread safe.
+ */
+class KernelRegistry {
+ public:
+  /*!\brief Returns the process-wide registry.
+   *
+   * \return Registry instance.
+   */
+  static KernelRegistry& GetInstance();
+
+  KernelRegistry() = default;
+  KernelRegistry(const KernelRegistry&) = delete;
+  KernelRegistry& operator=(const KernelRegistry&) = delete;
+
+  /*!\brief Returns the kernel set for a configuration, creating it if no other
+   * user holds it. Creation runs without holding the registry lock, so
+   * requests for other configurations are not held up. Concurrent requests for
+   * the same configuration wait for the first one instead of computing the
+   * kernels again.
+   *
+   * \param ambisonic_order Ambisonic order of the SH-HRIRs.
+   * \param sampling_rate Sampling rate of the SH-HRIRs.
+   * \param frames_per_buffer Frames per buffer the SH-HRIRs are partitioned
+   *        with.
+   * \param create_kernel_set Function creating the kernel set on a miss.
+   * \return Shared kernel set or the error returned by `create_kernel_set`.
+   */
+  absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>> GetOrCreate(
+      int ambisonic_order, int sampling_rate, size_t frames_per_buffer,
+      absl::FunctionRef<absl::StatusOr<ShHrirKernelSet>()> create_kernel_set);
+
+  /*!\brief Returns the number of kernel sets currently in use.
+   *
+   * \return Number of live kernel sets.
+   */
+  size_t GetNumKernelSets() const;
+
+ private:
+  typedef std::tuple<int, int, size_t> Key;
+
+  struct Entry {
+    // Kernel set, which expires when its last user releases it.
+    std::weak_ptr<const ShHrirKernelSet> kernel_set;
+
+    // True while a thread creates the kernel set.
+    bool creating = false;
+  };
+
+  /*!\brief Returns whether a thread creates the kernel set for a key.
+   *
+   * \param key Configuration of the kernel set.
+   * \return True while the kernel set is being created.
+   */
+  bool IsBeingCreated(const Key& key) const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+
+  // Signaled whenever a kernel set creation finishes.
+  absl::CondVar creation_finished_;
+
+  // Kernel sets by order, sampling rate and frames per buffer. Expired entries
+  // are removed lazily.
+  absl::flat_hash_map<Key, Entry> kernel_sets_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace obr
+
+#endif  // OBR_KERNEL_REGISTRY_H_
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+// Prevent Visual Studio from complaining about std::copy_n.
+#if defined(_WIN32)
+#define _SCL_SECURE_NO_WARNINGS
+#endif
+
+#include "obr/ambisonic_binaural_decoder/non_uniform_partitioned_fft_filter.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "absl/log/check.h"
+#include "obr/ambisonic_binaural_decoder/dsp_utils.h"
+#include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/stereo_partitioned_fft_filter.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
+
+namespace obr {
+
+namespace {
+
+// Number of partitions of each level before the partition size is doubled.
+// Any value of at least one keeps the offset of every level above the minimum
+// of `partition_size - frames_per_buffer`.
+const size_t kNumPartitionsPerLevel = 2;
+
+}  // namespace
+
+NonUniformPartitionedFftFilter::Level::Level(size_t partition_size,
+                                             size_t offset,
+                                             size_t num_partitions,
+                                             size_t num_channels)
+    : partition_size(partition_size),
+      offset(offset),
+      num_partitions(num_partitions),
+      fft_manager(partition_size),
+      input_buffer(num_channels, partition_size),
+      num_buffered_frames(0),
+      freq_input(kNumMonoChannels, fft_manager.GetFftSize()),
+      freq_domain_accumulator(kNumStereoChannels, fft_manager.GetFftSize()),
+      buffer_selector(0),
+      filtered_time_domain_buffers(2 * kNumStereoChannels,
+                                   fft_manager.GetFftSize()),
+      filtered_output(kNumStereoChannels, partition_size),
+      output_ring_buffer(kNumStereoChannels, offset + partition_size),
+      write_position(offset),
+      read_position(0) {
+  filters.reserve(num_channels);
+  for (size_t i = 0; i < num_channels; ++i) {
+    filters.emplace_back(new StereoPartitionedFftFilter(
+        num_partitions * partition_size, partition_size, &fft_manager));
+  }
+}
+
+NonUniformPartitionedFftFilter::NonUniformPartitionedFftFilter(
+    const AudioBuffer& kernels_L, const AudioBuffer& kernels_R,
+    size_t frames_per_buffer, size_t max_partition_size, size_t head_size)
+    : frames_per_buffer_(frames_per_buffer),
+      num_channels_(kernels_L.num_channels()) {
+  CHECK_NE(frames_per_buffer_, 0U);
+  CHECK_NE(num_channels_, 0U);
+  CHECK_EQ(kernels_R.num_channels(), num_channels_);
+  const size_t filter_size = kernels_L.num_frames();
+  CHECK_NE(filter_size, 0U);
+  CHECK_EQ(kernels_R.num_frames(), filter_size);
+  CHECK_LT(head_size, filter_size);
+
+  // Start with the largest partition size whose output is ready in time when
+  // convolving from `head_size` onwards.
+  size_t partition_size = frames_per_buffer_;
+  while (2 * partition_size <= head_size + frames_per_buffer_ &&
+         2 * partition_size <= max_partition_size) {
+    partition_size *= 2;
+  }
+  size_t offset = head_size;
+  while (offset < filter_size) {
+    // The output of a level is written when a full partition of input is
+    // available. Starting the level at this offset or later guarantees that
+    // the output is not needed before.
+    DCHECK_GE(offset + frames_per_buffer_, partition_size);
+
+    const size_t remaining_size = filter_size - offset;
+    const bool is_last_level =
+        2 * partition_size > max_partition_size ||
+        remaining_size <= kNumPartitionsPerLevel * partition_size;
+    const size_t num_partitions =
+        is_last_level ? (remaining_size + partition_size - 1) / partition_size
+                      : kNumPartitionsPerLevel;
+    levels_.emplace_back(
+        new Level(partition_size, offset, num_partitions, num_channels_));
+
+    // Hand the kernel segment covered by this level to its filters.
+    Level* level = levels_.back().get();
+    const size_t segment_size =
+        std::min(num_partitions * partition_size, remaining_size);
+    AudioBuffer segment(kNumStereoChannels, segment_size);
+    for (size_t channel = 0; channel < num_channels_; ++channel) {
+      std::copy_n(kernels_L[channel].begin() + offset, segment_size,
+                  segment[0].begin());
+      std::copy_n(kernels_R[channel].begin() + offset, segment_size,
+                  segment[1].begin());
+      level->filters[channel]->SetTimeDomainKernels(segment[0], segment[1]);
+    }
+
+    offset += num_partitions * partition_size;
+    partition_size *= 2;
+  }
+  Clear();
+}
+
+void NonUniformPartitionedFftFilter::Clear() {
+  for (auto& level : levels_) {
+    for (auto& filter : level->filters) {
+      filter->Clear();
+    }
+    level->input_buffer.Clear();
+    level->num_buffered_frames = 0;
+    level->buffer_selector = 0;
+    level->filtered_time_domain_buffers.Clear();
+    level->output_ring_buffer.Clear();
+    level->write_position = level->offset;
+    level->read_position = 0;
+  }
+}
+
+size_t NonUniformPartitionedFftFilter::GetPartitionSize(size_t level) const {
+  DCHECK_LT(level, levels_.size());
+  return levels_[level]->partition_size;
+}
+
+size_t NonUniformPartitionedFftFilter::GetNumPartitions(size_t level) const {
+  DCHECK_LT(level, levels_.size());
+  return levels_[level]->num_partitions;
+}
+
+size_t NonUniformPartitionedFftFilter::GetOffset(size_t level) const {
+  DCHECK_LT(level, levels_.size());
+  return levels_[level]->offset;
+}
+
+void NonUniformPartitionedFftFilter::Process(const AudioBuffer& input,
+                                             AudioBuffer* output) {
+  CHECK_EQ(input.num_channels(), num_channels_);
+  CHECK_EQ(input.num_frames(), frames_per_buffer_);
+  CHECK_NE(output, nullptr);
+  CHECK_EQ(output->num_frames(), frames_per_buffer_);
+  CHECK_EQ(output->num_channels(), kNumBinauralChannels);
+
+  output->Clear();
+  for (auto& level : levels_) {
+    for (size_t channel = 0; channel < num_channels_; ++channel) {
+      std::copy_n(input[channel].begin(), frames_per_buffer_,
+                  level->input_buffer[channel].begin() +
+                      level->num_buffered_frames);
+    }
+    level->num_buffered_frames += frames_per_buffer_;
+    if (level->num_buffered_frames == level->partition_size) {
+      ProcessLevel(level.get());
+      level->num_buffered_frames = 0;
+    }
+
+    const size_t ring_buffer_size = level->output_ring_buffer.num_frames();
+    const size_t num_frames_before_wrap =
+        std::min(frames_per_buffer_, ring_buffer_size - level->read_position);
+    for (size_t ear = 0; ear < kNumBinauralChannels; ++ear) {
+      const auto& ring_buffer = level->output_ring_buffer[ear];
+      auto& output_channel = (*output)[ear];
+      for (size_t i = 0; i < num_frames_before_wrap; ++i) {
+        output_channel[i] += ring_buffer[level->read_position + i];
+      }
+      for (size_t i = num_frames_before_wrap; i < frames_per_buffer_; ++i) {
+        output_channel[i] += ring_buffer[i - num_frames_before_wrap];
+      }
+    }
+    level->read_position =
+        (level->read_position + frames_per_buffer_) % ring_buffer_size;
+  }
+}
+
+void NonUniformPartitionedFftFilter::ProcessLevel(Level* level) {
+  DCHECK_NE(level, nullptr);
+  auto* accumulator_channel_L = &level->freq_domain_accumulator[0];
+  auto* accumulator_channel_R = &level->freq_domain_accumulator[1];
+  level->freq_domain_accumulator.Clear();
+  for (size_t channel = 0; channel < num_channels_; ++channel) {
+    level->fft_manager.FreqFromTimeDomain(level->input_buffer[channel],
+                                          &level->freq_input[0]);
+    level->filters[channel]->FilterAndAccumulate(
+        level->freq_input[0], accumulator_channel_L, accumulator_channel_R);
+  }
+
+  const size_t partition_size = level->partition_size;
+  const size_t ring_buffer_size = level->output_ring_buffer.num_frames();
+  const size_t num_frames_before_wrap =
+      std::min(partition_size, ring_buffer_size - level->write_position);
+  level->buffer_selector = !level->buffer_selector;
+  for (size_t ear = 0; ear < kNumBinauralChannels; ++ear) {
+    auto& curr_block =
+        level->filtered_time_domain_buffers[2 * ear + level->buffer_selector];
+    const auto& prev_block =
+        level->filtered_time_domain_buffers[2 * ear + !level->buffer_selector];
+    level->fft_manager.TimeFromFreqDomain(level->freq_domain_accumulator[ear],
+                                          &curr_block);
+    auto& filtered_output = level->filtered_output[ear];
+    OverlapAdd(curr_block, prev_block, &filtered_output);
+
+    auto& ring_buffer = level->output_ring_buffer[ear];
+    std::copy_n(filtered_output.begin(), num_frames_before_wrap,
+                ring_buffer.begin() + level->write_position);
+    std::copy_n(filtered_output.begin() + num_frames_before_wrap,
+                partition_size - num_frames_before_wrap, ring_buffer.begin());
+  }
+  level->write_position =
+      (level->write_position + partition_size) % ring_buffer_size;
+}
+
+}  // namespace obr
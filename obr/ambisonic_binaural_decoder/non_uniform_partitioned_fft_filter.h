@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#ifndef OBR_NON_UNIFORM_PARTITIONED_FFT_FILTER_H_
+#define OBR_NON_UNIFORM_PARTITIONED_FFT_FILTER_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/partitioned_fft_filter.h"
+#include "obr/ambisonic_binaural_decoder/stereo_partitioned_fft_filter.h"
+#include "obr/audio_buffer/audio_buffer.h"
+
+namespace obr {
+
+/*!\brief Class performing a non-uniformly partitioned FFT convolution of a
+ * multi-channel input with one pair of (left and right ear) kernels per input
+ * channel, summing all filtered channels into a stereo output.
+ *
+ * The kernels are split into levels. Each level is a uniformly partitioned
+ * convolution with partitions of `frames_per_buffer * 2^k` frames, covering a
+ * contiguous segment of the kernels. The first level runs at the block size
+ * of the host, later levels use geometrically growing partitions and therefore
+ * run their larger FFTs less often. A level with partition size `L` starts at
+ * a kernel offset of at least `L - frames_per_buffer`, so its output is ready
+ * by the time it is needed and the filter adds no latency on top of the host
+ * buffering. Within a level, the spectra of all input channels are summed per
+ * ear before a single inverse FFT.
+ *
+ * The leading `head_size` kernel taps can be excluded, e.g. to convolve them
+ * with a `DirectFormFirFilter`. The first level then starts at `head_size` and
+ * may use partitions of up to `head_size + frames_per_buffer` frames.
+ */
+class NonUniformPartitionedFftFilter {
+ public:
+  /*!\brief Constructor preallocates memory and partitions the kernels.
+   *
+   * \param kernels_L Time domain left ear kernels, one channel per input
+   *        channel.
+   * \param kernels_R Time domain right ear kernels, one channel per input
+   *        channel.
+   * \param frames_per_buffer Number of frames in each input/output buffer.
+   * \param max_partition_size Upper bound for the partition size in frames.
+   *        Values below `frames_per_buffer` result in a uniform partitioning.
+   * \param head_size Number of leading kernel taps which are not convolved.
+   *        Must be smaller than the number of frames of the kernels.
+   */
+  NonUniformPartitionedFftFilter(const AudioBuffer& kernels_L,
+                                 const AudioBuffer& kernels_R,
+                                 size_t frames_per_buffer,
+                                 size_t max_partition_size, size_t head_size);
+
+  /*!\brief Filters a block of multi-channel input and writes the sum of all
+   * filtered channels to a stereo output.
+   *
+   * \param input Input buffer with one channel per kernel pair and
+   *        `frames_per_buffer` frames.
+   * \param output Pointer to a 2-channel output buffer.
+   */
+  void Process(const AudioBuffer& input, AudioBuffer* output);
+
+  /*!\brief Resets the filter state.
+   */
+  void Clear();
+
+  /*!\brief Returns the number of levels of the partitioning.
+   *
+   * \return Number of levels.
+   */
+  size_t GetNumLevels() const { return levels_.size(); }
+
+  /*!\brief Returns the partition size of a level.
+   *
+   * \param level Index of the level.
+   * \return Partition size in frames.
+   */
+  size_t GetPartitionSize(size_t level) const;
+
+  /*!\brief Returns the number of partitions of a level.
+   *
+   * \param level Index of the level.
+   * \return Number of partitions.
+   */
+  size_t GetNumPartitions(size_t level) const;
+
+  /*!\brief Returns the kernel offset at which a level starts.
+   *
+   * \param level Index of the level.
+   * \return Offset in frames.
+   */
+  size_t GetOffset(size_t level) const;
+
+ private:
+  // A uniformly partitioned convolution of a segment of the kernels.
+  struct Level {
+    Level(size_t partition_size, size_t offset, size_t num_partitions,
+          size_t num_channels);
+
+    // Partition size in frames, which is also the hop size of the level.
+    const size_t partition_size;
+
+    // Offset of the kernel segment covered by the level in frames.
+    const size_t offset;
+
+    // Number of partitions of the level.
+    const size_t num_partitions;
+
+    // Manager for the FFTs of size `2 * partition_size` used by the level.
+    FftManager fft_manager;
+
+    // Stereo filters holding the kernel segments, one per input channel.
+    std::vector<std::unique_ptr<StereoPartitionedFftFilter>> filters;
+
+    // Input frames collected until a full partition is available.
+    AudioBuffer input_buffer;
+
+    // Number of frames currently held by `input_buffer`.
+    size_t num_buffered_frames;
+
+    // Frequency domain representation of one input channel.
+    PartitionedFftFilter::FreqDomainBuffer freq_input;
+
+    // Frequency domain accumulators, one channel per ear.
+    PartitionedFftFilter::FreqDomainBuffer freq_domain_accumulator;
+
+    // Buffer selector to switch between two filtered signal buffers.
+    size_t buffer_selector;
+
+    // Two buffers per ear that are consecutively filled with the inverse FFT
+    // of the accumulated spectra.
+    AudioBuffer filtered_time_domain_buffers;
+
+    // Overlap-added output of the latest partition, one channel per ear.
+    AudioBuffer filtered_output;
+
+    // Ring buffer holding the level output until it is due, one channel per
+    // ear. Its length is `offset + partition_size`.
+    AudioBuffer output_ring_buffer;
+
+    // Ring buffer positions of the next write and of the next read.
+    size_t write_position;
+    size_t read_position;
+  };
+
+  /*!\brief Runs the convolution of a level once a full partition of input is
+   * available and writes the result to the level's output ring buffer.
+   *
+   * \param level Level to process.
+   */
+  void ProcessLevel(Level* level);
+
+  // Number of frames in each input/output buffer.
+  const size_t frames_per_buffer_;
+
+  // Number of input channels.
+  const size_t num_channels_;
+
+  // Levels of the partitioning, ordered by increasing partition size.
+  std::vector<std::unique_ptr<Level>> levels_;
+};
+
+}  // namespace obr
+
+#endif  // OBR_NON_UNIFORM_PARTITIONED_FFT_FILTER_H_
@@ -14,6 +14,8 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "absl/log/check.h"
 #include "obr/ambisonic_binaural_decoder/dsp_utils.h"
@@ -34,6 +36,14 @@ PartitionedFftFilter::PartitionedFftFilter(size_t filter_size,
                                            size_t frames_per_buffer,
                                            size_t max_filter_size,
                                            FftManager* fft_manager)
+    : PartitionedFftFilter(filter_size, frames_per_buffer, max_filter_size,
+                           fft_manager, SpectrumPrecision::kFloat) {}
+
+PartitionedFftFilter::PartitionedFftFilter(size_t filter_size,
+                                           size_t frames_per_buffer,
+                                           size_t max_filter_size,
+                                           FftManager* fft_manager,
+                                           SpectrumPrecision precision)
     : fft_manager_(fft_manager),
       fft_size_(fft_manager_->GetFftSize()),
       chunk_size_(fft_size_ / 2),
@@ -44,14 +54,37 @@ PartitionedFftFilter::PartitionedFftFilter(size_t filter_size,
       filter_size_(
           CeilToMultipleOfFramesPerBuffer(filter_size, frames_per_buffer_)),
       num_partitions_(filter_size_ / frames_per_buffer_),
-      kernel_freq_domain_buffer_(max_num_partitions_, fft_size_),
+      precision_(precision),
+      kernel_freq_domain_buffer_(
+          precision_ == SpectrumPrecision::kFloat ? max_num_partitions_ : 0,
+          fft_size_),
+      half_kernel_freq_domain_buffer_(
+          precision_ == SpectrumPrecision::kFloat
+              ? 0
+              : max_num_partitions_ * fft_size_,
+          0),
+      half_kernel_gains_(max_num_partitions_, 1.0f),
+      half_freq_domain_buffer_(
+          precision_ == SpectrumPrecision::kHalfKernelsAndHistory
+              ? max_num_partitions_ * fft_size_
+              : 0,
+          0),
+      half_freq_domain_gains_(max_num_partitions_, 1.0f),
+      skipped_partitions_(max_num_partitions_, false),
       buffer_selector_(0),
       curr_front_buffer_(0),
-      freq_domain_buffer_(max_num_partitions_, fft_size_),
+      num_silent_partitions_(max_num_partitions_),
+      freq_domain_buffer_(
+          precision_ == SpectrumPrecision::kHalfKernelsAndHistory
+              ? 0
+              : max_num_partitions_,
+          fft_size_),
       filtered_time_domain_buffers_(kNumStereoChannels, fft_size_),
       freq_domain_accumulator_(kNumMonoChannels, fft_size_),
-      temp_zeropad_buffer_(kNumMonoChannels, chunk_size_),
-      temp_kernel_chunk_buffer_(kNumMonoChannels, frames_per_buffer_) {
+      temp_kernel_chunk_buffer_(kNumMonoChannels, frames_per_buffer_),
+      temp_kernel_partition_buffer_(
+          precision_ == SpectrumPrecision::kFloat ? 0 : kNumMonoChannels,
+          fft_size_) {
   // Ensure that `frames_per_buffer_` is less than or equal to the final
   // partition `chunk_size_`.
   CHECK_NE(fft_manager_, nullptr);
@@ -70,9 +103,10 @@ PartitionedFftFilter::PartitionedFftFilter(size_t filter_size,
 void PartitionedFftFilter::Clear() {
   // Reset valid part of the filter `FreqDomainBuffer`s to zero.
   for (size_t i = 0; i < num_partitions_; ++i) {
-    kernel_freq_domain_buffer_[i].Clear();
-    freq_domain_buffer_[i].Clear();
+    ClearKernelPartition(i);
+    ClearHistoryPartition(i);
   }
+  num_silent_partitions_ = num_partitions_;
   // Reset filter state to zero.
   filtered_time_domain_buffers_.Clear();
 }
@@ -89,7 +123,17 @@ void PartitionedFftFilter::ResetFreqDomainBuffers(size_t new_filter_size) {
   const size_t min_num_partitions =
       std::min(old_num_partitions, num_partitions_);
 
-  if (curr_front_buffer_ > 0) {
+  if (curr_front_buffer_ > 0 &&
+      precision_ == SpectrumPrecision::kHalfKernelsAndHistory) {
+    // Rotate the partition at `curr_front_buffer_` to the beginning.
+    const auto history_begin = half_freq_domain_buffer_.begin();
+    std::rotate(history_begin, history_begin + curr_front_buffer_ * fft_size_,
+                history_begin + old_num_partitions * fft_size_);
+    std::rotate(half_freq_domain_gains_.begin(),
+                half_freq_domain_gains_.begin() + curr_front_buffer_,
+                half_freq_domain_gains_.begin() + old_num_partitions);
+    curr_front_buffer_ = 0;
+  } else if (curr_front_buffer_ > 0) {
     FreqDomainBuffer temp_freq_domain_buffer(min_num_partitions, fft_size_);
     // Copy in `min_num_partitions` to `temp_freq_domain_buffer`, starting with
     // the partition at `curr_front_buffer_` to be moved back to the beginning
@@ -106,8 +150,44 @@ void PartitionedFftFilter::ResetFreqDomainBuffers(size_t new_filter_size) {
   }
   // Clear out the remaining partitions in case the filter size grew.
   for (size_t i = old_num_partitions; i < num_partitions_; ++i) {
-    freq_domain_buffer_[i].Clear();
+    ClearHistoryPartition(i);
+  }
+  num_silent_partitions_ = num_silent_partitions_ >= old_num_partitions
+                               ? num_partitions_
+                               : std::min(num_silent_partitions_,
+                                          num_partitions_);
+}
+
+void PartitionedFftFilter::SetKernelPartition(
+    size_t partition_index, const FreqDomainBuffer::Channel& kernel_partition) {
+  if (precision_ == SpectrumPrecision::kFloat) {
+    kernel_freq_domain_buffer_[partition_index] = kernel_partition;
+    return;
+  }
+  half_kernel_gains_[partition_index] = HalfFromFreqDomainChannel(
+      kernel_partition,
+      &half_kernel_freq_domain_buffer_[partition_index * fft_size_]);
+}
+
+void PartitionedFftFilter::ClearKernelPartition(size_t partition_index) {
+  if (precision_ == SpectrumPrecision::kFloat) {
+    kernel_freq_domain_buffer_[partition_index].Clear();
+    return;
   }
+  std::fill_n(
+      half_kernel_freq_domain_buffer_.begin() + partition_index * fft_size_,
+      fft_size_, 0);
+  half_kernel_gains_[partition_index] = 1.0f;
+}
+
+void PartitionedFftFilter::ClearHistoryPartition(size_t partition_index) {
+  if (precision_ != SpectrumPrecision::kHalfKernelsAndHistory) {
+    freq_domain_buffer_[partition_index].Clear();
+    return;
+  }
+  std::fill_n(half_freq_domain_buffer_.begin() + partition_index * fft_size_,
+              fft_size_, 0);
+  half_freq_domain_gains_[partition_index] = 1.0f;
 }
 
 void PartitionedFftFilter::ReplacePartition(
@@ -116,8 +196,14 @@ void PartitionedFftFilter::ReplacePartition(
   DCHECK_LT(partition_index, num_partitions_);
   DCHECK_EQ(kernel_chunk.size(), frames_per_buffer_);
 
-  fft_manager_->FreqFromTimeDomain(
-      kernel_chunk, &kernel_freq_domain_buffer_[partition_index]);
+  if (precision_ == SpectrumPrecision::kFloat) {
+    fft_manager_->FreqFromTimeDomain(
+        kernel_chunk, &kernel_freq_domain_buffer_[partition_index]);
+    return;
+  }
+  fft_manager_->FreqFromTimeDomain(kernel_chunk,
+                                   &temp_kernel_partition_buffer_[0]);
+  SetKernelPartition(partition_index, temp_kernel_partition_buffer_[0]);
 }
 
 void PartitionedFftFilter::SetFilterLength(size_t new_filter_size) {
@@ -131,13 +217,21 @@ void PartitionedFftFilter::SetFilterLength(size_t new_filter_size) {
 
   // Clear out the remaining partitions in case the filter size grew.
   for (size_t i = num_partitions_; i < new_num_partitions; ++i) {
-    kernel_freq_domain_buffer_[i].Clear();
+    ClearKernelPartition(i);
   }
   // Call `ResetFreqDomainBuffers` to make sure that the input buffers are also
   // correctly resized.
   ResetFreqDomainBuffers(new_filter_size);
 }
 
+void PartitionedFftFilter::SetSkippedPartitions(
+    const std::vector<bool>& skipped_partitions) {
+  DCHECK_LE(skipped_partitions.size(), max_num_partitions_);
+  std::fill(std::copy(skipped_partitions.begin(), skipped_partitions.end(),
+                      skipped_partitions_.begin()),
+            skipped_partitions_.end(), false);
+}
+
 void PartitionedFftFilter::SetTimeDomainKernel(
     const AudioBuffer::Channel& kernel) {
   // Precomputes a set of floor(`filter_size_`/(`fft_size`/2)) frequency domain
@@ -153,6 +247,7 @@ void PartitionedFftFilter::SetTimeDomainKernel(
   const size_t new_num_partitions =
       CeilToMultipleOfFramesPerBuffer(kernel.size(), frames_per_buffer_) /
       frames_per_buffer_;
+  std::fill(skipped_partitions_.begin(), skipped_partitions_.end(), false);
 
   auto& padded_channel = temp_kernel_chunk_buffer_[0];
   // Break up time domain filter into chunks and FFT each of these separately.
@@ -167,8 +262,14 @@ void PartitionedFftFilter::SetTimeDomainKernel(
     // This fill only occurs on the very last partition.
     std::fill(padded_channel.begin() + num_frames_to_copy, padded_channel.end(),
               0.0f);
-    fft_manager_->FreqFromTimeDomain(padded_channel,
-                                     &kernel_freq_domain_buffer_[partition]);
+    if (precision_ == SpectrumPrecision::kFloat) {
+      fft_manager_->FreqFromTimeDomain(padded_channel,
+                                       &kernel_freq_domain_buffer_[partition]);
+    } else {
+      fft_manager_->FreqFromTimeDomain(padded_channel,
+                                       &temp_kernel_partition_buffer_[0]);
+      SetKernelPartition(partition, temp_kernel_partition_buffer_[0]);
+    }
   }
 
   if (new_num_partitions != num_partitions_) {
@@ -182,8 +283,9 @@ void PartitionedFftFilter::SetFreqDomainKernel(const FreqDomainBuffer& kernel) {
   DCHECK_EQ(kernel.num_frames(), fft_size_);
 
   const size_t new_num_partitions = kernel.num_channels();
+  std::fill(skipped_partitions_.begin(), skipped_partitions_.end(), false);
   for (size_t i = 0; i < new_num_partitions; ++i) {
-    kernel_freq_domain_buffer_[i] = kernel[i];
+    SetKernelPartition(i, kernel[i]);
   }
   if (new_num_partitions != num_partitions_) {
     const size_t new_filter_size = new_num_partitions * frames_per_buffer_;
@@ -192,29 +294,81 @@ void PartitionedFftFilter::SetFreqDomainKernel(const FreqDomainBuffer& kernel) {
 }
 
 void PartitionedFftFilter::Filter(const FreqDomainBuffer::Channel& input) {
-  DCHECK_EQ(input.size(), fft_size_);
-  std::copy_n(input.begin(), fft_size_,
-              freq_domain_buffer_[curr_front_buffer_].begin());
   buffer_selector_ = !buffer_selector_;
   freq_domain_accumulator_.Clear();
   auto* accumulator_channel = &freq_domain_accumulator_[0];
+  FilterAndAccumulate(input, accumulator_channel);
+  // Perform inverse FFT transform of `freq_domain_buffer_` and store the
+  // result back in `filtered_time_domain_buffers_`.
+  fft_manager_->TimeFromFreqDomain(
+      *accumulator_channel, &filtered_time_domain_buffers_[buffer_selector_]);
+}
 
-  for (size_t i = 0; i < num_partitions_; ++i) {
+void PartitionedFftFilter::FilterAndAccumulate(
+    const FreqDomainBuffer::Channel& input,
+    FreqDomainBuffer::Channel* accumulator) {
+  DCHECK_EQ(input.size(), fft_size_);
+  DCHECK_NE(accumulator, nullptr);
+  DCHECK_EQ(accumulator->size(), fft_size_);
+  if (precision_ == SpectrumPrecision::kHalfKernelsAndHistory) {
+    half_freq_domain_gains_[curr_front_buffer_] = HalfFromFreqDomainChannel(
+        input, &half_freq_domain_buffer_[curr_front_buffer_ * fft_size_]);
+  } else {
+    std::copy_n(input.begin(), fft_size_,
+                freq_domain_buffer_[curr_front_buffer_].begin());
+  }
+  num_silent_partitions_ = 0;
+  AccumulatePartitions(0, accumulator);
+}
+
+void PartitionedFftFilter::FilterSilenceAndAccumulate(
+    FreqDomainBuffer::Channel* accumulator) {
+  DCHECK_NE(accumulator, nullptr);
+  DCHECK_EQ(accumulator->size(), fft_size_);
+  // Advancing a silent input history does not change it.
+  if (num_silent_partitions_ >= num_partitions_) {
+    return;
+  }
+  ClearHistoryPartition(curr_front_buffer_);
+  ++num_silent_partitions_;
+  AccumulatePartitions(num_silent_partitions_, accumulator);
+}
+
+void PartitionedFftFilter::AccumulatePartitions(
+    size_t first_partition, FreqDomainBuffer::Channel* accumulator) {
+  for (size_t i = first_partition; i < num_partitions_; ++i) {
+    if (skipped_partitions_[i]) {
+      continue;
+    }
     // Complex vector product in frequency domain with filter kernel.
     const size_t modulo_index = (curr_front_buffer_ + i) % num_partitions_;
 
     // Perform inverse scaling along with accumulation of last fft buffer.
-    fft_manager_->FreqDomainConvolution(freq_domain_buffer_[modulo_index],
-                                        kernel_freq_domain_buffer_[i],
-                                        accumulator_channel);
+    switch (precision_) {
+      case SpectrumPrecision::kFloat:
+        fft_manager_->FreqDomainConvolution(freq_domain_buffer_[modulo_index],
+                                            kernel_freq_domain_buffer_[i],
+                                            accumulator);
+        break;
+      case SpectrumPrecision::kHalfKernels:
+        fft_manager_->FreqDomainConvolution(
+            freq_domain_buffer_[modulo_index],
+            &half_kernel_freq_domain_buffer_[i * fft_size_],
+            1.0f / half_kernel_gains_[i], accumulator);
+        break;
+      case SpectrumPrecision::kHalfKernelsAndHistory:
+        fft_manager_->FreqDomainConvolution(
+            &half_freq_domain_buffer_[modulo_index * fft_size_],
+            &half_kernel_freq_domain_buffer_[i * fft_size_],
+            1.0f / (half_freq_domain_gains_[modulo_index] *
+                    half_kernel_gains_[i]),
+            accumulator);
+        break;
+    }
   }
   // Our modulo based index.
   curr_front_buffer_ =
       (curr_front_buffer_ + num_partitions_ - 1) % num_partitions_;
-  // Perform inverse FFT transform of `freq_domain_buffer_` and store the
-  // result back in `filtered_time_domain_buffers_`.
-  fft_manager_->TimeFromFreqDomain(
-      *accumulator_channel, &filtered_time_domain_buffers_[buffer_selector_]);
 }
 
 void PartitionedFftFilter::GetFilteredSignal(AudioBuffer::Channel* output) {
@@ -224,28 +378,14 @@ void PartitionedFftFilter::GetFilteredSignal(AudioBuffer::Channel* output) {
   const size_t curr_buffer = buffer_selector_;
   const size_t prev_buffer = !buffer_selector_;
 
-  // Overlap add.
-  if (frames_per_buffer_ == chunk_size_) {
-    AddPointwise(chunk_size_, &(filtered_time_domain_buffers_[curr_buffer][0]),
-                 &filtered_time_domain_buffers_[prev_buffer][chunk_size_],
-                 &((*output)[0]));
-  } else {
-    // If we have a non power of two `frames_per_buffer` we will have to perform
-    // the overlap add and then a copy, as buffer lengths are not a multiple of
-    // `chunk_size_`. NOTE: Indexing into `filtered_time_domain_buffers_` for a
-    // non power of two `frames_per_buffer_` means that the `input_b` parameter
-    // of `AddPointwiseOutOfPlace` may not be aligned in memory and thus we will
-    // not be able to use SIMD for the overlap add operation.
-    const auto& first_channel = filtered_time_domain_buffers_[curr_buffer];
-    const auto& second_channel = filtered_time_domain_buffers_[prev_buffer];
-    auto& output_channel = temp_zeropad_buffer_[0];
-    for (size_t i = 0; i < frames_per_buffer_; ++i) {
-      output_channel[i] =
-          first_channel[i] + second_channel[i + frames_per_buffer_];
-    }
-    std::copy_n(temp_zeropad_buffer_[0].begin(), frames_per_buffer_,
-                output->begin());
-  }
+  // Overlap add. For a non power of two `frames_per_buffer_` the tail of the
+  // previous block starts at an unaligned offset, which `AddPointwise` reads
+  // with unaligned loads directly into `output`.
+  AddPointwise(frames_per_buffer_,
+               filtered_time_domain_buffers_[curr_buffer].begin(),
+               filtered_time_domain_buffers_[prev_buffer].begin() +
+                   frames_per_buffer_,
+               output->begin());
 }
 
 }  // namespace obr
@@ -10,15 +10,33 @@
 #define OBR_PARTITIONED_FFT_FILTER_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/audio_buffer/aligned_allocator.h"
 #include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
 
 struct PFFFT_Setup;
 
 // This code is forked from the Resonance Audio's `partitioned_fft_filter.h.
 namespace obr {
 
+/*!\brief Storage precision of the frequency domain kernels and input history
+ * of a `PartitionedFftFilter`. Half precision storage halves the memory traffic
+ * of the convolution, which is bound by memory bandwidth for long filters, at
+ * an error of around -70 dB relative to the largest value of each partition.
+ */
+enum class SpectrumPrecision {
+  // Kernels and history are stored as 32 bit floats.
+  kFloat,
+  // Kernels are stored as IEEE 754 half precision floats.
+  kHalfKernels,
+  // Kernels and history are stored as IEEE 754 half precision floats.
+  kHalfKernelsAndHistory,
+};
+
 /*!\brief Class performing a FFT-based overlap and add FIR convolution.
  *
  * Given an FFT size N and a filter size M > N/2; the filter is broken in to
@@ -31,6 +49,12 @@ class PartitionedFftFilter {
   // channel stores the kernel for a partition.
   typedef AudioBuffer FreqDomainBuffer;
 
+  // Typedef declares the data type for storing half precision frequency domain
+  // partitions, `fft_size_` values each, one after the other.
+  typedef std::vector<uint16_t,
+                      AlignedAllocator<uint16_t, kMemoryAlignmentBytes>>
+      HalfFreqDomainBuffer;
+
   /*!\brief Constructor preallocates memory based on the `filter_size`.
    * This can be used for simplicity if the filter size will be constant after
    * creation.
@@ -56,6 +80,20 @@ class PartitionedFftFilter {
   PartitionedFftFilter(size_t filter_size, size_t frames_per_buffer,
                        size_t max_filter_size, FftManager* fft_manager);
 
+  /*!\brief Constructor preallocates memory based on the `max_filter_size` and
+   * stores the kernel and input spectra with the given precision.
+   *
+   * \param filter_size Length of the time domain filter in samples. This will
+   *        be increased such that it becomes a multiple of `chunk_size_`.
+   * \param frames_per_buffer Number of points in each time domain input buffer.
+   * \param max_filter_size Maximum length that `filter_size` can get.
+   * \param fft_manager Pointer to a manager for all fft related functionality.
+   * \param precision Storage precision of the spectra.
+   */
+  PartitionedFftFilter(size_t filter_size, size_t frames_per_buffer,
+                       size_t max_filter_size, FftManager* fft_manager,
+                       SpectrumPrecision precision);
+
   /*!\brief Initializes the FIR filter from a time domain kernel.
    *
    * \param kernel Time domain filter to be used for processing.
@@ -89,6 +127,15 @@ class PartitionedFftFilter {
    */
   void SetFilterLength(size_t new_filter_size);
 
+  /*!\brief Sets a mask of kernel partitions which are skipped in `Filter()`,
+   * e.g. because they hold next to no energy. The mask is reset whenever a new
+   * kernel is set.
+   *
+   * \param skipped_partitions One flag per partition, true if the partition is
+   *        skipped. Partitions beyond the size of the mask are not skipped.
+   */
+  void SetSkippedPartitions(const std::vector<bool>& skipped_partitions);
+
   /*!\brief Processes a block of frequency domain samples. The size of the input
    * block must be `fft_size_`.
    *
@@ -96,6 +143,27 @@ class PartitionedFftFilter {
    */
   void Filter(const FreqDomainBuffer::Channel& input);
 
+  /*!\brief Processes a block of frequency domain samples and adds the filtered
+   * spectrum to `accumulator`, without transforming back to the time domain.
+   * The output of `GetFilteredSignal` is not updated. The size of the input
+   * block and of the accumulator must be `fft_size_`.
+   *
+   * \param input Frequency domain input buffer.
+   * \param accumulator Frequency domain buffer the filtered spectrum is added
+   *        to.
+   */
+  void FilterAndAccumulate(const FreqDomainBuffer::Channel& input,
+                           FreqDomainBuffer::Channel* accumulator);
+
+  /*!\brief Processes a block of silence, equivalent to `FilterAndAccumulate()`
+   * with an all zero input. Silent partitions of the input history are not
+   * convolved, and nothing is done once the whole history is silent.
+   *
+   * \param accumulator Frequency domain buffer the filtered spectrum is added
+   *        to.
+   */
+  void FilterSilenceAndAccumulate(FreqDomainBuffer::Channel* accumulator);
+
   /*!\brief Returns block of filtered signal output of size `fft_size_`/2.
    *
    * \param output Time domain block filtered with the given kernel.
@@ -117,6 +185,36 @@ class PartitionedFftFilter {
    */
   void ResetFreqDomainBuffers(size_t new_filter_size);
 
+  /*!\brief Stores a frequency domain kernel partition.
+   *
+   * \param partition_index Index of the partition.
+   * \param kernel_partition Frequency domain kernel partition.
+   */
+  void SetKernelPartition(size_t partition_index,
+                          const FreqDomainBuffer::Channel& kernel_partition);
+
+  /*!\brief Sets a kernel partition to zero.
+   *
+   * \param partition_index Index of the partition.
+   */
+  void ClearKernelPartition(size_t partition_index);
+
+  /*!\brief Sets an input history partition to zero.
+   *
+   * \param partition_index Index of the partition.
+   */
+  void ClearHistoryPartition(size_t partition_index);
+
+  /*!\brief Convolves the input history from `first_partition` on with the
+   * kernel, accumulates the products and advances the input history.
+   *
+   * \param first_partition Index of the first partition to convolve, earlier
+   *        partitions are silent.
+   * \param accumulator Frequency domain accumulator.
+   */
+  void AccumulatePartitions(size_t first_partition,
+                            FreqDomainBuffer::Channel* accumulator);
+
   // Manager for all FFT related functionality (not owned).
   FftManager* const fft_manager_;
 
@@ -141,16 +239,36 @@ class PartitionedFftFilter {
   // Partition Count.
   size_t num_partitions_;
 
-  // Kernel buffer in frequency domain.
+  // Storage precision of the kernel and input history spectra.
+  const SpectrumPrecision precision_;
+
+  // Kernel buffer in frequency domain. Empty unless the precision is `kFloat`.
   FreqDomainBuffer kernel_freq_domain_buffer_;
 
+  // Half precision kernel partitions and the gains they were scaled with. Empty
+  // if the precision is `kFloat`.
+  HalfFreqDomainBuffer half_kernel_freq_domain_buffer_;
+  std::vector<float> half_kernel_gains_;
+
+  // Half precision input history partitions and the gains they were scaled
+  // with. Only used with `kHalfKernelsAndHistory`.
+  HalfFreqDomainBuffer half_freq_domain_buffer_;
+  std::vector<float> half_freq_domain_gains_;
+
+  // Flags marking the kernel partitions which are not convolved.
+  std::vector<bool> skipped_partitions_;
+
   // Buffer selector to switch between two filtered signal buffers.
   size_t buffer_selector_;
 
   // The freq_domain_buffer we will write new incoming audio into.
   size_t curr_front_buffer_;
 
-  // Frequency domain buffer used to perform filtering.
+  // Number of most recent partitions of the input history which hold silence.
+  size_t num_silent_partitions_;
+
+  // Frequency domain buffer used to perform filtering. Empty with
+  // `kHalfKernelsAndHistory`.
   FreqDomainBuffer freq_domain_buffer_;
 
   // Two buffers that are consecutively filled with filtered signal output.
@@ -159,13 +277,13 @@ class PartitionedFftFilter {
   // Accumulator for the outputs from each convolution partition
   FreqDomainBuffer freq_domain_accumulator_;
 
-  // Temporary time domain buffer to store output when zero padding has been
-  // applied due to non power of two input buffer lengths.
-  AudioBuffer temp_zeropad_buffer_;
-
   // Temporary time domain buffer to hold time domain kernel chunks during
   // conversion of a kernel from time to frequency domain.
   AudioBuffer temp_kernel_chunk_buffer_;
+
+  // Temporary frequency domain buffer to hold kernel partitions before their
+  // conversion to half precision.
+  FreqDomainBuffer temp_kernel_partition_buffer_;
 };
 
 }  // namespace obr
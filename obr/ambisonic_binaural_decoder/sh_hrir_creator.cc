@@ -8,6 +8,7 @@
 
 #include "obr/ambisonic_binaural_decoder/sh_hrir_creator.h"
 
+#include <cmath>
 #include <cstddef>
 #include <memory>
 #include <sstream>
@@ -74,4 +75,25 @@ std::unique_ptr<AudioBuffer> CreateShHrirsFromAssets(
   return CreateShHrirsFromWav(*wav, target_sample_rate_hz, resampler);
 }
 
+bool AreShHrirsSymmetric(const AudioBuffer& sh_hrirs_L,
+                         const AudioBuffer& sh_hrirs_R, float tolerance) {
+  if (sh_hrirs_L.num_channels() != sh_hrirs_R.num_channels() ||
+      sh_hrirs_L.num_frames() != sh_hrirs_R.num_frames()) {
+    return false;
+  }
+  for (size_t channel = 0; channel < sh_hrirs_L.num_channels(); ++channel) {
+    // Mirroring about the median plane flips the sign of the sin harmonics.
+    const float sign =
+        GetPeriphonicAmbisonicDegreeForChannel(channel) < 0 ? -1.0f : 1.0f;
+    const auto& channel_L = sh_hrirs_L[channel];
+    const auto& channel_R = sh_hrirs_R[channel];
+    for (size_t frame = 0; frame < sh_hrirs_L.num_frames(); ++frame) {
+      if (std::abs(channel_R[frame] - sign * channel_L[frame]) > tolerance) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 }  // namespace obr
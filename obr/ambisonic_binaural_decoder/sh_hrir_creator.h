@@ -48,6 +48,18 @@ std::unique_ptr<AudioBuffer> CreateShHrirsFromAssets(
     const std::string& filename, int target_sample_rate_hz,
     Resampler* resampler);
 
+/*!\brief Checks whether a pair of SH-HRIR sets describes a left/right
+ * symmetric head, i.e. whether the right ear filters equal the left ear
+ * filters with the sign of the sin (m < 0) harmonics flipped.
+ *
+ * \param sh_hrirs_L Left ear SH-HRIRs.
+ * \param sh_hrirs_R Right ear SH-HRIRs.
+ * \param tolerance Maximum absolute difference per sample.
+ * \return True if the filters are symmetric within `tolerance`.
+ */
+bool AreShHrirsSymmetric(const AudioBuffer& sh_hrirs_L,
+                         const AudioBuffer& sh_hrirs_R, float tolerance);
+
 }  // namespace obr
 
 #endif  // OBR_SH_HRIR_CREATOR_H_
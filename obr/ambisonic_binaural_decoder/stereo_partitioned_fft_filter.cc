@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+// Prevent Visual Studio from complaining about std::copy_n.
+#if defined(_WIN32)
+#define _SCL_SECURE_NO_WARNINGS
+#endif
+
+#include "obr/ambisonic_binaural_decoder/stereo_partitioned_fft_filter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "obr/ambisonic_binaural_decoder/dsp_utils.h"
+#include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
+
+namespace obr {
+
+StereoPartitionedFftFilter::StereoPartitionedFftFilter(
+    size_t filter_size, size_t frames_per_buffer, FftManager* fft_manager)
+    : StereoPartitionedFftFilter(filter_size, frames_per_buffer, fft_manager,
+                                 SpectrumPrecision::kFloat) {}
+
+StereoPartitionedFftFilter::StereoPartitionedFftFilter(
+    size_t filter_size, size_t frames_per_buffer, FftManager* fft_manager,
+    SpectrumPrecision precision)
+    : fft_manager_(fft_manager),
+      fft_size_(fft_manager_->GetFftSize()),
+      chunk_size_(fft_size_ / 2),
+      frames_per_buffer_(frames_per_buffer),
+      filter_size_(
+          CeilToMultipleOfFramesPerBuffer(filter_size, frames_per_buffer_)),
+      num_partitions_(filter_size_ / frames_per_buffer_),
+      precision_(precision),
+      half_kernel_freq_domain_buffer_L_(
+          precision_ == SpectrumPrecision::kFloat
+              ? 0
+              : num_partitions_ * fft_size_,
+          0),
+      half_kernel_freq_domain_buffer_R_(
+          half_kernel_freq_domain_buffer_L_.size(), 0),
+      half_kernel_gains_L_(num_partitions_, 1.0f),
+      half_kernel_gains_R_(num_partitions_, 1.0f),
+      skipped_partitions_L_(num_partitions_, false),
+      skipped_partitions_R_(num_partitions_, false),
+      buffer_selector_(0),
+      curr_front_buffer_(0),
+      num_silent_partitions_(num_partitions_),
+      freq_domain_buffer_(
+          precision_ == SpectrumPrecision::kHalfKernelsAndHistory
+              ? 0
+              : num_partitions_,
+          fft_size_),
+      half_freq_domain_buffer_(
+          precision_ == SpectrumPrecision::kHalfKernelsAndHistory
+              ? num_partitions_ * fft_size_
+              : 0,
+          0),
+      half_freq_domain_gains_(num_partitions_, 1.0f),
+      filtered_time_domain_buffers_(2 * kNumStereoChannels, fft_size_),
+      freq_domain_accumulator_(kNumStereoChannels, fft_size_),
+      temp_kernel_chunk_buffer_(kNumMonoChannels, frames_per_buffer_) {
+  CHECK_NE(fft_manager_, nullptr);
+  CHECK_LE(frames_per_buffer_, chunk_size_);
+  CHECK_GE(filter_size_, filter_size);
+  Clear();
+}
+
+void StereoPartitionedFftFilter::Clear() {
+  freq_domain_buffer_.Clear();
+  std::fill(half_freq_domain_buffer_.begin(), half_freq_domain_buffer_.end(),
+            0);
+  std::fill(half_freq_domain_gains_.begin(), half_freq_domain_gains_.end(),
+            1.0f);
+  num_silent_partitions_ = num_partitions_;
+  filtered_time_domain_buffers_.Clear();
+}
+
+void StereoPartitionedFftFilter::PartitionKernel(
+    const AudioBuffer::Channel& kernel,
+    FreqDomainBuffer* kernel_freq_domain_buffer) {
+  auto& padded_channel = temp_kernel_chunk_buffer_[0];
+  for (size_t partition = 0; partition < num_partitions_; ++partition) {
+    const size_t chunk_begin = partition * frames_per_buffer_;
+    const size_t num_frames_to_copy =
+        chunk_begin < kernel.size()
+            ? std::min(frames_per_buffer_, kernel.size() - chunk_begin)
+            : 0;
+    if (num_frames_to_copy > 0) {
+      std::copy_n(kernel.begin() + chunk_begin, num_frames_to_copy,
+                  padded_channel.begin());
+    }
+    std::fill(padded_channel.begin() + num_frames_to_copy, padded_channel.end(),
+              0.0f);
+    fft_manager_->FreqFromTimeDomain(padded_channel,
+                                     &(*kernel_freq_domain_buffer)[partition]);
+  }
+}
+
+void StereoPartitionedFftFilter::SetTimeDomainKernels(
+    const AudioBuffer::Channel& kernel_L,
+    const AudioBuffer::Channel& kernel_R) {
+  auto kernel_freq_domain_buffer_L =
+      std::make_shared<FreqDomainBuffer>(num_partitions_, fft_size_);
+  auto kernel_freq_domain_buffer_R =
+      std::make_shared<FreqDomainBuffer>(num_partitions_, fft_size_);
+  PartitionKernel(kernel_L, kernel_freq_domain_buffer_L.get());
+  PartitionKernel(kernel_R, kernel_freq_domain_buffer_R.get());
+  UseKernels(std::move(kernel_freq_domain_buffer_L),
+             std::move(kernel_freq_domain_buffer_R));
+}
+
+void StereoPartitionedFftFilter::SetFreqDomainKernels(
+    const FreqDomainBuffer& kernel_L, const FreqDomainBuffer& kernel_R) {
+  DCHECK_LE(kernel_L.num_channels(), num_partitions_);
+  DCHECK_LE(kernel_R.num_channels(), num_partitions_);
+  DCHECK_EQ(kernel_L.num_frames(), fft_size_);
+  DCHECK_EQ(kernel_R.num_frames(), fft_size_);
+
+  auto kernel_freq_domain_buffer_L =
+      std::make_shared<FreqDomainBuffer>(num_partitions_, fft_size_);
+  auto kernel_freq_domain_buffer_R =
+      std::make_shared<FreqDomainBuffer>(num_partitions_, fft_size_);
+  kernel_freq_domain_buffer_L->Clear();
+  kernel_freq_domain_buffer_R->Clear();
+  for (size_t i = 0; i < kernel_L.num_channels(); ++i) {
+    (*kernel_freq_domain_buffer_L)[i] = kernel_L[i];
+  }
+  for (size_t i = 0; i < kernel_R.num_channels(); ++i) {
+    (*kernel_freq_domain_buffer_R)[i] = kernel_R[i];
+  }
+  UseKernels(std::move(kernel_freq_domain_buffer_L),
+             std::move(kernel_freq_domain_buffer_R));
+}
+
+void StereoPartitionedFftFilter::SetSharedFreqDomainKernels(
+    std::shared_ptr<const FreqDomainBuffer> kernel_L,
+    std::shared_ptr<const FreqDomainBuffer> kernel_R) {
+  CHECK_NE(kernel_L, nullptr);
+  CHECK_NE(kernel_R, nullptr);
+  CHECK_EQ(kernel_L->num_channels(), num_partitions_);
+  CHECK_EQ(kernel_R->num_channels(), num_partitions_);
+  CHECK_EQ(kernel_L->num_frames(), fft_size_);
+  CHECK_EQ(kernel_R->num_frames(), fft_size_);
+  UseKernels(std::move(kernel_L), std::move(kernel_R));
+}
+
+void StereoPartitionedFftFilter::UseKernels(
+    std::shared_ptr<const FreqDomainBuffer> kernel_L,
+    std::shared_ptr<const FreqDomainBuffer> kernel_R) {
+  if (precision_ == SpectrumPrecision::kFloat) {
+    kernel_freq_domain_buffer_L_ = std::move(kernel_L);
+    kernel_freq_domain_buffer_R_ = std::move(kernel_R);
+  } else {
+    HalfFromKernel(*kernel_L, &half_kernel_freq_domain_buffer_L_,
+                   &half_kernel_gains_L_);
+    HalfFromKernel(*kernel_R, &half_kernel_freq_domain_buffer_R_,
+                   &half_kernel_gains_R_);
+  }
+  SetSkippedPartitions({}, {});
+}
+
+void StereoPartitionedFftFilter::HalfFromKernel(
+    const FreqDomainBuffer& kernel, HalfFreqDomainBuffer* half_kernel,
+    std::vector<float>* half_kernel_gains) {
+  DCHECK_LE(kernel.num_channels(), num_partitions_);
+  for (size_t i = 0; i < kernel.num_channels(); ++i) {
+    (*half_kernel_gains)[i] =
+        HalfFromFreqDomainChannel(kernel[i], &(*half_kernel)[i * fft_size_]);
+  }
+  std::fill(half_kernel->begin() + kernel.num_channels() * fft_size_,
+            half_kernel->end(), 0);
+  std::fill(half_kernel_gains->begin() + kernel.num_channels(),
+            half_kernel_gains->end(), 1.0f);
+}
+
+void StereoPartitionedFftFilter::ConvolvePartition(
+    size_t history_index, const FreqDomainBuffer* kernel,
+    const HalfFreqDomainBuffer& half_kernel,
+    const std::vector<float>& half_kernel_gains, size_t partition,
+    FreqDomainBuffer::Channel* accumulator) {
+  switch (precision_) {
+    case SpectrumPrecision::kFloat:
+      fft_manager_->FreqDomainConvolution(freq_domain_buffer_[history_index],
+                                          (*kernel)[partition], accumulator);
+      break;
+    case SpectrumPrecision::kHalfKernels:
+      fft_manager_->FreqDomainConvolution(
+          freq_domain_buffer_[history_index],
+          &half_kernel[partition * fft_size_],
+          1.0f / half_kernel_gains[partition], accumulator);
+      break;
+    case SpectrumPrecision::kHalfKernelsAndHistory:
+      fft_manager_->FreqDomainConvolution(
+          &half_freq_domain_buffer_[history_index * fft_size_],
+          &half_kernel[partition * fft_size_],
+          1.0f / (half_freq_domain_gains_[history_index] *
+                  half_kernel_gains[partition]),
+          accumulator);
+      break;
+  }
+}
+
+void StereoPartitionedFftFilter::SetSkippedPartitions(
+    const std::vector<bool>& skipped_partitions_L,
+    const std::vector<bool>& skipped_partitions_R) {
+  DCHECK_LE(skipped_partitions_L.size(), num_partitions_);
+  DCHECK_LE(skipped_partitions_R.size(), num_partitions_);
+  std::fill(std::copy(skipped_partitions_L.begin(), skipped_partitions_L.end(),
+                      skipped_partitions_L_.begin()),
+            skipped_partitions_L_.end(), false);
+  std::fill(std::copy(skipped_partitions_R.begin(), skipped_partitions_R.end(),
+                      skipped_partitions_R_.begin()),
+            skipped_partitions_R_.end(), false);
+}
+
+void StereoPartitionedFftFilter::FilterAndAccumulate(
+    const FreqDomainBuffer::Channel& input,
+    FreqDomainBuffer::Channel* accumulator_L,
+    FreqDomainBuffer::Channel* accumulator_R) {
+  DCHECK_EQ(input.size(), fft_size_);
+  DCHECK_NE(accumulator_L, nullptr);
+  DCHECK_NE(accumulator_R, nullptr);
+  DCHECK_EQ(accumulator_L->size(), fft_size_);
+  DCHECK_EQ(accumulator_R->size(), fft_size_);
+  if (precision_ == SpectrumPrecision::kHalfKernelsAndHistory) {
+    half_freq_domain_gains_[curr_front_buffer_] = HalfFromFreqDomainChannel(
+        input, &half_freq_domain_buffer_[curr_front_buffer_ * fft_size_]);
+  } else {
+    std::copy_n(input.begin(), fft_size_,
+                freq_domain_buffer_[curr_front_buffer_].begin());
+  }
+  num_silent_partitions_ = 0;
+  AccumulatePartitions(0, accumulator_L, accumulator_R);
+}
+
+void StereoPartitionedFftFilter::FilterSilenceAndAccumulate(
+    FreqDomainBuffer::Channel* accumulator_L,
+    FreqDomainBuffer::Channel* accumulator_R) {
+  DCHECK_NE(accumulator_L, nullptr);
+  DCHECK_NE(accumulator_R, nullptr);
+  // Advancing a silent delay line does not change it.
+  if (num_silent_partitions_ >= num_partitions_) {
+    return;
+  }
+  if (precision_ == SpectrumPrecision::kHalfKernelsAndHistory) {
+    std::fill_n(
+        half_freq_domain_buffer_.begin() + curr_front_buffer_ * fft_size_,
+        fft_size_, 0);
+    half_freq_domain_gains_[curr_front_buffer_] = 1.0f;
+  } else {
+    freq_domain_buffer_[curr_front_buffer_].Clear();
+  }
+  ++num_silent_partitions_;
+  AccumulatePartitions(num_silent_partitions_, accumulator_L, accumulator_R);
+}
+
+void StereoPartitionedFftFilter::AccumulatePartitions(
+    size_t first_partition, FreqDomainBuffer::Channel* accumulator_L,
+    FreqDomainBuffer::Channel* accumulator_R) {
+  // Filters without kernels have an all zero response.
+  if (precision_ != SpectrumPrecision::kFloat ||
+      kernel_freq_domain_buffer_L_ != nullptr) {
+    for (size_t i = first_partition; i < num_partitions_; ++i) {
+      // Both ears read the same partition of the shared input history.
+      const size_t modulo_index = (curr_front_buffer_ + i) % num_partitions_;
+      if (!skipped_partitions_L_[i]) {
+        ConvolvePartition(modulo_index, kernel_freq_domain_buffer_L_.get(),
+                          half_kernel_freq_domain_buffer_L_,
+                          half_kernel_gains_L_, i, accumulator_L);
+      }
+      if (!skipped_partitions_R_[i]) {
+        ConvolvePartition(modulo_index, kernel_freq_domain_buffer_R_.get(),
+                          half_kernel_freq_domain_buffer_R_,
+                          half_kernel_gains_R_, i, accumulator_R);
+      }
+    }
+  }
+  curr_front_buffer_ =
+      (curr_front_buffer_ + num_partitions_ - 1) % num_partitions_;
+}
+
+void StereoPartitionedFftFilter::Filter(
+    const FreqDomainBuffer::Channel& input) {
+  buffer_selector_ = !buffer_selector_;
+  freq_domain_accumulator_.Clear();
+  auto* accumulator_channel_L = &freq_domain_accumulator_[0];
+  auto* accumulator_channel_R = &freq_domain_accumulator_[1];
+  FilterAndAccumulate(input, accumulator_channel_L, accumulator_channel_R);
+
+  fft_manager_->TimeFromFreqDomain(
+      *accumulator_channel_L, &filtered_time_domain_buffers_[buffer_selector_]);
+  fft_manager_->TimeFromFreqDomain(
+      *accumulator_channel_R,
+      &filtered_time_domain_buffers_[kNumStereoChannels + buffer_selector_]);
+}
+
+void StereoPartitionedFftFilter::GetFilteredSignal(
+    AudioBuffer::Channel* output_L, AudioBuffer::Channel* output_R) {
+  DCHECK_NE(output_L, nullptr);
+  DCHECK_NE(output_R, nullptr);
+  DCHECK_EQ(output_L->size(), frames_per_buffer_);
+  DCHECK_EQ(output_R->size(), frames_per_buffer_);
+  OverlapAdd(filtered_time_domain_buffers_[buffer_selector_],
+             filtered_time_domain_buffers_[!buffer_selector_], output_L);
+  OverlapAdd(
+      filtered_time_domain_buffers_[kNumStereoChannels + buffer_selector_],
+      filtered_time_domain_buffers_[kNumStereoChannels + !buffer_selector_],
+      output_R);
+}
+
+}  // namespace obr
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#ifndef OBR_STEREO_PARTITIONED_FFT_FILTER_H_
+#define OBR_STEREO_PARTITIONED_FFT_FILTER_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/partitioned_fft_filter.h"
+#include "obr/audio_buffer/audio_buffer.h"
+
+namespace obr {
+
+/*!\brief Class performing a FFT-based overlap and add FIR convolution of a
+ * single input signal with a pair of (left and right ear) filter kernels.
+ *
+ * The partitioning scheme is identical to `PartitionedFftFilter`. The
+ * difference is that both kernels share a single frequency domain delay line
+ * holding the input spectrum history, so each input block needs to be
+ * transformed to the frequency domain only once and the history is stored once
+ * instead of once per ear.
+ */
+class StereoPartitionedFftFilter {
+ public:
+  // Typedef declares the data type for storing frequency domain buffers. Each
+  // channel stores the kernel for a partition.
+  typedef PartitionedFftFilter::FreqDomainBuffer FreqDomainBuffer;
+
+  // Typedef declares the data type for storing half precision frequency domain
+  // partitions.
+  typedef PartitionedFftFilter::HalfFreqDomainBuffer HalfFreqDomainBuffer;
+
+  /*!\brief Constructor preallocates memory based on the `filter_size`.
+   *
+   * \param filter_size Length of the time domain filters in samples. This will
+   *        be increased such that it becomes a multiple of
+   *        `frames_per_buffer`.
+   * \param frames_per_buffer Number of points in each time domain input buffer.
+   * \param fft_manager Pointer to a manager to perform FFT transformations.
+   */
+  StereoPartitionedFftFilter(size_t filter_size, size_t frames_per_buffer,
+                             FftManager* fft_manager);
+
+  /*!\brief Constructor preallocates memory based on the `filter_size` and
+   * stores the kernel and input spectra with the given precision.
+   *
+   * \param filter_size Length of the time domain filters in samples. This will
+   *        be increased such that it becomes a multiple of
+   *        `frames_per_buffer`.
+   * \param frames_per_buffer Number of points in each time domain input buffer.
+   * \param fft_manager Pointer to a manager to perform FFT transformations.
+   * \param precision Storage precision of the spectra.
+   */
+  StereoPartitionedFftFilter(size_t filter_size, size_t frames_per_buffer,
+                             FftManager* fft_manager,
+                             SpectrumPrecision precision);
+
+  /*!\brief Initializes the FIR filters from a pair of time domain kernels.
+   *
+   * \param kernel_L Time domain left ear filter. Samples beyond the
+   *        `filter_size` given at construction are ignored.
+   * \param kernel_R Time domain right ear filter. Samples beyond the
+   *        `filter_size` given at construction are ignored.
+   */
+  void SetTimeDomainKernels(const AudioBuffer::Channel& kernel_L,
+                            const AudioBuffer::Channel& kernel_R);
+
+  /*!\brief Initializes the FIR filters from a pair of precomputed frequency
+   * domain kernels.
+   *
+   * \param kernel_L Frequency domain left ear filter with one channel per
+   *        partition.
+   * \param kernel_R Frequency domain right ear filter with one channel per
+   *        partition.
+   */
+  void SetFreqDomainKernels(const FreqDomainBuffer& kernel_L,
+                            const FreqDomainBuffer& kernel_R);
+
+  /*!\brief Initializes the FIR filters to use a pair of read-only frequency
+   * domain kernels without copying them, so several filters can share the
+   * same kernels. The kernels are kept alive as long as this filter uses them.
+   * Filters storing kernels in half precision convert them into a copy of
+   * their own instead.
+   *
+   * \param kernel_L Frequency domain left ear filter with one channel per
+   *        partition. Must have as many partitions as this filter.
+   * \param kernel_R Frequency domain right ear filter with one channel per
+   *        partition. Must have as many partitions as this filter.
+   */
+  void SetSharedFreqDomainKernels(
+      std::shared_ptr<const FreqDomainBuffer> kernel_L,
+      std::shared_ptr<const FreqDomainBuffer> kernel_R);
+
+  /*!\brief Sets per ear masks of kernel partitions which are skipped in
+   * `FilterAndAccumulate()`, e.g. because they hold next to no energy. The
+   * masks are reset whenever new kernels are set.
+   *
+   * \param skipped_partitions_L One flag per left ear partition, true if the
+   *        partition is skipped.
+   * \param skipped_partitions_R One flag per right ear partition, true if the
+   *        partition is skipped.
+   */
+  void SetSkippedPartitions(const std::vector<bool>& skipped_partitions_L,
+                            const std::vector<bool>& skipped_partitions_R);
+
+  /*!\brief Processes a block of frequency domain samples and adds the
+   * frequency domain filter outputs to the given accumulators, without
+   * transforming them back to the time domain. As convolution is linear, the
+   * accumulated outputs of several filters can be transformed back with a
+   * single inverse FFT per ear and overlap-added using `OverlapAdd()` from
+   * `dsp_utils.h`. The size of the input block must be `fft_size_`.
+   *
+   * \param input Frequency domain input buffer.
+   * \param accumulator_L Frequency domain left ear accumulator.
+   * \param accumulator_R Frequency domain right ear accumulator.
+   */
+  void FilterAndAccumulate(const FreqDomainBuffer::Channel& input,
+                           FreqDomainBuffer::Channel* accumulator_L,
+                           FreqDomainBuffer::Channel* accumulator_R);
+
+  /*!\brief Processes a block of silence, equivalent to `FilterAndAccumulate()`
+   * with an all zero input. The silent partitions of the delay line are not
+   * convolved, so the cost decreases while the filter tail decays, and nothing
+   * is done once the whole delay line is silent.
+   *
+   * \param accumulator_L Frequency domain left ear accumulator.
+   * \param accumulator_R Frequency domain right ear accumulator.
+   */
+  void FilterSilenceAndAccumulate(FreqDomainBuffer::Channel* accumulator_L,
+                                  FreqDomainBuffer::Channel* accumulator_R);
+
+  /*!\brief Processes a block of frequency domain samples. The size of the input
+   * block must be `fft_size_`.
+   *
+   * \param input Frequency domain input buffer.
+   */
+  void Filter(const FreqDomainBuffer::Channel& input);
+
+  /*!\brief Returns blocks of filtered signal output of size
+   * `frames_per_buffer_`.
+   *
+   * \param output_L Time domain block filtered with the left ear kernel.
+   * \param output_R Time domain block filtered with the right ear kernel.
+   */
+  void GetFilteredSignal(AudioBuffer::Channel* output_L,
+                         AudioBuffer::Channel* output_R);
+
+  /*!\brief Resets the filter state.
+   */
+  void Clear();
+
+ private:
+  /*!\brief Converts a time domain kernel into partitioned frequency domain
+   * representation.
+   *
+   * \param kernel Time domain filter.
+   * \param kernel_freq_domain_buffer Frequency domain output, one channel per
+   *        partition.
+   */
+  void PartitionKernel(const AudioBuffer::Channel& kernel,
+                       FreqDomainBuffer* kernel_freq_domain_buffer);
+
+  /*!\brief Uses a pair of frequency domain kernels, converting them to the
+   * storage precision, and resets the skipped partitions.
+   *
+   * \param kernel_L Frequency domain left ear filter.
+   * \param kernel_R Frequency domain right ear filter.
+   */
+  void UseKernels(std::shared_ptr<const FreqDomainBuffer> kernel_L,
+                  std::shared_ptr<const FreqDomainBuffer> kernel_R);
+
+  /*!\brief Converts a frequency domain kernel to half precision.
+   *
+   * \param kernel Frequency domain filter with up to `num_partitions_`
+   *        partitions. Missing partitions are set to zero.
+   * \param half_kernel Half precision output, `num_partitions_` partitions.
+   * \param half_kernel_gains Gains the partitions were scaled with.
+   */
+  void HalfFromKernel(const FreqDomainBuffer& kernel,
+                      HalfFreqDomainBuffer* half_kernel,
+                      std::vector<float>* half_kernel_gains);
+
+  /*!\brief Convolves a partition of the input history with a kernel partition
+   * and accumulates the product.
+   *
+   * \param history_index Partition index in the input history.
+   * \param kernel Float kernel, null unless the precision is `kFloat`.
+   * \param half_kernel Half precision kernel.
+   * \param half_kernel_gains Gains of the half precision kernel partitions.
+   * \param partition Partition index in the kernel.
+   * \param accumulator Frequency domain accumulator.
+   */
+  void ConvolvePartition(size_t history_index, const FreqDomainBuffer* kernel,
+                         const HalfFreqDomainBuffer& half_kernel,
+                         const std::vector<float>& half_kernel_gains,
+                         size_t partition,
+                         FreqDomainBuffer::Channel* accumulator);
+
+  /*!\brief Convolves the input history from `first_partition` on with the
+   * kernels, accumulates the products and advances the delay line.
+   *
+   * \param first_partition Index of the first partition to convolve, earlier
+   *        partitions are silent.
+   * \param accumulator_L Frequency domain left ear accumulator.
+   * \param accumulator_R Frequency domain right ear accumulator.
+   */
+  void AccumulatePartitions(size_t first_partition,
+                            FreqDomainBuffer::Channel* accumulator_L,
+                            FreqDomainBuffer::Channel* accumulator_R);
+
+  // Manager for all FFT related functionality (not owned).
+  FftManager* const fft_manager_;
+
+  // Number of points in the `fft_manager_`s FFT.
+  const size_t fft_size_;
+
+  // Size of each partition of the filter in time domain.
+  const size_t chunk_size_;
+
+  // Number of frames in each buffer of input data.
+  const size_t frames_per_buffer_;
+
+  // Filter size in samples.
+  const size_t filter_size_;
+
+  // Partition Count.
+  const size_t num_partitions_;
+
+  // Storage precision of the kernel and input history spectra.
+  const SpectrumPrecision precision_;
+
+  // Left and right ear kernel buffers in frequency domain, either owned by
+  // this filter or shared with other filters. Null until kernels are set and
+  // unless the precision is `kFloat`.
+  std::shared_ptr<const FreqDomainBuffer> kernel_freq_domain_buffer_L_,
+      kernel_freq_domain_buffer_R_;
+
+  // Left and right ear half precision kernel partitions and the gains they
+  // were scaled with. All zero until kernels are set and empty if the
+  // precision is `kFloat`.
+  HalfFreqDomainBuffer half_kernel_freq_domain_buffer_L_,
+      half_kernel_freq_domain_buffer_R_;
+  std::vector<float> half_kernel_gains_L_, half_kernel_gains_R_;
+
+  // Flags marking the left and right ear kernel partitions which are not
+  // convolved.
+  std::vector<bool> skipped_partitions_L_, skipped_partitions_R_;
+
+  // Buffer selector to switch between two filtered signal buffers.
+  size_t buffer_selector_;
+
+  // The freq_domain_buffer we will write new incoming audio into.
+  size_t curr_front_buffer_;
+
+  // Number of most recent partitions of the delay line which hold silence.
+  size_t num_silent_partitions_;
+
+  // Frequency domain delay line shared by both ears. Empty with
+  // `kHalfKernelsAndHistory`.
+  FreqDomainBuffer freq_domain_buffer_;
+
+  // Half precision delay line and the gains its partitions were scaled with.
+  // Only used with `kHalfKernelsAndHistory`.
+  HalfFreqDomainBuffer half_freq_domain_buffer_;
+  std::vector<float> half_freq_domain_gains_;
+
+  // Two buffers per ear that are consecutively filled with filtered signal
+  // output. Channel `2 * ear + buffer_selector_` holds the latest output.
+  AudioBuffer filtered_time_domain_buffers_;
+
+  // Accumulators for the outputs from each convolution partition, one channel
+  // per ear.
+  FreqDomainBuffer freq_domain_accumulator_;
+
+  // Temporary time domain buffer to hold time domain kernel chunks during
+  // conversion of a kernel from time to frequency domain.
+  AudioBuffer temp_kernel_chunk_buffer_;
+};
+
+}  // namespace obr
+
+#endif  // OBR_STEREO_PARTITIONED_FFT_FILTER_H_
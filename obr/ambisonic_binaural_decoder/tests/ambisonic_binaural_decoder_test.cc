@@ -8,6 +8,7 @@
 
 #include "obr/ambisonic_binaural_decoder/ambisonic_binaural_decoder.h"
 
+#include <cmath>
 #include <cstddef>
 #include <vector>
 
@@ -64,6 +65,14 @@ void ConvertLeftToRightHrirs(const AudioBuffer& sh_hrirs_L,
 // Number of frames in each audio input/output buffer.
 const size_t kFramesPerBuffer = 18;
 
+// Fills a channel with a deterministic pseudo random sequence in [-1, 1].
+void FillWithNoise(unsigned int seed, AudioBuffer::Channel* channel) {
+  for (float& sample : *channel) {
+    seed = seed * 1664525u + 1013904223u;
+    sample = static_cast<float>(seed >> 8) / static_cast<float>(1 << 23) - 1.0f;
+  }
+}
+
 // Tests whether binaural docoding of Ambisonic input using short HRIR filters
 // (shorter than the number of frames per buffer) gives correct results.
 TEST(AmbisonicBinauralDecoderTest, ShortFilterTest) {
@@ -190,6 +199,266 @@ TEST(AmbisonicBinauralDecoderTest, LongSizeFilterTest) {
   }
 }
 
+// Tests that all convolution modes give the same results as the default
+// uniformly partitioned convolution over several buffers.
+TEST(AmbisonicBinauralDecoderTest, ConvolutionModesTest) {
+  const size_t kNumBuffers = 8;
+  const size_t kFilterSize = 5 * kFramesPerBuffer + 3;
+  const float kModeEpsilon = 1e-4f;
+  const std::vector<std::vector<float>> kInputData = GenerateAudioData(
+      kNumFirstOrderAmbisonicChannels, kNumBuffers * kFramesPerBuffer);
+  const std::vector<std::vector<float>> kHrirData =
+      GenerateAudioData(kNumFirstOrderAmbisonicChannels, kFilterSize);
+
+  AudioBuffer sh_hrirs_L(kHrirData.size(), kHrirData[0].size());
+  sh_hrirs_L = kHrirData;
+  AudioBuffer sh_hrirs_R(kHrirData.size(), kHrirData[0].size());
+  ConvertLeftToRightHrirs(sh_hrirs_L, &sh_hrirs_R);
+
+  std::vector<AmbisonicBinauralDecoderOptions> options(8);
+  options[0].convolution_mode = ConvolutionMode::kNonUniformPartitioned;
+  options[0].max_partition_size = 4 * kFramesPerBuffer;
+  options[1].convolution_mode = ConvolutionMode::kTimeDomainHead;
+  options[1].head_size = 7;
+  options[2].convolution_mode = ConvolutionMode::kTimeDomainHead;
+  options[2].head_size = 2 * kFramesPerBuffer + 1;
+  options[3].convolution_mode = ConvolutionMode::kTimeDomainHead;
+  options[3].head_size = kFilterSize;
+  options[4].num_threads = 2;
+  // More threads than channels.
+  options[5].num_threads = 8;
+  options[6].symmetric_sh_hrirs = true;
+  options[7].symmetric_sh_hrirs = true;
+  options[7].num_threads = 3;
+
+  for (const auto& decoder_options : options) {
+    FftManager fft_manager(kFramesPerBuffer);
+    AmbisonicBinauralDecoder reference_decoder(sh_hrirs_L, sh_hrirs_R,
+                                               kFramesPerBuffer, &fft_manager);
+    AmbisonicBinauralDecoder decoder(sh_hrirs_L, sh_hrirs_R, kFramesPerBuffer,
+                                     &fft_manager, decoder_options);
+
+    AudioBuffer input(kNumFirstOrderAmbisonicChannels, kFramesPerBuffer);
+    AudioBuffer reference_output(kNumStereoChannels, kFramesPerBuffer);
+    AudioBuffer output(kNumStereoChannels, kFramesPerBuffer);
+    for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+      for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+           ++channel) {
+        for (size_t sample = 0; sample < kFramesPerBuffer; ++sample) {
+          input[channel][sample] =
+              kInputData[channel][buffer * kFramesPerBuffer + sample];
+        }
+      }
+      reference_decoder.ProcessAudioBuffer(input, &reference_output);
+      decoder.ProcessAudioBuffer(input, &output);
+      for (size_t sample = 0; sample < kFramesPerBuffer; ++sample) {
+        EXPECT_NEAR(reference_output[0][sample], output[0][sample],
+                    kModeEpsilon * std::abs(reference_output[0][sample]) +
+                        kEpsilonFloat);
+        EXPECT_NEAR(reference_output[1][sample], output[1][sample],
+                    kModeEpsilon * std::abs(reference_output[1][sample]) +
+                        kEpsilonFloat);
+      }
+    }
+  }
+}
+
+// Tests that kernel pruning skips silent and near silent partitions, reports
+// the saved work and barely changes the output.
+TEST(AmbisonicBinauralDecoderTest, KernelPruningTest) {
+  const size_t kNumBuffers = 10;
+  const size_t kNumPartitions = 6;
+  const size_t kFilterSize = kNumPartitions * kFramesPerBuffer;
+  const float kPruningEpsilon = 1e-3f;
+
+  // Channel 1 has a near silent third partition, channel 3 is silent after the
+  // first partition. All other partitions have similar energy.
+  AudioBuffer sh_hrirs_L(kNumFirstOrderAmbisonicChannels, kFilterSize);
+  for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+       ++channel) {
+    FillWithNoise(static_cast<unsigned int>(channel), &sh_hrirs_L[channel]);
+  }
+  for (size_t frame = 0; frame < kFramesPerBuffer; ++frame) {
+    sh_hrirs_L[1][2 * kFramesPerBuffer + frame] *= 1e-5f;
+  }
+  for (size_t frame = kFramesPerBuffer; frame < kFilterSize; ++frame) {
+    sh_hrirs_L[3][frame] = 0.0f;
+  }
+  AudioBuffer sh_hrirs_R(kNumFirstOrderAmbisonicChannels, kFilterSize);
+  ConvertLeftToRightHrirs(sh_hrirs_L, &sh_hrirs_R);
+
+  for (const bool symmetric : {false, true}) {
+    AmbisonicBinauralDecoderOptions options;
+    options.symmetric_sh_hrirs = symmetric;
+    FftManager fft_manager(kFramesPerBuffer);
+    AmbisonicBinauralDecoder reference_decoder(
+        sh_hrirs_L, sh_hrirs_R, kFramesPerBuffer, &fft_manager, options);
+    options.prune_kernels = true;
+    options.kernel_pruning_threshold_db = -60.0f;
+    AmbisonicBinauralDecoder decoder(sh_hrirs_L, sh_hrirs_R, kFramesPerBuffer,
+                                     &fft_manager, options);
+
+    const size_t num_ears = symmetric ? 1 : 2;
+    const size_t flops_per_partition = 4 * fft_manager.GetFftSize();
+    EXPECT_EQ(reference_decoder.GetKernelPruningStats().num_skipped_partitions,
+              0U);
+    const KernelPruningStats& stats = decoder.GetKernelPruningStats();
+    EXPECT_EQ(stats.num_partitions,
+              num_ears * kNumFirstOrderAmbisonicChannels * kNumPartitions);
+    EXPECT_EQ(stats.num_skipped_partitions, num_ears * 6);
+    EXPECT_EQ(stats.flops_per_buffer,
+              stats.num_partitions * flops_per_partition);
+    EXPECT_EQ(stats.saved_flops_per_buffer,
+              stats.num_skipped_partitions * flops_per_partition);
+
+    AudioBuffer input(kNumFirstOrderAmbisonicChannels, kFramesPerBuffer);
+    AudioBuffer reference_output(kNumStereoChannels, kFramesPerBuffer);
+    AudioBuffer output(kNumStereoChannels, kFramesPerBuffer);
+    for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+      for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+           ++channel) {
+        FillWithNoise(static_cast<unsigned int>(10 * buffer + channel),
+                      &input[channel]);
+      }
+      reference_decoder.ProcessAudioBuffer(input, &reference_output);
+      decoder.ProcessAudioBuffer(input, &output);
+      for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+        for (size_t sample = 0; sample < kFramesPerBuffer; ++sample) {
+          EXPECT_NEAR(reference_output[ear][sample], output[ear][sample],
+                      kPruningEpsilon);
+        }
+      }
+    }
+  }
+}
+
+// Tests that the hybrid decoder with a shared late tail reproduces the full
+// convolution when only the W channel SH-HRIRs extend beyond the crossfade, as
+// the tail then needs no energy correction and the crossfade sums to one.
+TEST(AmbisonicBinauralDecoderTest, SharedLateTailTest) {
+  const size_t kNumBuffers = 16;
+  const size_t kFilterSize = 10 * kFramesPerBuffer;
+  const size_t kEarlySize = 4 * kFramesPerBuffer;
+  const size_t kCrossfadeSize = 20;
+  const float kLateTailEpsilon = 1e-3f;
+
+  AudioBuffer sh_hrirs_L(kNumFirstOrderAmbisonicChannels, kFilterSize);
+  AudioBuffer sh_hrirs_R(kNumFirstOrderAmbisonicChannels, kFilterSize);
+  for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+       ++channel) {
+    FillWithNoise(static_cast<unsigned int>(channel), &sh_hrirs_L[channel]);
+    FillWithNoise(static_cast<unsigned int>(channel + 10),
+                  &sh_hrirs_R[channel]);
+    if (channel > 0) {
+      for (size_t frame = kEarlySize - kCrossfadeSize; frame < kFilterSize;
+           ++frame) {
+        sh_hrirs_L[channel][frame] = 0.0f;
+        sh_hrirs_R[channel][frame] = 0.0f;
+      }
+    }
+  }
+
+  AmbisonicBinauralDecoderOptions options;
+  options.shared_late_tail = true;
+  options.early_size = kEarlySize;
+  options.late_tail_crossfade_size = kCrossfadeSize;
+  options.max_partition_size = 2 * kFramesPerBuffer;
+  FftManager fft_manager(kFramesPerBuffer);
+  AmbisonicBinauralDecoder reference_decoder(sh_hrirs_L, sh_hrirs_R,
+                                             kFramesPerBuffer, &fft_manager);
+  AmbisonicBinauralDecoder decoder(sh_hrirs_L, sh_hrirs_R, kFramesPerBuffer,
+                                   &fft_manager, options);
+  EXPECT_EQ(decoder.GetKernelPruningStats().num_partitions,
+            kNumBinauralChannels * kNumFirstOrderAmbisonicChannels *
+                kEarlySize / kFramesPerBuffer);
+
+  AudioBuffer input(kNumFirstOrderAmbisonicChannels, kFramesPerBuffer);
+  AudioBuffer reference_output(kNumStereoChannels, kFramesPerBuffer);
+  AudioBuffer output(kNumStereoChannels, kFramesPerBuffer);
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+         ++channel) {
+      FillWithNoise(static_cast<unsigned int>(10 * buffer + channel),
+                    &input[channel]);
+    }
+    reference_decoder.ProcessAudioBuffer(input, &reference_output);
+    decoder.ProcessAudioBuffer(input, &output);
+    for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+      for (size_t sample = 0; sample < kFramesPerBuffer; ++sample) {
+        EXPECT_NEAR(reference_output[ear][sample], output[ear][sample],
+                    kLateTailEpsilon);
+      }
+    }
+  }
+}
+
+// Tests that disabled input channels are decoded like silent channels in all
+// convolution modes, including after long silences and on reactivation.
+TEST(AmbisonicBinauralDecoderTest, DisabledChannelsTest) {
+  const size_t kNumBuffers = 24;
+  const size_t kFilterSize = 5 * kFramesPerBuffer + 3;
+
+  AudioBuffer sh_hrirs_L(kNumFirstOrderAmbisonicChannels, kFilterSize);
+  AudioBuffer sh_hrirs_R(kNumFirstOrderAmbisonicChannels, kFilterSize);
+  for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+       ++channel) {
+    FillWithNoise(static_cast<unsigned int>(channel), &sh_hrirs_L[channel]);
+    FillWithNoise(static_cast<unsigned int>(channel + 10),
+                  &sh_hrirs_R[channel]);
+  }
+
+  std::vector<AmbisonicBinauralDecoderOptions> options(6);
+  options[1].symmetric_sh_hrirs = true;
+  options[2].num_threads = 2;
+  options[3].convolution_mode = ConvolutionMode::kNonUniformPartitioned;
+  options[3].max_partition_size = 2 * kFramesPerBuffer;
+  options[4].convolution_mode = ConvolutionMode::kTimeDomainHead;
+  options[4].head_size = 7;
+  options[5].shared_late_tail = true;
+  options[5].early_size = 2 * kFramesPerBuffer;
+  options[5].late_tail_crossfade_size = 8;
+
+  for (const auto& decoder_options : options) {
+    FftManager fft_manager(kFramesPerBuffer);
+    AmbisonicBinauralDecoder reference_decoder(sh_hrirs_L, sh_hrirs_R,
+                                               kFramesPerBuffer, &fft_manager,
+                                               decoder_options);
+    AmbisonicBinauralDecoder decoder(sh_hrirs_L, sh_hrirs_R, kFramesPerBuffer,
+                                     &fft_manager, decoder_options);
+
+    AudioBuffer reference_input(kNumFirstOrderAmbisonicChannels,
+                                kFramesPerBuffer);
+    AudioBuffer input(kNumFirstOrderAmbisonicChannels, kFramesPerBuffer);
+    AudioBuffer reference_output(kNumStereoChannels, kFramesPerBuffer);
+    AudioBuffer output(kNumStereoChannels, kFramesPerBuffer);
+    for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+      input.Clear();
+      reference_input.Clear();
+      for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+           ++channel) {
+        // All channels are silent for longer than the filter in between.
+        const bool is_active =
+            (buffer < 8 || buffer >= 16) && (buffer + channel) % 3 != 0;
+        if (is_active) {
+          FillWithNoise(static_cast<unsigned int>(10 * buffer + channel),
+                        &reference_input[channel]);
+          input[channel] = reference_input[channel];
+        } else {
+          input[channel].SetEnabled(false);
+        }
+      }
+      reference_decoder.ProcessAudioBuffer(reference_input, &reference_output);
+      decoder.ProcessAudioBuffer(input, &output);
+      for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+        for (size_t sample = 0; sample < kFramesPerBuffer; ++sample) {
+          EXPECT_NEAR(reference_output[ear][sample], output[ear][sample],
+                      kEpsilonFloat);
+        }
+      }
+    }
+  }
+}
+
 }  // namespace
 
 }  // namespace obr
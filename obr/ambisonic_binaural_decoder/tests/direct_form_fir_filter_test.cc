@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/ambisonic_binaural_decoder/direct_form_fir_filter.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
+
+namespace obr {
+
+namespace {
+
+// Permitted error between the filter output and the reference convolution.
+const float kEpsilon = 1e-5f;
+
+// Fills a channel with a deterministic pseudo random sequence in [-1, 1].
+void FillWithNoise(unsigned int seed, AudioBuffer::Channel* channel) {
+  for (float& sample : *channel) {
+    seed = seed * 1664525u + 1013904223u;
+    sample = static_cast<float>(seed >> 8) / static_cast<float>(1 << 23) - 1.0f;
+  }
+}
+
+// Tests that the filter output matches a reference convolution of the leading
+// kernel taps, summed over all input channels, for filters shorter and longer
+// than the buffer size.
+TEST(DirectFormFirFilterTest, MatchesReferenceConvolution) {
+  const size_t kNumChannels = 3;
+  const size_t kKernelSize = 40;
+  const size_t kNumBuffers = 10;
+  const std::vector<size_t> kBufferSizes = {5, 16, 33};
+  const std::vector<size_t> kFilterSizes = {1, 7, 40};
+
+  AudioBuffer kernels_L(kNumChannels, kKernelSize);
+  AudioBuffer kernels_R(kNumChannels, kKernelSize);
+  for (size_t channel = 0; channel < kNumChannels; ++channel) {
+    FillWithNoise(static_cast<unsigned int>(channel), &kernels_L[channel]);
+    FillWithNoise(static_cast<unsigned int>(channel + kNumChannels),
+                  &kernels_R[channel]);
+  }
+
+  for (const size_t buffer_size : kBufferSizes) {
+    for (const size_t filter_size : kFilterSizes) {
+      const size_t signal_size = kNumBuffers * buffer_size;
+      AudioBuffer signal(kNumChannels, signal_size);
+      for (size_t channel = 0; channel < kNumChannels; ++channel) {
+        FillWithNoise(static_cast<unsigned int>(10 + channel),
+                      &signal[channel]);
+      }
+
+      std::vector<float> expected_L(signal_size, 0.0f);
+      std::vector<float> expected_R(signal_size, 0.0f);
+      for (size_t channel = 0; channel < kNumChannels; ++channel) {
+        for (size_t n = 0; n < signal_size; ++n) {
+          for (size_t k = 0; k < filter_size && k <= n; ++k) {
+            expected_L[n] += signal[channel][n - k] * kernels_L[channel][k];
+            expected_R[n] += signal[channel][n - k] * kernels_R[channel][k];
+          }
+        }
+      }
+
+      DirectFormFirFilter filter(kernels_L, kernels_R, filter_size,
+                                 buffer_size);
+      AudioBuffer input(kNumChannels, buffer_size);
+      AudioBuffer output(kNumStereoChannels, buffer_size);
+      for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+        const size_t begin = buffer * buffer_size;
+        for (size_t channel = 0; channel < kNumChannels; ++channel) {
+          for (size_t frame = 0; frame < buffer_size; ++frame) {
+            input[channel][frame] = signal[channel][begin + frame];
+          }
+        }
+        filter.Process(input, &output);
+        for (size_t frame = 0; frame < buffer_size; ++frame) {
+          EXPECT_NEAR(output[0][frame], expected_L[begin + frame], kEpsilon);
+          EXPECT_NEAR(output[1][frame], expected_R[begin + frame], kEpsilon);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+}  // namespace obr
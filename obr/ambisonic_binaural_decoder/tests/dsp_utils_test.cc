@@ -64,6 +64,28 @@ TEST(DspUtilsTest, GenerateHannWindowOddLengthTest) {
   }
 }
 
+// Tests that the overlap-add sums the head of the current block with the
+// samples following the hop in the previous block, for both a hop size of half
+// the block size and a smaller hop size.
+TEST(DspUtilsTest, OverlapAddTest) {
+  const size_t kBlockSize = 32;
+  const std::vector<size_t> kHopSizes = {16, 15, 7};
+
+  AudioBuffer blocks(kNumStereoChannels, kBlockSize);
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    blocks[0][i] = static_cast<float>(i);
+    blocks[1][i] = 100.0f * static_cast<float>(i);
+  }
+  for (const size_t hop_size : kHopSizes) {
+    AudioBuffer output(kNumMonoChannels, hop_size);
+    OverlapAdd(blocks[0], blocks[1], &output[0]);
+    for (size_t i = 0; i < hop_size; ++i) {
+      const float expected = blocks[0][i] + blocks[1][i + hop_size];
+      EXPECT_FLOAT_EQ(output[0][i], expected);
+    }
+  }
+}
+
 }  // namespace
 
 }  // namespace obr
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/ambisonic_binaural_decoder/kernel_cache.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "gtest/gtest.h"
+#include "obr/ambisonic_binaural_decoder/ambisonic_binaural_decoder.h"
+#include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
+
+namespace obr {
+
+namespace {
+
+const size_t kNumFirstOrderAmbisonicChannels = 4;
+const size_t kFramesPerBuffer = 64;
+const size_t kFilterSize = 200;
+
+// Fills a channel with deterministic pseudo-random samples in [-1, 1).
+void FillWithNoise(unsigned int seed, AudioBuffer::Channel* channel) {
+  for (float& sample : *channel) {
+    seed = seed * 1664525u + 1013904223u;
+    sample = static_cast<float>(seed >> 8) / static_cast<float>(1 << 23) - 1.0f;
+  }
+}
+
+class KernelCacheTest : public ::testing::Test {
+ protected:
+  KernelCacheTest()
+      : directory_(std::filesystem::temp_directory_path() /
+                   ("obr_kernel_cache_test_" +
+                    std::string(::testing::UnitTest::GetInstance()
+                                    ->current_test_info()
+                                    ->name()))),
+        fft_manager_(kFramesPerBuffer),
+        sh_hrirs_(kNumFirstOrderAmbisonicChannels, kFilterSize) {
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+    for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+         ++channel) {
+      FillWithNoise(static_cast<unsigned int>(channel), &sh_hrirs_[channel]);
+    }
+    key_.ambisonic_order = 1;
+    key_.ear = 0;
+    key_.sampling_rate = 48000;
+    key_.frames_per_buffer = kFramesPerBuffer;
+    key_.asset_hash = ComputeKernelAssetHash("asset");
+  }
+
+  ~KernelCacheTest() override {
+    std::error_code error;
+    std::filesystem::remove_all(directory_, error);
+  }
+
+  const std::filesystem::path directory_;
+  FftManager fft_manager_;
+  AudioBuffer sh_hrirs_;
+  KernelCacheKey key_;
+};
+
+// Tests that stored kernels are loaded back unchanged.
+TEST_F(KernelCacheTest, StoreAndLoadTest) {
+  const PartitionedFreqDomainKernels kernels =
+      ComputePartitionedFreqDomainKernels(sh_hrirs_, kFramesPerBuffer,
+                                          &fft_manager_);
+  ASSERT_EQ(kernels.size(), kNumFirstOrderAmbisonicChannels);
+  ASSERT_EQ(kernels[0].num_channels(), 4U);
+
+  KernelCache cache(directory_.string());
+  EXPECT_TRUE(absl::IsNotFound(
+      cache.Load(key_, fft_manager_.GetFftSize()).status()));
+  ASSERT_TRUE(cache.Store(key_, kernels).ok());
+  EXPECT_TRUE(std::filesystem::exists(cache.GetFilePath(key_)));
+
+  const absl::StatusOr<PartitionedFreqDomainKernels> loaded_kernels =
+      cache.Load(key_, fft_manager_.GetFftSize());
+  ASSERT_TRUE(loaded_kernels.ok()) << loaded_kernels.status();
+  ASSERT_EQ(loaded_kernels->size(), kernels.size());
+  for (size_t channel = 0; channel < kernels.size(); ++channel) {
+    ASSERT_EQ((*loaded_kernels)[channel].num_channels(),
+              kernels[channel].num_channels());
+    for (size_t partition = 0; partition < kernels[channel].num_channels();
+         ++partition) {
+      for (size_t bin = 0; bin < fft_manager_.GetFftSize(); ++bin) {
+        EXPECT_EQ((*loaded_kernels)[channel][partition][bin],
+                  kernels[channel][partition][bin]);
+      }
+    }
+  }
+}
+
+// Tests that entries for other keys and corrupt entries are rejected.
+TEST_F(KernelCacheTest, RejectsInvalidEntriesTest) {
+  KernelCache cache(directory_.string());
+  ASSERT_TRUE(cache
+                  .Store(key_, ComputePartitionedFreqDomainKernels(
+                                   sh_hrirs_, kFramesPerBuffer, &fft_manager_))
+                  .ok());
+
+  // Different keys map to different files.
+  KernelCacheKey other_key = key_;
+  other_key.ear = 1;
+  EXPECT_NE(cache.GetFilePath(key_), cache.GetFilePath(other_key));
+  other_key = key_;
+  other_key.asset_hash = ComputeKernelAssetHash("other asset");
+  EXPECT_TRUE(absl::IsNotFound(
+      cache.Load(other_key, fft_manager_.GetFftSize()).status()));
+
+  // A file renamed to another key's name does not match that key.
+  std::filesystem::copy_file(cache.GetFilePath(key_),
+                             cache.GetFilePath(other_key));
+  EXPECT_TRUE(absl::IsFailedPrecondition(
+      cache.Load(other_key, fft_manager_.GetFftSize()).status()));
+
+  // Spectra in the bin order of another SIMD size do not match either.
+  other_key = key_;
+  other_key.fft_simd_size = key_.fft_simd_size == 1 ? 4 : 1;
+  EXPECT_NE(cache.GetFilePath(key_), cache.GetFilePath(other_key));
+  std::filesystem::copy_file(cache.GetFilePath(key_),
+                             cache.GetFilePath(other_key));
+  EXPECT_TRUE(absl::IsFailedPrecondition(
+      cache.Load(other_key, fft_manager_.GetFftSize()).status()));
+
+  // The FFT size must match as well.
+  EXPECT_TRUE(absl::IsFailedPrecondition(
+      cache.Load(key_, 2 * fft_manager_.GetFftSize()).status()));
+
+  // Truncated files are rejected.
+  std::filesystem::resize_file(
+      cache.GetFilePath(key_),
+      std::filesystem::file_size(cache.GetFilePath(key_)) - sizeof(float));
+  EXPECT_TRUE(absl::IsDataLoss(
+      cache.Load(key_, fft_manager_.GetFftSize()).status()));
+
+  // Files with a different format are rejected.
+  std::ofstream(cache.GetFilePath(key_), std::ios::trunc)
+      << "not a kernel cache file, but long enough to hold a header";
+  EXPECT_TRUE(absl::IsDataLoss(
+      cache.Load(key_, fft_manager_.GetFftSize()).status()));
+}
+
+// Tests that a decoder created from cached kernels produces the same output as
+// one created from the time domain SH-HRIRs.
+TEST_F(KernelCacheTest, DecoderFromCachedKernelsTest) {
+  AudioBuffer sh_hrirs_R(kNumFirstOrderAmbisonicChannels, kFilterSize);
+  for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+       ++channel) {
+    FillWithNoise(static_cast<unsigned int>(channel + 10),
+                  &sh_hrirs_R[channel]);
+  }
+  KernelCache cache(directory_.string());
+  KernelCacheKey key_R = key_;
+  key_R.ear = 1;
+  ASSERT_TRUE(cache
+                  .Store(key_, ComputePartitionedFreqDomainKernels(
+                                   sh_hrirs_, kFramesPerBuffer, &fft_manager_))
+                  .ok());
+  ASSERT_TRUE(cache
+                  .Store(key_R, ComputePartitionedFreqDomainKernels(
+                                    sh_hrirs_R, kFramesPerBuffer,
+                                    &fft_manager_))
+                  .ok());
+  absl::StatusOr<PartitionedFreqDomainKernels> kernels_L =
+      cache.Load(key_, fft_manager_.GetFftSize());
+  absl::StatusOr<PartitionedFreqDomainKernels> kernels_R =
+      cache.Load(key_R, fft_manager_.GetFftSize());
+  ASSERT_TRUE(kernels_L.ok());
+  ASSERT_TRUE(kernels_R.ok());
+
+  AmbisonicBinauralDecoderOptions options;
+  FftManager reference_fft_manager(kFramesPerBuffer);
+  AmbisonicBinauralDecoder reference_decoder(sh_hrirs_, sh_hrirs_R,
+                                             kFramesPerBuffer,
+                                             &reference_fft_manager, options);
+  AmbisonicBinauralDecoder decoder(
+      std::make_shared<const PartitionedFreqDomainKernels>(
+          *std::move(kernels_L)),
+      std::make_shared<const PartitionedFreqDomainKernels>(
+          *std::move(kernels_R)),
+      kFramesPerBuffer, &fft_manager_, options);
+
+  AudioBuffer input(kNumFirstOrderAmbisonicChannels, kFramesPerBuffer);
+  AudioBuffer reference_output(kNumStereoChannels, kFramesPerBuffer);
+  AudioBuffer output(kNumStereoChannels, kFramesPerBuffer);
+  for (size_t buffer = 0; buffer < 6; ++buffer) {
+    for (size_t channel = 0; channel < kNumFirstOrderAmbisonicChannels;
+         ++channel) {
+      FillWithNoise(static_cast<unsigned int>(100 * buffer + channel),
+                    &input[channel]);
+    }
+    reference_decoder.ProcessAudioBuffer(input, &reference_output);
+    decoder.ProcessAudioBuffer(input, &output);
+    for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+      for (size_t sample = 0; sample < kFramesPerBuffer; ++sample) {
+        EXPECT_EQ(reference_output[ear][sample], output[ear][sample]);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+}  // namespace obr
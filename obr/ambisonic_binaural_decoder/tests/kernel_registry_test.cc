@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/ambisonic_binaural_decoder/kernel_registry.h"
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace obr {
+
+namespace {
+
+const size_t kFftSize = 64;
+
+// Creates a kernel set with one channel of `num_partitions` partitions per ear
+// and counts the calls.
+absl::StatusOr<ShHrirKernelSet> CreateKernelSet(size_t num_partitions,
+                                                size_t* num_calls) {
+  ++*num_calls;
+  ShHrirKernelSet kernel_set;
+  kernel_set.kernels_L.emplace_back(num_partitions, kFftSize);
+  kernel_set.kernels_R.emplace_back(num_partitions, kFftSize);
+  return kernel_set;
+}
+
+// Tests that kernel sets are shared between users of the same configuration and
+// released with their last user.
+TEST(KernelRegistryTest, SharesKernelSetsTest) {
+  KernelRegistry registry;
+  size_t num_calls = 0;
+  auto create = [&num_calls]() { return CreateKernelSet(2, &num_calls); };
+
+  absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>> kernel_set =
+      registry.GetOrCreate(1, 48000, 256, create);
+  ASSERT_TRUE(kernel_set.ok());
+  absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>> same_kernel_set =
+      registry.GetOrCreate(1, 48000, 256, create);
+  ASSERT_TRUE(same_kernel_set.ok());
+  EXPECT_EQ(*kernel_set, *same_kernel_set);
+  EXPECT_EQ(num_calls, 1U);
+  EXPECT_EQ(registry.GetNumKernelSets(), 1U);
+
+  // Each of order, sampling rate and frames per buffer selects another set.
+  absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>> other_kernel_sets[] = {
+      registry.GetOrCreate(2, 48000, 256, create),
+      registry.GetOrCreate(1, 44100, 256, create),
+      registry.GetOrCreate(1, 48000, 512, create)};
+  for (const auto& other_kernel_set : other_kernel_sets) {
+    ASSERT_TRUE(other_kernel_set.ok());
+    EXPECT_NE(*other_kernel_set, *kernel_set);
+  }
+  EXPECT_EQ(num_calls, 4U);
+  EXPECT_EQ(registry.GetNumKernelSets(), 4U);
+
+  // The set is created again once all users released it.
+  kernel_set->reset();
+  EXPECT_EQ(registry.GetNumKernelSets(), 4U);
+  same_kernel_set->reset();
+  EXPECT_EQ(registry.GetNumKernelSets(), 3U);
+  kernel_set = registry.GetOrCreate(1, 48000, 256, create);
+  ASSERT_TRUE(kernel_set.ok());
+  EXPECT_EQ(num_calls, 5U);
+}
+
+// Tests that kernel sets of other configurations are created while one is
+// being created, and that concurrent requests for the same configuration
+// share a single creation.
+TEST(KernelRegistryTest, ConcurrentCreationTest) {
+  KernelRegistry registry;
+  size_t num_calls = 0;
+  size_t num_other_calls = 0;
+  absl::Notification creation_started;
+  absl::Notification other_created;
+  absl::Notification finish_creation;
+  bool other_created_meanwhile = false;
+
+  absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>> kernel_set;
+  std::thread creating_thread([&]() {
+    kernel_set = registry.GetOrCreate(1, 48000, 256, [&]() {
+      creation_started.Notify();
+      other_created_meanwhile =
+          other_created.WaitForNotificationWithTimeout(absl::Seconds(10));
+      finish_creation.WaitForNotification();
+      return CreateKernelSet(2, &num_calls);
+    });
+  });
+  creation_started.WaitForNotification();
+
+  // Another configuration is not held up by the running creation.
+  absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>> other_kernel_set =
+      registry.GetOrCreate(2, 48000, 256, [&]() {
+        other_created.Notify();
+        return CreateKernelSet(2, &num_other_calls);
+      });
+  ASSERT_TRUE(other_kernel_set.ok());
+
+  // The same configuration waits for the running creation.
+  absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>> same_kernel_set;
+  std::thread waiting_thread([&]() {
+    same_kernel_set = registry.GetOrCreate(
+        1, 48000, 256, [&]() { return CreateKernelSet(2, &num_calls); });
+  });
+  finish_creation.Notify();
+  creating_thread.join();
+  waiting_thread.join();
+
+  EXPECT_TRUE(other_created_meanwhile);
+  ASSERT_TRUE(kernel_set.ok());
+  ASSERT_TRUE(same_kernel_set.ok());
+  EXPECT_EQ(*kernel_set, *same_kernel_set);
+  EXPECT_EQ(num_calls, 1U);
+  EXPECT_EQ(num_other_calls, 1U);
+  EXPECT_EQ(registry.GetNumKernelSets(), 2U);
+}
+
+// Tests that creation errors are passed on and not cached.
+TEST(KernelRegistryTest, CreationErrorTest) {
+  KernelRegistry registry;
+  absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>> kernel_set =
+      registry.GetOrCreate(1, 48000, 256, []() {
+        return absl::StatusOr<ShHrirKernelSet>(absl::NotFoundError("asset"));
+      });
+  EXPECT_TRUE(absl::IsNotFound(kernel_set.status()));
+  EXPECT_EQ(registry.GetNumKernelSets(), 0U);
+
+  size_t num_calls = 0;
+  kernel_set = registry.GetOrCreate(
+      1, 48000, 256, [&num_calls]() { return CreateKernelSet(2, &num_calls); });
+  ASSERT_TRUE(kernel_set.ok());
+  EXPECT_EQ(num_calls, 1U);
+  EXPECT_EQ((*kernel_set)->kernels_L[0].num_channels(), 2U);
+}
+
+}  // namespace
+
+}  // namespace obr
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/ambisonic_binaural_decoder/non_uniform_partitioned_fft_filter.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
+
+namespace obr {
+
+namespace {
+
+// Permitted error between the FFT-based and the direct convolution.
+const float kFftEpsilon = 1e-3f;
+
+// Fills a channel with a deterministic pseudo random sequence in [-1, 1].
+void FillWithNoise(unsigned int seed, AudioBuffer::Channel* channel) {
+  for (float& sample : *channel) {
+    seed = seed * 1664525u + 1013904223u;
+    sample = static_cast<float>(seed >> 8) / static_cast<float>(1 << 23) - 1.0f;
+  }
+}
+
+// Tests that the levels cover the kernel contiguously, that the partition
+// sizes grow geometrically up to the maximum partition size and that every
+// level starts late enough to not add latency.
+TEST(NonUniformPartitionedFftFilterTest, PartitioningTest) {
+  const size_t kFramesPerBuffer = 64;
+  const size_t kFilterSize = 8192;
+  const size_t kMaxPartitionSize = 1024;
+
+  AudioBuffer kernels(kNumMonoChannels, kFilterSize);
+  kernels.Clear();
+  NonUniformPartitionedFftFilter filter(kernels, kernels, kFramesPerBuffer,
+                                        kMaxPartitionSize, 0);
+
+  // 2 x 64, 2 x 128, 2 x 256, 2 x 512 and 7 x 1024.
+  ASSERT_EQ(filter.GetNumLevels(), 5U);
+  size_t offset = 0;
+  for (size_t level = 0; level < filter.GetNumLevels(); ++level) {
+    EXPECT_EQ(filter.GetPartitionSize(level), kFramesPerBuffer << level);
+    EXPECT_EQ(filter.GetOffset(level), offset);
+    EXPECT_GE(filter.GetOffset(level) + kFramesPerBuffer,
+              filter.GetPartitionSize(level));
+    offset += filter.GetNumPartitions(level) * filter.GetPartitionSize(level);
+  }
+  EXPECT_EQ(filter.GetNumPartitions(4), 7U);
+  EXPECT_GE(offset, kFilterSize);
+
+  // A maximum partition size below the buffer size gives a uniform
+  // partitioning.
+  NonUniformPartitionedFftFilter uniform_filter(kernels, kernels,
+                                                kFramesPerBuffer, 0, 0);
+  ASSERT_EQ(uniform_filter.GetNumLevels(), 1U);
+  EXPECT_EQ(uniform_filter.GetNumPartitions(0), kFilterSize / kFramesPerBuffer);
+}
+
+// Tests that the filter output matches a direct time domain convolution of a
+// multi-channel input, summed over all channels, without added latency. Covers
+// power of two and non power of two buffer sizes.
+TEST(NonUniformPartitionedFftFilterTest, MatchesDirectConvolution) {
+  const size_t kNumChannels = 4;
+  const size_t kFilterSize = 700;
+  const size_t kMaxPartitionSize = 128;
+  const size_t kNumBuffers = 60;
+  const std::vector<size_t> kBufferSizes = {16, 15};
+
+  AudioBuffer kernels_L(kNumChannels, kFilterSize);
+  AudioBuffer kernels_R(kNumChannels, kFilterSize);
+  for (size_t channel = 0; channel < kNumChannels; ++channel) {
+    FillWithNoise(static_cast<unsigned int>(channel), &kernels_L[channel]);
+    FillWithNoise(static_cast<unsigned int>(channel + kNumChannels),
+                  &kernels_R[channel]);
+  }
+
+  for (const size_t buffer_size : kBufferSizes) {
+    const size_t signal_size = kNumBuffers * buffer_size;
+    AudioBuffer signal(kNumChannels, signal_size);
+    for (size_t channel = 0; channel < kNumChannels; ++channel) {
+      FillWithNoise(static_cast<unsigned int>(100 + channel), &signal[channel]);
+    }
+
+    // Direct convolution reference.
+    std::vector<float> expected_L(signal_size, 0.0f);
+    std::vector<float> expected_R(signal_size, 0.0f);
+    for (size_t channel = 0; channel < kNumChannels; ++channel) {
+      for (size_t n = 0; n < signal_size; ++n) {
+        for (size_t k = 0; k < kFilterSize && k <= n; ++k) {
+          expected_L[n] += signal[channel][n - k] * kernels_L[channel][k];
+          expected_R[n] += signal[channel][n - k] * kernels_R[channel][k];
+        }
+      }
+    }
+
+    NonUniformPartitionedFftFilter filter(kernels_L, kernels_R, buffer_size,
+                                          kMaxPartitionSize, 0);
+    EXPECT_GT(filter.GetNumLevels(), 1U);
+    AudioBuffer input(kNumChannels, buffer_size);
+    AudioBuffer output(kNumStereoChannels, buffer_size);
+    for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+      const size_t begin = buffer * buffer_size;
+      for (size_t channel = 0; channel < kNumChannels; ++channel) {
+        for (size_t frame = 0; frame < buffer_size; ++frame) {
+          input[channel][frame] = signal[channel][begin + frame];
+        }
+      }
+      filter.Process(input, &output);
+      for (size_t frame = 0; frame < buffer_size; ++frame) {
+        EXPECT_NEAR(output[0][frame], expected_L[begin + frame], kFftEpsilon);
+        EXPECT_NEAR(output[1][frame], expected_R[begin + frame], kFftEpsilon);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+}  // namespace obr
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/partitioned_fft_filter.h"
+#include "obr/ambisonic_binaural_decoder/stereo_partitioned_fft_filter.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
+
+namespace obr {
+namespace {
+
+// Measure the frequency domain multiply-accumulates of a 7th order decoder,
+// which are bound by memory bandwidth, for each storage precision of the
+// spectra.
+void BM_StereoFilterAndAccumulate(benchmark::State& state) {
+  const size_t buffer_size_per_channel = 256;
+  const size_t filter_size = 4096;
+  const size_t number_of_channels = 64;
+  const SpectrumPrecision precision =
+      static_cast<SpectrumPrecision>(state.range(0));
+
+  // Create a filter per channel with a decaying kernel.
+  FftManager fft_manager(buffer_size_per_channel);
+  AudioBuffer kernels(kNumStereoChannels, filter_size);
+  for (size_t frame = 0; frame < filter_size; ++frame) {
+    const float decay = std::exp(-static_cast<float>(frame) / 1000.0f);
+    kernels[0][frame] = decay * std::sin(0.1f * static_cast<float>(frame));
+    kernels[1][frame] = decay * std::cos(0.2f * static_cast<float>(frame));
+  }
+  std::vector<std::unique_ptr<StereoPartitionedFftFilter>> filters;
+  for (size_t channel = 0; channel < number_of_channels; ++channel) {
+    filters.emplace_back(new StereoPartitionedFftFilter(
+        filter_size, buffer_size_per_channel, &fft_manager, precision));
+    filters.back()->SetTimeDomainKernels(kernels[0], kernels[1]);
+  }
+
+  // Create the input spectrum and the accumulators.
+  AudioBuffer input(kNumMonoChannels, buffer_size_per_channel);
+  for (size_t frame = 0; frame < buffer_size_per_channel; ++frame) {
+    input[0][frame] = std::sin(0.05f * static_cast<float>(frame));
+  }
+  PartitionedFftFilter::FreqDomainBuffer freq_input(kNumMonoChannels,
+                                                    fft_manager.GetFftSize());
+  fft_manager.FreqFromTimeDomain(input[0], &freq_input[0]);
+  PartitionedFftFilter::FreqDomainBuffer accumulators(
+      kNumStereoChannels, fft_manager.GetFftSize());
+
+  for (auto _ : state) {
+    accumulators.Clear();
+    for (const auto& filter : filters) {
+      filter->FilterAndAccumulate(freq_input[0], &accumulators[0],
+                                  &accumulators[1]);
+    }
+    benchmark::DoNotOptimize(accumulators[0][0]);
+  }
+}
+
+BENCHMARK(BM_StereoFilterAndAccumulate)
+    ->Arg(static_cast<int>(SpectrumPrecision::kFloat))
+    ->Arg(static_cast<int>(SpectrumPrecision::kHalfKernels))
+    ->Arg(static_cast<int>(SpectrumPrecision::kHalfKernelsAndHistory));
+
+// Measure a full filter pass of a block, from the forward FFT to the
+// overlap-added output, for a non power of two block size (10 ms at 48 kHz)
+// and the next power of two. Both use the same FFT size, so the throughput per
+// frame shows the overhead of the zero padded FFT chunks.
+void BM_FilterBlock(benchmark::State& state) {
+  const size_t frames_per_buffer = static_cast<size_t>(state.range(0));
+  const size_t filter_size = 4096;
+
+  FftManager fft_manager(frames_per_buffer);
+  AudioBuffer kernel(kNumMonoChannels, filter_size);
+  for (size_t frame = 0; frame < filter_size; ++frame) {
+    kernel[0][frame] = std::exp(-static_cast<float>(frame) / 1000.0f) *
+                       std::sin(0.1f * static_cast<float>(frame));
+  }
+  PartitionedFftFilter filter(filter_size, frames_per_buffer, &fft_manager);
+  filter.SetTimeDomainKernel(kernel[0]);
+
+  AudioBuffer input(kNumMonoChannels, frames_per_buffer);
+  for (size_t frame = 0; frame < frames_per_buffer; ++frame) {
+    input[0][frame] = std::sin(0.05f * static_cast<float>(frame));
+  }
+  PartitionedFftFilter::FreqDomainBuffer freq_input(kNumMonoChannels,
+                                                    fft_manager.GetFftSize());
+  AudioBuffer output(kNumMonoChannels, frames_per_buffer);
+
+  for (auto _ : state) {
+    fft_manager.FreqFromTimeDomain(input[0], &freq_input[0]);
+    filter.Filter(freq_input[0]);
+    filter.GetFilteredSignal(&output[0]);
+    benchmark::DoNotOptimize(output[0][0]);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(frames_per_buffer));
+}
+
+BENCHMARK(BM_FilterBlock)->Arg(480)->Arg(512);
+
+}  // namespace
+}  // namespace obr
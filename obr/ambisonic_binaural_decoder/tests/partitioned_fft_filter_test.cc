@@ -13,6 +13,7 @@
 #include "obr/ambisonic_binaural_decoder/partitioned_fft_filter.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <vector>
 
@@ -449,6 +450,125 @@ TEST(PartitionedFftFilterTest, DiracImpulseTest) {
 
 }  // namespace
 
+// Tests that storing the spectra in half precision stays close to the float
+// filter, also when the filter length changes while filtering.
+TEST(PartitionedFftFilterTest, HalfPrecisionTest) {
+  const size_t kFilterSize = 8 * kLength;
+  const size_t kNumBlocks = 20;
+  // Maximum energy of the output difference relative to the output energy.
+  const double kMaxRelativeErrorDb = -60.0;
+
+  AudioBuffer kernel(kNumMonoChannels, kFilterSize);
+  for (size_t frame = 0; frame < kFilterSize; ++frame) {
+    kernel[0][frame] = std::sin(0.3f * static_cast<float>(frame)) *
+                       std::exp(-static_cast<float>(frame) / 64.0f);
+  }
+  FftManager fft_manager(kLength);
+  PartitionedFftFilter float_filter(kFilterSize, kLength, &fft_manager);
+  float_filter.SetTimeDomainKernel(kernel[0]);
+  PartitionedFftFilter half_kernels_filter(kFilterSize, kLength, kFilterSize,
+                                           &fft_manager,
+                                           SpectrumPrecision::kHalfKernels);
+  half_kernels_filter.SetTimeDomainKernel(kernel[0]);
+  PartitionedFftFilter half_filter(kFilterSize, kLength, kFilterSize,
+                                   &fft_manager,
+                                   SpectrumPrecision::kHalfKernelsAndHistory);
+  half_filter.SetTimeDomainKernel(kernel[0]);
+  PartitionedFftFilter* const filters[] = {&float_filter, &half_kernels_filter,
+                                           &half_filter};
+
+  AudioBuffer input(kNumMonoChannels, kLength);
+  PartitionedFftFilter::FreqDomainBuffer freq_input(kNumMonoChannels,
+                                                    fft_manager.GetFftSize());
+  AudioBuffer output(3, kLength);
+  double output_energy = 0.0;
+  double error_energies[2] = {0.0, 0.0};
+  for (size_t block = 0; block < kNumBlocks; ++block) {
+    if (block == kNumBlocks / 2) {
+      // Shorten the filters with the input history not starting at the first
+      // partition.
+      for (PartitionedFftFilter* filter : filters) {
+        filter->SetFilterLength(kFilterSize / 2);
+      }
+    }
+    for (size_t frame = 0; frame < kLength; ++frame) {
+      input[0][frame] =
+          std::cos(0.11f * static_cast<float>(block * kLength + frame));
+    }
+    fft_manager.FreqFromTimeDomain(input[0], &freq_input[0]);
+    for (size_t i = 0; i < 3; ++i) {
+      filters[i]->Filter(freq_input[0]);
+      filters[i]->GetFilteredSignal(&output[i]);
+    }
+    for (size_t frame = 0; frame < kLength; ++frame) {
+      output_energy += output[0][frame] * output[0][frame];
+      for (size_t i = 0; i < 2; ++i) {
+        const double error = output[i + 1][frame] - output[0][frame];
+        error_energies[i] += error * error;
+      }
+    }
+  }
+  ASSERT_GT(output_energy, 0.0);
+  for (const double error_energy : error_energies) {
+    EXPECT_LT(10.0 * std::log10(error_energy / output_energy),
+              kMaxRelativeErrorDb);
+  }
+}
+
+// Tests that filtering silence gives the same spectra as filtering all zero
+// input blocks, also when the filter length changes during silence.
+TEST(PartitionedFftFilterTest, FilterSilenceAndAccumulateTest) {
+  const size_t kFilterSize = 8 * kLength;
+  const size_t kNumBlocks = 30;
+
+  AudioBuffer kernel(kNumMonoChannels, kFilterSize);
+  for (size_t frame = 0; frame < kFilterSize; ++frame) {
+    kernel[0][frame] = std::sin(0.3f * static_cast<float>(frame));
+  }
+  FftManager fft_manager(kLength);
+  const size_t fft_size = fft_manager.GetFftSize();
+  for (const SpectrumPrecision precision :
+       {SpectrumPrecision::kFloat, SpectrumPrecision::kHalfKernelsAndHistory}) {
+    PartitionedFftFilter filter(kFilterSize, kLength, kFilterSize,
+                                &fft_manager, precision);
+    PartitionedFftFilter reference_filter(kFilterSize, kLength, kFilterSize,
+                                          &fft_manager, precision);
+    filter.SetTimeDomainKernel(kernel[0]);
+    reference_filter.SetTimeDomainKernel(kernel[0]);
+
+    AudioBuffer input(kNumMonoChannels, kLength);
+    PartitionedFftFilter::FreqDomainBuffer freq_input(kNumMonoChannels,
+                                                      fft_size);
+    PartitionedFftFilter::FreqDomainBuffer accumulators(2, fft_size);
+    for (size_t block = 0; block < kNumBlocks; ++block) {
+      if (block == 10 || block == 20) {
+        filter.SetFilterLength(block == 10 ? kFilterSize / 2 : kFilterSize);
+        reference_filter.SetFilterLength(block == 10 ? kFilterSize / 2
+                                                     : kFilterSize);
+      }
+      const bool is_active = block < 4 || block == 13 || block == 21;
+      input.Clear();
+      if (is_active) {
+        for (size_t frame = 0; frame < kLength; ++frame) {
+          input[0][frame] =
+              std::cos(0.11f * static_cast<float>(block * kLength + frame));
+        }
+      }
+      fft_manager.FreqFromTimeDomain(input[0], &freq_input[0]);
+      accumulators.Clear();
+      if (is_active) {
+        filter.FilterAndAccumulate(freq_input[0], &accumulators[0]);
+      } else {
+        filter.FilterSilenceAndAccumulate(&accumulators[0]);
+      }
+      reference_filter.FilterAndAccumulate(freq_input[0], &accumulators[1]);
+      for (size_t bin = 0; bin < fft_size; ++bin) {
+        EXPECT_EQ(accumulators[0][bin], accumulators[1][bin]);
+      }
+    }
+  }
+}
+
 class PartitionedFftFilterFrequencyBufferTest : public ::testing::Test {
  protected:
   PartitionedFftFilterFrequencyBufferTest() {}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/ambisonic_binaural_decoder/sh_hrir_creator.h"
+
+#include <cstddef>
+
+#include "gtest/gtest.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/ambisonic_utils.h"
+
+namespace obr {
+
+namespace {
+
+const size_t kNumSecondOrderAmbisonicChannels = 9;
+const size_t kFilterSize = 32;
+const float kTolerance = 1e-6f;
+
+// Tests that mirrored SH-HRIRs are detected as symmetric, and that asymmetric
+// or mismatched SH-HRIRs are not.
+TEST(ShHrirCreatorTest, AreShHrirsSymmetricTest) {
+  AudioBuffer sh_hrirs_L(kNumSecondOrderAmbisonicChannels, kFilterSize);
+  AudioBuffer sh_hrirs_R(kNumSecondOrderAmbisonicChannels, kFilterSize);
+  for (size_t channel = 0; channel < kNumSecondOrderAmbisonicChannels;
+       ++channel) {
+    const float sign =
+        GetPeriphonicAmbisonicDegreeForChannel(channel) < 0 ? -1.0f : 1.0f;
+    for (size_t frame = 0; frame < kFilterSize; ++frame) {
+      sh_hrirs_L[channel][frame] =
+          0.01f * static_cast<float>(channel + 1) * static_cast<float>(frame);
+      sh_hrirs_R[channel][frame] = sign * sh_hrirs_L[channel][frame];
+    }
+  }
+  EXPECT_TRUE(AreShHrirsSymmetric(sh_hrirs_L, sh_hrirs_R, kTolerance));
+
+  // Identical left and right filters are not symmetric, as the sin harmonics
+  // are non-zero.
+  EXPECT_FALSE(AreShHrirsSymmetric(sh_hrirs_L, sh_hrirs_L, kTolerance));
+
+  // A single deviating sample breaks the symmetry.
+  sh_hrirs_R[4][kFilterSize - 1] += 0.01f;
+  EXPECT_FALSE(AreShHrirsSymmetric(sh_hrirs_L, sh_hrirs_R, kTolerance));
+  EXPECT_TRUE(AreShHrirsSymmetric(sh_hrirs_L, sh_hrirs_R, 0.1f));
+
+  AudioBuffer first_order_sh_hrirs(4, kFilterSize);
+  EXPECT_FALSE(
+      AreShHrirsSymmetric(sh_hrirs_L, first_order_sh_hrirs, kTolerance));
+}
+
+}  // namespace
+
+}  // namespace obr
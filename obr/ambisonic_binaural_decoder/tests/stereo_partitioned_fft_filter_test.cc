@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/ambisonic_binaural_decoder/stereo_partitioned_fft_filter.h"
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "obr/ambisonic_binaural_decoder/dsp_utils.h"
+#include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/partitioned_fft_filter.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
+
+namespace obr {
+
+namespace {
+
+// Permitted error between the stereo and the mono filter outputs.
+const float kFftEpsilon = 1e-4f;
+
+// Fills a channel with a deterministic pseudo random sequence in [-1, 1].
+void FillWithNoise(unsigned int seed, AudioBuffer::Channel* channel) {
+  for (float& sample : *channel) {
+    seed = seed * 1664525u + 1013904223u;
+    sample = static_cast<float>(seed >> 8) / static_cast<float>(1 << 23) - 1.0f;
+  }
+}
+
+// Tests that the stereo filter produces the same output as a pair of mono
+// `PartitionedFftFilter`s for a range of buffer and filter sizes, including non
+// power of two buffer sizes and kernels which are not a multiple of the buffer
+// size.
+TEST(StereoPartitionedFftFilterTest, MatchesPairOfMonoFilters) {
+  const size_t kNumBlocks = 12;
+  const std::vector<size_t> kBufferSizes = {15, 16, 32, 33};
+  const std::vector<size_t> kFilterSizes = {7, 32, 100};
+
+  for (const size_t buffer_size : kBufferSizes) {
+    for (const size_t filter_size : kFilterSizes) {
+      AudioBuffer kernels(kNumStereoChannels, filter_size);
+      FillWithNoise(1, &kernels[0]);
+      FillWithNoise(2, &kernels[1]);
+
+      FftManager fft_manager(buffer_size);
+      StereoPartitionedFftFilter stereo_filter(filter_size, buffer_size,
+                                               &fft_manager);
+      stereo_filter.SetTimeDomainKernels(kernels[0], kernels[1]);
+      PartitionedFftFilter filter_L(filter_size, buffer_size, &fft_manager);
+      filter_L.SetTimeDomainKernel(kernels[0]);
+      PartitionedFftFilter filter_R(filter_size, buffer_size, &fft_manager);
+      filter_R.SetTimeDomainKernel(kernels[1]);
+
+      AudioBuffer input(kNumMonoChannels, buffer_size);
+      PartitionedFftFilter::FreqDomainBuffer freq_input(
+          kNumMonoChannels, fft_manager.GetFftSize());
+      AudioBuffer stereo_output(kNumStereoChannels, buffer_size);
+      AudioBuffer mono_output(kNumStereoChannels, buffer_size);
+
+      for (size_t block = 0; block < kNumBlocks; ++block) {
+        FillWithNoise(static_cast<unsigned int>(block + 3), &input[0]);
+        fft_manager.FreqFromTimeDomain(input[0], &freq_input[0]);
+
+        stereo_filter.Filter(freq_input[0]);
+        stereo_filter.GetFilteredSignal(&stereo_output[0], &stereo_output[1]);
+        filter_L.Filter(freq_input[0]);
+        filter_L.GetFilteredSignal(&mono_output[0]);
+        filter_R.Filter(freq_input[0]);
+        filter_R.GetFilteredSignal(&mono_output[1]);
+
+        for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+          for (size_t frame = 0; frame < buffer_size; ++frame) {
+            EXPECT_NEAR(stereo_output[ear][frame], mono_output[ear][frame],
+                        kFftEpsilon);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Tests that skipping kernel partitions, in both the stereo and the mono
+// filter, gives the same output as filtering with kernels in which those
+// partitions are zeroed.
+TEST(StereoPartitionedFftFilterTest, SkippedPartitions) {
+  const size_t kNumBlocks = 12;
+  const size_t kBufferSize = 16;
+  const size_t kNumPartitions = 5;
+  const size_t kFilterSize = kNumPartitions * kBufferSize;
+  const std::vector<bool> kSkippedPartitionsL = {false, true, false, true};
+  const std::vector<bool> kSkippedPartitionsR = {true, false, false, false,
+                                                 true};
+
+  AudioBuffer kernels(kNumStereoChannels, kFilterSize);
+  FillWithNoise(1, &kernels[0]);
+  FillWithNoise(2, &kernels[1]);
+  AudioBuffer zeroed_kernels(kNumStereoChannels, kFilterSize);
+  zeroed_kernels = kernels;
+  for (size_t partition = 0; partition < kNumPartitions; ++partition) {
+    for (size_t frame = 0; frame < kBufferSize; ++frame) {
+      if (partition < kSkippedPartitionsL.size() &&
+          kSkippedPartitionsL[partition]) {
+        zeroed_kernels[0][partition * kBufferSize + frame] = 0.0f;
+      }
+      if (kSkippedPartitionsR[partition]) {
+        zeroed_kernels[1][partition * kBufferSize + frame] = 0.0f;
+      }
+    }
+  }
+
+  FftManager fft_manager(kBufferSize);
+  StereoPartitionedFftFilter stereo_filter(kFilterSize, kBufferSize,
+                                           &fft_manager);
+  stereo_filter.SetTimeDomainKernels(kernels[0], kernels[1]);
+  stereo_filter.SetSkippedPartitions(kSkippedPartitionsL, kSkippedPartitionsR);
+  PartitionedFftFilter skipping_filter_L(kFilterSize, kBufferSize,
+                                         &fft_manager);
+  skipping_filter_L.SetTimeDomainKernel(kernels[0]);
+  skipping_filter_L.SetSkippedPartitions(kSkippedPartitionsL);
+  PartitionedFftFilter filter_L(kFilterSize, kBufferSize, &fft_manager);
+  filter_L.SetTimeDomainKernel(zeroed_kernels[0]);
+  PartitionedFftFilter filter_R(kFilterSize, kBufferSize, &fft_manager);
+  filter_R.SetTimeDomainKernel(zeroed_kernels[1]);
+
+  AudioBuffer input(kNumMonoChannels, kBufferSize);
+  PartitionedFftFilter::FreqDomainBuffer freq_input(kNumMonoChannels,
+                                                    fft_manager.GetFftSize());
+  AudioBuffer stereo_output(kNumStereoChannels, kBufferSize);
+  AudioBuffer skipping_output(kNumMonoChannels, kBufferSize);
+  AudioBuffer mono_output(kNumStereoChannels, kBufferSize);
+
+  for (size_t block = 0; block < kNumBlocks; ++block) {
+    FillWithNoise(static_cast<unsigned int>(block + 3), &input[0]);
+    fft_manager.FreqFromTimeDomain(input[0], &freq_input[0]);
+
+    stereo_filter.Filter(freq_input[0]);
+    stereo_filter.GetFilteredSignal(&stereo_output[0], &stereo_output[1]);
+    skipping_filter_L.Filter(freq_input[0]);
+    skipping_filter_L.GetFilteredSignal(&skipping_output[0]);
+    filter_L.Filter(freq_input[0]);
+    filter_L.GetFilteredSignal(&mono_output[0]);
+    filter_R.Filter(freq_input[0]);
+    filter_R.GetFilteredSignal(&mono_output[1]);
+
+    for (size_t frame = 0; frame < kBufferSize; ++frame) {
+      EXPECT_NEAR(stereo_output[0][frame], mono_output[0][frame], kFftEpsilon);
+      EXPECT_NEAR(stereo_output[1][frame], mono_output[1][frame], kFftEpsilon);
+      EXPECT_NEAR(skipping_output[0][frame], mono_output[0][frame],
+                  kFftEpsilon);
+    }
+  }
+}
+
+// Tests that accumulating the outputs of several filters in the frequency
+// domain, followed by a single inverse FFT and overlap-add per ear, gives the
+// sum of the individually filtered outputs.
+TEST(StereoPartitionedFftFilterTest, FilterAndAccumulate) {
+  const size_t kNumBlocks = 8;
+  const size_t kNumFilters = 3;
+  const size_t kFilterSize = 70;
+  const std::vector<size_t> kBufferSizes = {15, 16};
+
+  for (const size_t buffer_size : kBufferSizes) {
+    FftManager fft_manager(buffer_size);
+    const size_t fft_size = fft_manager.GetFftSize();
+    std::vector<std::unique_ptr<StereoPartitionedFftFilter>>
+        accumulating_filters, reference_filters;
+    AudioBuffer kernels(kNumStereoChannels, kFilterSize);
+    for (size_t i = 0; i < kNumFilters; ++i) {
+      FillWithNoise(static_cast<unsigned int>(2 * i + 1), &kernels[0]);
+      FillWithNoise(static_cast<unsigned int>(2 * i + 2), &kernels[1]);
+      accumulating_filters.emplace_back(new StereoPartitionedFftFilter(
+          kFilterSize, buffer_size, &fft_manager));
+      accumulating_filters[i]->SetTimeDomainKernels(kernels[0], kernels[1]);
+      reference_filters.emplace_back(new StereoPartitionedFftFilter(
+          kFilterSize, buffer_size, &fft_manager));
+      reference_filters[i]->SetTimeDomainKernels(kernels[0], kernels[1]);
+    }
+
+    AudioBuffer input(kNumFilters, buffer_size);
+    PartitionedFftFilter::FreqDomainBuffer freq_input(kNumMonoChannels,
+                                                      fft_size);
+    PartitionedFftFilter::FreqDomainBuffer accumulator(kNumStereoChannels,
+                                                       fft_size);
+    AudioBuffer time_domain_blocks(2 * kNumStereoChannels, fft_size);
+    time_domain_blocks.Clear();
+    AudioBuffer accumulated_output(kNumStereoChannels, buffer_size);
+    AudioBuffer filtered_output(kNumStereoChannels, buffer_size);
+    AudioBuffer reference_output(kNumStereoChannels, buffer_size);
+    size_t buffer_selector = 0;
+
+    for (size_t block = 0; block < kNumBlocks; ++block) {
+      accumulator.Clear();
+      reference_output.Clear();
+      for (size_t i = 0; i < kNumFilters; ++i) {
+        FillWithNoise(static_cast<unsigned int>(10 * block + i), &input[i]);
+        fft_manager.FreqFromTimeDomain(input[i], &freq_input[0]);
+        accumulating_filters[i]->FilterAndAccumulate(
+            freq_input[0], &accumulator[0], &accumulator[1]);
+        reference_filters[i]->Filter(freq_input[0]);
+        reference_filters[i]->GetFilteredSignal(&filtered_output[0],
+                                                &filtered_output[1]);
+        reference_output[0] += filtered_output[0];
+        reference_output[1] += filtered_output[1];
+      }
+
+      buffer_selector = !buffer_selector;
+      for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+        fft_manager.TimeFromFreqDomain(
+            accumulator[ear], &time_domain_blocks[2 * ear + buffer_selector]);
+        OverlapAdd(time_domain_blocks[2 * ear + buffer_selector],
+                   time_domain_blocks[2 * ear + !buffer_selector],
+                   &accumulated_output[ear]);
+        for (size_t frame = 0; frame < buffer_size; ++frame) {
+          EXPECT_NEAR(accumulated_output[ear][frame],
+                      reference_output[ear][frame], kFftEpsilon);
+        }
+      }
+    }
+  }
+}
+
+// Tests that kernels set in the frequency domain give the same result as
+// kernels set in the time domain, and that `Clear()` resets the filter state.
+TEST(StereoPartitionedFftFilterTest, FreqDomainKernelAndClear) {
+  const size_t kBufferSize = 32;
+  const size_t kFilterSize = 96;
+  const size_t kNumPartitions = kFilterSize / kBufferSize;
+
+  // Left ear kernel is a dirac delayed by 40 samples, the right ear kernel a
+  // dirac delayed by 70 samples scaled by 0.5.
+  AudioBuffer kernels(kNumStereoChannels, kFilterSize);
+  kernels.Clear();
+  kernels[0][40] = 1.0f;
+  kernels[1][70] = 0.5f;
+
+  FftManager fft_manager(kBufferSize);
+  StereoPartitionedFftFilter::FreqDomainBuffer freq_kernel_L(
+      kNumPartitions, fft_manager.GetFftSize());
+  StereoPartitionedFftFilter::FreqDomainBuffer freq_kernel_R(
+      kNumPartitions, fft_manager.GetFftSize());
+  AudioBuffer chunk(kNumMonoChannels, kBufferSize);
+  for (size_t partition = 0; partition < kNumPartitions; ++partition) {
+    for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+      for (size_t frame = 0; frame < kBufferSize; ++frame) {
+        chunk[0][frame] = kernels[ear][partition * kBufferSize + frame];
+      }
+      fft_manager.FreqFromTimeDomain(
+          chunk[0], ear == 0 ? &freq_kernel_L[partition]
+                             : &freq_kernel_R[partition]);
+    }
+  }
+
+  StereoPartitionedFftFilter filter(kFilterSize, kBufferSize, &fft_manager);
+  filter.SetFreqDomainKernels(freq_kernel_L, freq_kernel_R);
+
+  AudioBuffer input(kNumMonoChannels, kBufferSize);
+  PartitionedFftFilter::FreqDomainBuffer freq_input(kNumMonoChannels,
+                                                    fft_manager.GetFftSize());
+  AudioBuffer output(kNumStereoChannels, kBufferSize);
+  std::vector<float> output_L, output_R;
+
+  for (size_t run = 0; run < 2; ++run) {
+    output_L.clear();
+    output_R.clear();
+    for (size_t block = 0; block < 4; ++block) {
+      input.Clear();
+      if (block == 0) {
+        input[0][0] = 1.0f;
+      }
+      fft_manager.FreqFromTimeDomain(input[0], &freq_input[0]);
+      filter.Filter(freq_input[0]);
+      filter.GetFilteredSignal(&output[0], &output[1]);
+      output_L.insert(output_L.end(), output[0].begin(), output[0].end());
+      output_R.insert(output_R.end(), output[1].begin(), output[1].end());
+    }
+    for (size_t i = 0; i < output_L.size(); ++i) {
+      EXPECT_NEAR(output_L[i], i == 40 ? 1.0f : 0.0f, kFftEpsilon);
+      EXPECT_NEAR(output_R[i], i == 70 ? 0.5f : 0.0f, kFftEpsilon);
+    }
+    // The second run must not contain any residue of the first one.
+    filter.Clear();
+  }
+}
+
+// Tests that storing the spectra in half precision stays close to the float
+// filter for a decaying noise kernel, for time domain, frequency domain and
+// shared kernels.
+TEST(StereoPartitionedFftFilterTest, HalfPrecisionMatchesFloat) {
+  const size_t kBufferSize = 64;
+  const size_t kFilterSize = 1000;
+  const size_t kNumBlocks = 24;
+  // Maximum energy of the output difference relative to the output energy.
+  const double kMaxRelativeErrorDb = -60.0;
+
+  AudioBuffer kernels(kNumStereoChannels, kFilterSize);
+  FillWithNoise(1, &kernels[0]);
+  FillWithNoise(2, &kernels[1]);
+  for (size_t frame = 0; frame < kFilterSize; ++frame) {
+    const float decay = std::exp(-static_cast<float>(frame) / 200.0f);
+    kernels[0][frame] *= decay;
+    kernels[1][frame] *= decay;
+  }
+
+  FftManager fft_manager(kBufferSize);
+  StereoPartitionedFftFilter float_filter(kFilterSize, kBufferSize,
+                                          &fft_manager);
+  float_filter.SetTimeDomainKernels(kernels[0], kernels[1]);
+  const size_t num_partitions = kFilterSize / kBufferSize + 1;
+  auto freq_kernel_L = std::make_shared<PartitionedFftFilter::FreqDomainBuffer>(
+      num_partitions, fft_manager.GetFftSize());
+  auto freq_kernel_R = std::make_shared<PartitionedFftFilter::FreqDomainBuffer>(
+      num_partitions, fft_manager.GetFftSize());
+  AudioBuffer chunk(kNumMonoChannels, kBufferSize);
+  for (size_t partition = 0; partition < num_partitions; ++partition) {
+    for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+      for (size_t frame = 0; frame < kBufferSize; ++frame) {
+        const size_t index = partition * kBufferSize + frame;
+        chunk[0][frame] = index < kFilterSize ? kernels[ear][index] : 0.0f;
+      }
+      fft_manager.FreqFromTimeDomain(
+          chunk[0], ear == 0 ? &(*freq_kernel_L)[partition]
+                             : &(*freq_kernel_R)[partition]);
+    }
+  }
+
+  std::vector<std::unique_ptr<StereoPartitionedFftFilter>> half_filters;
+  for (const SpectrumPrecision precision :
+       {SpectrumPrecision::kHalfKernels,
+        SpectrumPrecision::kHalfKernelsAndHistory}) {
+    for (size_t kernel_type = 0; kernel_type < 3; ++kernel_type) {
+      half_filters.emplace_back(new StereoPartitionedFftFilter(
+          kFilterSize, kBufferSize, &fft_manager, precision));
+      if (kernel_type == 0) {
+        half_filters.back()->SetTimeDomainKernels(kernels[0], kernels[1]);
+      } else if (kernel_type == 1) {
+        half_filters.back()->SetFreqDomainKernels(*freq_kernel_L,
+                                                  *freq_kernel_R);
+      } else {
+        half_filters.back()->SetSharedFreqDomainKernels(freq_kernel_L,
+                                                        freq_kernel_R);
+      }
+    }
+  }
+
+  AudioBuffer input(kNumMonoChannels, kBufferSize);
+  PartitionedFftFilter::FreqDomainBuffer freq_input(kNumMonoChannels,
+                                                    fft_manager.GetFftSize());
+  AudioBuffer expected_output(kNumStereoChannels, kBufferSize);
+  AudioBuffer output(kNumStereoChannels, kBufferSize);
+  double output_energy = 0.0;
+  std::vector<double> error_energies(half_filters.size(), 0.0);
+  for (size_t block = 0; block < kNumBlocks; ++block) {
+    FillWithNoise(static_cast<unsigned int>(100 + block), &input[0]);
+    fft_manager.FreqFromTimeDomain(input[0], &freq_input[0]);
+    float_filter.Filter(freq_input[0]);
+    float_filter.GetFilteredSignal(&expected_output[0], &expected_output[1]);
+    for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+      for (const float sample : expected_output[ear]) {
+        output_energy += sample * sample;
+      }
+    }
+    for (size_t i = 0; i < half_filters.size(); ++i) {
+      half_filters[i]->Filter(freq_input[0]);
+      half_filters[i]->GetFilteredSignal(&output[0], &output[1]);
+      for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+        for (size_t frame = 0; frame < kBufferSize; ++frame) {
+          const double error = output[ear][frame] - expected_output[ear][frame];
+          error_energies[i] += error * error;
+        }
+      }
+    }
+  }
+  ASSERT_GT(output_energy, 0.0);
+  for (const double error_energy : error_energies) {
+    EXPECT_LT(10.0 * std::log10(error_energy / output_energy),
+              kMaxRelativeErrorDb);
+  }
+}
+
+// Tests that filtering silence gives the same spectra as filtering all zero
+// input blocks, while the tail decays, once the whole history is silent and
+// when the input becomes active again.
+TEST(StereoPartitionedFftFilterTest, FilterSilenceAndAccumulate) {
+  const size_t kBufferSize = 16;
+  const size_t kFilterSize = 100;
+  const size_t kNumBlocks = 24;
+
+  AudioBuffer kernels(kNumStereoChannels, kFilterSize);
+  FillWithNoise(1, &kernels[0]);
+  FillWithNoise(2, &kernels[1]);
+  FftManager fft_manager(kBufferSize);
+  const size_t fft_size = fft_manager.GetFftSize();
+
+  for (const SpectrumPrecision precision :
+       {SpectrumPrecision::kFloat, SpectrumPrecision::kHalfKernelsAndHistory}) {
+    StereoPartitionedFftFilter filter(kFilterSize, kBufferSize, &fft_manager,
+                                      precision);
+    StereoPartitionedFftFilter reference_filter(kFilterSize, kBufferSize,
+                                                &fft_manager, precision);
+    filter.SetTimeDomainKernels(kernels[0], kernels[1]);
+    reference_filter.SetTimeDomainKernels(kernels[0], kernels[1]);
+
+    AudioBuffer input(kNumMonoChannels, kBufferSize);
+    PartitionedFftFilter::FreqDomainBuffer freq_input(kNumMonoChannels,
+                                                      fft_size);
+    PartitionedFftFilter::FreqDomainBuffer accumulator(kNumStereoChannels,
+                                                       fft_size);
+    PartitionedFftFilter::FreqDomainBuffer reference_accumulator(
+        kNumStereoChannels, fft_size);
+    for (size_t block = 0; block < kNumBlocks; ++block) {
+      // Silence longer and shorter than the filter.
+      const bool is_active =
+          block < 3 || (block >= 13 && block < 15) || block == 18;
+      input.Clear();
+      if (is_active) {
+        FillWithNoise(static_cast<unsigned int>(10 + block), &input[0]);
+      }
+      fft_manager.FreqFromTimeDomain(input[0], &freq_input[0]);
+      accumulator.Clear();
+      reference_accumulator.Clear();
+      if (is_active) {
+        filter.FilterAndAccumulate(freq_input[0], &accumulator[0],
+                                   &accumulator[1]);
+      } else {
+        filter.FilterSilenceAndAccumulate(&accumulator[0], &accumulator[1]);
+      }
+      reference_filter.FilterAndAccumulate(freq_input[0],
+                                           &reference_accumulator[0],
+                                           &reference_accumulator[1]);
+      for (size_t ear = 0; ear < kNumStereoChannels; ++ear) {
+        for (size_t bin = 0; bin < fft_size; ++bin) {
+          EXPECT_EQ(accumulator[ear][bin], reference_accumulator[ear][bin]);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+}  // namespace obr
@@ -16,6 +16,7 @@
 #include "Eigen/Core"
 #include "absl/log/check.h"
 #include "obr/audio_buffer/audio_buffer.h"
+#include "obr/audio_buffer/simd_utils.h"
 #include "obr/common/ambisonic_utils.h"
 #include "obr/common/constants.h"
 
@@ -34,6 +35,9 @@ AmbisonicEncoder::AmbisonicEncoder(size_t number_of_input_channels,
   encoding_matrix_ =
       Eigen::MatrixXf::Zero(static_cast<int>(number_of_output_channels_),
                             static_cast<int>(number_of_input_channels_));
+  active_input_channels_.reserve(number_of_input_channels_);
+  sh_coeffs_.resize(number_of_output_channels_);
+  associated_legendre_polynomials_.resize(alp_generator_.GetNumValues());
 }
 
 void AmbisonicEncoder::SetSource(size_t input_channel, float gain,
@@ -72,14 +76,13 @@ void AmbisonicEncoder::SetSource(size_t input_channel, float gain,
 
   // Get the spherical harmonic coefficients for the given azimuth and
   // elevation.
-  std::vector<float> sh_coeffs(number_of_output_channels_);
-  GetShCoeffs(azimuth, elevation, ambisonic_order_, sh_coeffs);
+  GetShCoeffs(azimuth, elevation, ambisonic_order_, sh_coeffs_);
 
   // Scale the spherical harmonic coefficients by the overall gain and update
   // the encoding matrix.
   for (size_t i = 0; i < number_of_output_channels_; i++) {
     encoding_matrix_(static_cast<int>(i), static_cast<int>(input_channel)) =
-        sh_coeffs.at(i) * overall_gain;
+        sh_coeffs_.at(i) * overall_gain;
   }
 }
 
@@ -115,14 +118,121 @@ void AmbisonicEncoder::ProcessPlanarAudioData(
   encoded_buffer.noalias() = encoding_matrix_ * unencoded_buffer;
 }
 
+void AmbisonicEncoder::ProcessActivePlanarAudioData(
+    const AudioBuffer& input_buffer, AudioBuffer* output_buffer) {
+  CHECK_EQ(number_of_input_channels_, input_buffer.num_channels());
+  ProcessActive(input_buffer, nullptr, output_buffer);
+}
+
+void AmbisonicEncoder::ProcessActivePlanarAudioData(
+    const AudioBuffer& input_buffer,
+    const std::vector<size_t>& input_channel_indices,
+    AudioBuffer* output_buffer) {
+  CHECK_EQ(number_of_input_channels_, input_channel_indices.size());
+  ProcessActive(input_buffer, &input_channel_indices, output_buffer);
+}
+
+void AmbisonicEncoder::ProcessActive(
+    const AudioBuffer& input_buffer,
+    const std::vector<size_t>* input_channel_indices,
+    AudioBuffer* output_buffer) {
+  CHECK_NE(output_buffer, nullptr);
+  CHECK_EQ(number_of_output_channels_, output_buffer->num_channels());
+  CHECK_EQ(input_buffer.num_frames(), output_buffer->num_frames());
+  const size_t num_frames = input_buffer.num_frames();
+  auto get_channel = [&](size_t input) {
+    return input_channel_indices == nullptr ? input
+                                            : (*input_channel_indices)[input];
+  };
+
+  // Collect the inputs contributing to the output, and check whether they are
+  // consecutive channels of the input buffer.
+  active_input_channels_.clear();
+  bool is_consecutive = !input_buffer.IsView();
+  for (size_t input = 0; input < number_of_input_channels_; ++input) {
+    const size_t channel = get_channel(input);
+    if (channel >= input_buffer.num_channels()) {
+      continue;
+    }
+    is_consecutive &= channel == get_channel(0) + input;
+    if (input_buffer[channel].IsEnabled() &&
+        !encoding_matrix_.col(static_cast<int>(input)).isZero(0.0f) &&
+        !IsBelowThreshold(num_frames, kNegative120dbInAmplitude,
+                          input_buffer[channel].begin())) {
+      active_input_channels_.push_back(input);
+    }
+  }
+
+  if (active_input_channels_.size() == number_of_input_channels_ &&
+      is_consecutive) {
+    // All inputs are active, the dense matrix product is the fastest.
+    for (size_t output = 0; output < number_of_output_channels_; ++output) {
+      (*output_buffer)[output].SetEnabled(true);
+    }
+    if (input_channel_indices == nullptr) {
+      ProcessPlanarAudioData(input_buffer, output_buffer);
+    } else {
+      // The channels are mapped in place with the stride of the input buffer.
+      const Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic,
+                                           Eigen::Dynamic, Eigen::RowMajor>,
+                       Eigen::Aligned, Eigen::OuterStride<>>
+          unencoded_buffer(
+              input_buffer[get_channel(0)].begin(),
+              static_cast<int>(number_of_input_channels_),
+              static_cast<int>(num_frames),
+              Eigen::OuterStride<>(
+                  static_cast<int>(input_buffer.GetChannelStride())));
+      Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic,
+                               Eigen::RowMajor>,
+                 Eigen::Aligned, Eigen::OuterStride<>>
+          encoded_buffer(
+              (*output_buffer)[0].begin(),
+              static_cast<int>(number_of_output_channels_),
+              static_cast<int>(num_frames),
+              Eigen::OuterStride<>(
+                  static_cast<int>(output_buffer->GetChannelStride())));
+      encoded_buffer.noalias() = encoding_matrix_ * unencoded_buffer;
+    }
+    for (size_t output = 0; output < number_of_output_channels_; ++output) {
+      if (encoding_matrix_.row(static_cast<int>(output)).isZero(0.0f)) {
+        (*output_buffer)[output].SetEnabled(false);
+      }
+    }
+    return;
+  }
+
+  for (size_t output = 0; output < number_of_output_channels_; ++output) {
+    AudioBuffer::Channel& output_channel = (*output_buffer)[output];
+    bool is_output_active = false;
+    for (const size_t input : active_input_channels_) {
+      const float coefficient = encoding_matrix_(static_cast<int>(output),
+                                                 static_cast<int>(input));
+      if (coefficient == 0.0f) {
+        continue;
+      }
+      const float* input_channel = input_buffer[get_channel(input)].begin();
+      if (!is_output_active) {
+        output_channel.SetEnabled(true);
+        ScalarMultiply(num_frames, coefficient, input_channel,
+                       output_channel.begin());
+        is_output_active = true;
+      } else {
+        ScalarMultiplyAndAccumulate(num_frames, coefficient, input_channel,
+                                    output_channel.begin());
+      }
+    }
+    output_channel.SetEnabled(is_output_active);
+  }
+}
+
 void AmbisonicEncoder::GetShCoeffs(float azimuth, float elevation,
                                    size_t ambisonic_order,
                                    std::vector<float>& coeffs) {
   float azimuth_rad = azimuth * kRadiansFromDegrees;
   float elevation_rad = elevation * kRadiansFromDegrees;
 
-  std::vector<float> associated_legendre_polynomials_temp_ =
-      alp_generator_.Generate(std::sin(elevation_rad));
+  alp_generator_.Generate(std::sin(elevation_rad),
+                          &associated_legendre_polynomials_);
   // Compute the actual spherical harmonics using the generated polynomials.
   for (int degree = 0; degree <= ambisonic_order; degree++) {
     for (int order = -degree; order <= degree; order++) {
@@ -138,7 +248,7 @@ void AmbisonicEncoder::GetShCoeffs(float azimuth, float elevation,
 
       coeffs.at(row) =
           Sn3dNormalization(degree, order) *
-          associated_legendre_polynomials_temp_[alp_generator_.GetIndex(
+          associated_legendre_polynomials_[alp_generator_.GetIndex(
               degree, std::abs(order))] *
           last_term;
     }
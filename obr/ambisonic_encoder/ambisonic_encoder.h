@@ -66,6 +66,34 @@ class AmbisonicEncoder {
   void ProcessPlanarAudioData(const AudioBuffer& input_buffer,
                               AudioBuffer* output_buffer) const;
 
+  /*!\brief Processing callback for planar audio data, which tracks silent
+   * channels. Disabled and silent input channels as well as inputs without a
+   * source are not mixed. Output channels which receive no active input are
+   * disabled instead of being filled with zeros, all others are enabled.
+   *
+   * \param input_buffer Input buffer of samples. Disabled channels are not
+   *        read.
+   * \param output_buffer Output buffer of processed samples.
+   */
+  void ProcessActivePlanarAudioData(const AudioBuffer& input_buffer,
+                                    AudioBuffer* output_buffer);
+
+  /*!\brief Processes selected channels of a larger buffer like
+   * `ProcessActivePlanarAudioData()`, without gathering them into a separate
+   * buffer first. Consecutive channels of a buffer which owns its data are
+   * encoded with a single strided matrix product.
+   *
+   * \param input_buffer Input buffer of samples. Disabled channels are not
+   *        read.
+   * \param input_channel_indices Channel of `input_buffer` for each encoder
+   *        input. Channels beyond `input_buffer` are treated as silent.
+   * \param output_buffer Output buffer of processed samples.
+   */
+  void ProcessActivePlanarAudioData(
+      const AudioBuffer& input_buffer,
+      const std::vector<size_t>& input_channel_indices,
+      AudioBuffer* output_buffer);
+
  private:
   // Struct containing properties of a single source.
   struct SourceProperties {
@@ -88,6 +116,17 @@ class AmbisonicEncoder {
   void GetShCoeffs(float azimuth, float elevation, size_t ambisonic_order,
                    std::vector<float>& coeffs);
 
+  /*!\brief Implements both `ProcessActivePlanarAudioData()` overloads.
+   *
+   * \param input_buffer Input buffer of samples.
+   * \param input_channel_indices Channel of `input_buffer` for each encoder
+   *        input, or nullptr to use the channels of `input_buffer` in order.
+   * \param output_buffer Output buffer of processed samples.
+   */
+  void ProcessActive(const AudioBuffer& input_buffer,
+                     const std::vector<size_t>* input_channel_indices,
+                     AudioBuffer* output_buffer);
+
   //  const size_t buffer_size_per_channel_;
   const size_t number_of_input_channels_;
   const size_t number_of_output_channels_;
@@ -98,6 +137,16 @@ class AmbisonicEncoder {
 
   AssociatedLegendrePolynomialsGenerator alp_generator_;
   Eigen::MatrixXf encoding_matrix_;
+
+  // Spherical harmonic coefficients and associated Legendre polynomials of the
+  // last updated source, preallocated so that moving sources does not
+  // allocate.
+  std::vector<float> sh_coeffs_;
+  std::vector<float> associated_legendre_polynomials_;
+
+  // Indices of the active input channels of the current buffer, preallocated
+  // for all inputs.
+  std::vector<size_t> active_input_channels_;
 };
 
 }  // namespace obr
@@ -26,7 +26,16 @@ AssociatedLegendrePolynomialsGenerator::AssociatedLegendrePolynomialsGenerator(
 
 std::vector<float> AssociatedLegendrePolynomialsGenerator::Generate(
     float x) const {
-  std::vector<float> values(GetNumValues());
+  std::vector<float> values;
+  Generate(x, &values);
+  return values;
+}
+
+void AssociatedLegendrePolynomialsGenerator::Generate(
+    float x, std::vector<float>* output_values) const {
+  DCHECK(output_values);
+  output_values->resize(GetNumValues());
+  std::vector<float>& values = *output_values;
 
   // Bases for the recurrence relations.
   values[GetIndex(0, 0)] = ComputeValue(0, 0, x, values);
@@ -74,7 +83,6 @@ std::vector<float> AssociatedLegendrePolynomialsGenerator::Generate(
       }
     }
   }
-  return values;
 }
 
 size_t AssociatedLegendrePolynomialsGenerator::GetNumValues() const {
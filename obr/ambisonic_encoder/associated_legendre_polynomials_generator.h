@@ -37,6 +37,15 @@ class AssociatedLegendrePolynomialsGenerator {
    */
   std::vector<float> Generate(float x) const;
 
+  /*!\brief Generates the associated Legendre polynomials for the given `x`
+   * into an existing vector. Does not allocate if `values` already holds
+   * `GetNumValues()` elements.
+   *
+   * \param x Abscissa (the polynomials' variable).
+   * \param values Output vector of computed sequence values.
+   */
+  void Generate(float x, std::vector<float>* values) const;
+
   /*!\brief Gets the produced number of associated Legendre polynomials.
    *
    * \return Number of associated Legendre polynomials this generator
@@ -16,6 +16,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "gtest/gtest.h"
 #include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
 
 namespace obr {
 namespace {
@@ -94,5 +95,130 @@ TEST(AmbisonicEncoderTest, TestOneSampleBufferOneSource) {
   }
 }
 
+// Tests that output channels without active inputs are disabled and that all
+// other channels match the dense encoding.
+TEST(AmbisonicEncoderTest, TestProcessActivePlanarAudioData) {
+  const size_t kBufferSize = 64;
+  const size_t kNumInputChannels = 3;
+  const size_t kAmbisonicOrder = 2;
+  const size_t kNumOutputChannels =
+      (kAmbisonicOrder + 1) * (kAmbisonicOrder + 1);
+  const float kEpsilon = 1e-6f;
+  // A frontal source on the horizontal plane only excites these channels.
+  const std::vector<bool> kFrontalChannels = {true,  false, false,
+                                              true,  false, false,
+                                              true,  false, true};
+
+  AmbisonicEncoder encoder(kNumInputChannels, kAmbisonicOrder);
+  AudioBuffer input_buffer(kNumInputChannels, kBufferSize);
+  for (size_t frame = 0; frame < kBufferSize; ++frame) {
+    input_buffer[0][frame] = static_cast<float>(frame % 7) - 3.0f;
+    input_buffer[1][frame] = 0.0f;
+    input_buffer[2][frame] = 1.0f;
+  }
+  AudioBuffer expected_output(kNumOutputChannels, kBufferSize);
+  AudioBuffer output_buffer(kNumOutputChannels, kBufferSize);
+
+  // Source 1 is silent and input 2 has no source, so only input 0 is mixed.
+  encoder.SetSource(0, 0.5f, 0.0f, 0.0f, 1.0f);
+  encoder.SetSource(1, 1.0f, 30.0f, 20.0f, 1.0f);
+  encoder.ProcessPlanarAudioData(input_buffer, &expected_output);
+  encoder.ProcessActivePlanarAudioData(input_buffer, &output_buffer);
+  for (size_t channel = 0; channel < kNumOutputChannels; ++channel) {
+    ASSERT_EQ(output_buffer[channel].IsEnabled(), kFrontalChannels[channel]);
+    if (kFrontalChannels[channel]) {
+      for (size_t frame = 0; frame < kBufferSize; ++frame) {
+        EXPECT_NEAR(output_buffer[channel][frame],
+                    expected_output[channel][frame], kEpsilon);
+      }
+    }
+  }
+
+  // With all inputs active, all channels are excited again.
+  encoder.SetSource(2, 1.0f, -70.0f, 10.0f, 1.0f);
+  input_buffer[1] = input_buffer[0];
+  encoder.ProcessPlanarAudioData(input_buffer, &expected_output);
+  encoder.ProcessActivePlanarAudioData(input_buffer, &output_buffer);
+  for (size_t channel = 0; channel < kNumOutputChannels; ++channel) {
+    ASSERT_TRUE(output_buffer[channel].IsEnabled());
+    for (size_t frame = 0; frame < kBufferSize; ++frame) {
+      EXPECT_NEAR(output_buffer[channel][frame],
+                  expected_output[channel][frame], kEpsilon);
+    }
+  }
+
+  // The dense encoding disables unexcited channels as well.
+  AmbisonicEncoder frontal_encoder(kNumMonoChannels, kAmbisonicOrder);
+  frontal_encoder.SetSource(0, 1.0f, 0.0f, 0.0f, 1.0f);
+  AudioBuffer frontal_input(kNumMonoChannels, kBufferSize);
+  frontal_input[0] = input_buffer[0];
+  frontal_encoder.ProcessActivePlanarAudioData(frontal_input, &output_buffer);
+  for (size_t channel = 0; channel < kNumOutputChannels; ++channel) {
+    EXPECT_EQ(output_buffer[channel].IsEnabled(), kFrontalChannels[channel]);
+  }
+
+  // Disabled inputs are not read.
+  for (size_t channel = 0; channel < kNumInputChannels; ++channel) {
+    input_buffer[channel].SetEnabled(false);
+  }
+  encoder.ProcessActivePlanarAudioData(input_buffer, &output_buffer);
+  for (size_t channel = 0; channel < kNumOutputChannels; ++channel) {
+    EXPECT_FALSE(output_buffer[channel].IsEnabled());
+  }
+}
+
+// Tests that encoding selected channels of a larger buffer matches encoding a
+// buffer of the gathered channels, for consecutive, scattered and missing
+// channels. The buffer size is not a multiple of the channel stride.
+TEST(AmbisonicEncoderTest, TestProcessActivePlanarAudioDataWithIndices) {
+  const size_t kBufferSize = 61;
+  const size_t kNumBufferChannels = 5;
+  const size_t kNumInputChannels = 3;
+  const size_t kAmbisonicOrder = 3;
+  const size_t kNumOutputChannels =
+      (kAmbisonicOrder + 1) * (kAmbisonicOrder + 1);
+  const std::vector<std::vector<size_t>> kChannelIndices = {
+      {1, 2, 3}, {4, 0, 2}, {2, 3, 7}};
+
+  AmbisonicEncoder encoder(kNumInputChannels, kAmbisonicOrder);
+  encoder.SetSource(0, 1.0f, 30.0f, 10.0f, 1.0f);
+  encoder.SetSource(1, 0.5f, -60.0f, 0.0f, 2.0f);
+  encoder.SetSource(2, 1.0f, 150.0f, -20.0f, 1.0f);
+  AudioBuffer input_buffer(kNumBufferChannels, kBufferSize);
+  for (size_t channel = 0; channel < kNumBufferChannels; ++channel) {
+    for (size_t frame = 0; frame < kBufferSize; ++frame) {
+      input_buffer[channel][frame] =
+          static_cast<float>((channel * 5 + frame * 3) % 13) - 6.0f;
+    }
+  }
+  AudioBuffer gathered_input(kNumInputChannels, kBufferSize);
+  AudioBuffer expected_output(kNumOutputChannels, kBufferSize);
+  AudioBuffer output_buffer(kNumOutputChannels, kBufferSize);
+
+  for (const auto& channel_indices : kChannelIndices) {
+    for (size_t input = 0; input < kNumInputChannels; ++input) {
+      if (channel_indices[input] < kNumBufferChannels) {
+        gathered_input[input] = input_buffer[channel_indices[input]];
+      } else {
+        gathered_input[input].Clear();
+      }
+    }
+    encoder.ProcessActivePlanarAudioData(gathered_input, &expected_output);
+    encoder.ProcessActivePlanarAudioData(input_buffer, channel_indices,
+                                         &output_buffer);
+    for (size_t channel = 0; channel < kNumOutputChannels; ++channel) {
+      ASSERT_EQ(output_buffer[channel].IsEnabled(),
+                expected_output[channel].IsEnabled());
+      if (!expected_output[channel].IsEnabled()) {
+        continue;
+      }
+      for (size_t frame = 0; frame < kBufferSize; ++frame) {
+        EXPECT_NEAR(output_buffer[channel][frame],
+                    expected_output[channel][frame], 1e-5f);
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace obr
@@ -142,7 +142,10 @@ void ComputeUVWCoeff(int m, int n, int l, float* u, float* v, float* w) {
 void ComputeBandRotation(int l, std::vector<Eigen::MatrixXf>* rotations) {
   // The lth band rotation matrix has rows and columns equal to the number of
   // coefficients within that band (-l <= m <= l implies 2l + 1 coefficients).
-  Eigen::MatrixXf rotation(2 * l + 1, 2 * l + 1);
+  // It is preallocated and only depends on the matrices of bands 1 and l - 1,
+  // so it is updated in place.
+  Eigen::MatrixXf& rotation = (*rotations)[l];
+  DCHECK_EQ(rotation.rows(), 2 * l + 1);
   for (int m = -l; m <= l; ++m) {
     for (int n = -l; n <= l; ++n) {
       float u, v, w;
@@ -157,7 +160,6 @@ void ComputeBandRotation(int l, std::vector<Eigen::MatrixXf>* rotations) {
       rotation(m + l, n + l) = (u + v + w);
     }
   }
-  (*rotations)[l] = rotation;
 }
 
 // Rotation quantization which applies in ambisonic soundfield rotators.
@@ -165,6 +167,32 @@ static const float kRotationQuantizationRad = 1.0f * kRadiansFromDegrees;
 
 typedef WorldRotation AudioRotation;
 
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+    RowMajorMatrixf;
+
+// In order to perform a smooth rotation, buffers are rotated in chunks of at
+// most this many frames.
+const int kSlerpFrameInterval = 32;
+
+// Matrix for the result of rotating one chunk. The rotation is usually applied
+// in place, so the product needs a temporary. Its maximum size is fixed, which
+// keeps it on the stack.
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor,
+                      (kMaxSupportedAmbisonicOrder + 1) *
+                          (kMaxSupportedAmbisonicOrder + 1),
+                      kSlerpFrameInterval>
+    ChunkMatrixf;
+
+// Multiplies `input` by `rotation` into `output`, which may alias `input`.
+template <typename InputBlock, typename OutputBlock>
+void RotateChunk(const Eigen::MatrixXf& rotation, const InputBlock& input,
+                 OutputBlock output) {
+  DCHECK_LE(input.cols(), kSlerpFrameInterval);
+  ChunkMatrixf rotated_chunk(rotation.rows(), input.cols());
+  rotated_chunk.noalias() = rotation * input;
+  output = rotated_chunk;
+}
+
 // Converts `world_rotation` into an equivalent audio space rotation.
 // The world space follows the typical CG coordinate system convention:
 // Positive x points right, positive y points up, negative z points forward.
@@ -193,6 +221,7 @@ AmbisonicRotator::AmbisonicRotator(int ambisonic_order)
           static_cast<int>(GetNumPeriphonicComponents(ambisonic_order)),
           static_cast<int>(GetNumPeriphonicComponents(ambisonic_order))) {
   DCHECK_GE(ambisonic_order_, 1);
+  DCHECK_LE(ambisonic_order_, kMaxSupportedAmbisonicOrder);
 
   // Initialize rotation sub-matrices.
   // Order 0  matrix (first band) is simply the 1x1 identity.
@@ -226,10 +255,20 @@ bool AmbisonicRotator::Process(const WorldRotation& target_rotation,
     return false;
   }
 
-  const size_t channel_stride = input.GetChannelStride();
+  for (size_t channel = 0; channel < input.num_channels(); ++channel) {
+    if (!input[channel].IsEnabled()) {
+      RotateActiveBands(target_rotation, input, output);
+      return true;
+    }
+  }
+
+  if (&input != output) {
+    for (AudioBuffer::Channel& output_channel : *output) {
+      output_channel.SetEnabled(true);
+    }
+  }
 
-  typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
-      RowMajorMatrixf;
+  const size_t channel_stride = input.GetChannelStride();
 
   const Eigen::Map<const RowMajorMatrixf, Eigen::Aligned, Eigen::OuterStride<>>
       input_matrix(input[0].begin(), static_cast<int>(input.num_channels()),
@@ -242,37 +281,96 @@ bool AmbisonicRotator::Process(const WorldRotation& target_rotation,
                     static_cast<int>(input.num_frames()),
                     Eigen::OuterStride<>(static_cast<int>(channel_stride)));
 
-  if (current_rotation_.AngularDifferenceRad(target_rotation) <
-      kRotationQuantizationRad) {
-    output_matrix = rotation_matrix_ * input_matrix;
-    return true;
-  }
-
-  // In order to perform a smooth rotation, we divide the buffer into
-  // chunks of size `kSlerpFrameInterval`.
-  const size_t kSlerpFrameInterval = 32;
+  const bool is_rotation_changing =
+      current_rotation_.AngularDifferenceRad(target_rotation) >=
+      kRotationQuantizationRad;
 
-  WorldRotation slerped_rotation;
   // Rotate the input buffer at every slerp update interval. Truncate the
   // final chunk if the input buffer is not an integer multiple of the
   // chunk size.
   for (size_t i = 0; i < input.num_frames(); i += kSlerpFrameInterval) {
     const size_t duration =
-        std::min(input.num_frames() - i, kSlerpFrameInterval);
-    const float interpolation_factor = static_cast<float>(i + duration) /
-                                       static_cast<float>(input.num_frames());
-    UpdateRotationMatrix(
-        current_rotation_.slerp(interpolation_factor, target_rotation));
-    output_matrix.block(0 /* first channel */, i, output->num_channels(),
-                        duration) =
-        rotation_matrix_ * input_matrix.block(0 /* first channel */, i,
-                                              input.num_channels(), duration);
+        std::min(input.num_frames() - i, size_t{kSlerpFrameInterval});
+    if (is_rotation_changing) {
+      const float interpolation_factor =
+          static_cast<float>(i + duration) /
+          static_cast<float>(input.num_frames());
+      UpdateRotationMatrix(
+          current_rotation_.slerp(interpolation_factor, target_rotation));
+    }
+    RotateChunk(rotation_matrix_,
+                input_matrix.block(0 /* first channel */, i,
+                                   input.num_channels(), duration),
+                output_matrix.block(0 /* first channel */, i,
+                                    output->num_channels(), duration));
   }
   current_rotation_ = target_rotation;
 
   return true;
 }
 
+void AmbisonicRotator::RotateActiveBands(const WorldRotation& target_rotation,
+                                         const AudioBuffer& input,
+                                         AudioBuffer* output) {
+  // Each order is rotated independently, so silent orders are skipped. All
+  // channels of the other orders are enabled, with disabled inputs as zeros.
+  for (int order = 0; order <= ambisonic_order_; ++order) {
+    const size_t begin_channel = static_cast<size_t>(order * order);
+    const size_t end_channel = static_cast<size_t>((order + 1) * (order + 1));
+    bool is_band_active = false;
+    for (size_t channel = begin_channel; channel < end_channel; ++channel) {
+      is_band_active |= input[channel].IsEnabled();
+    }
+    for (size_t channel = begin_channel; channel < end_channel; ++channel) {
+      AudioBuffer::Channel& output_channel = (*output)[channel];
+      if (!is_band_active) {
+        output_channel.SetEnabled(false);
+      } else if (!input[channel].IsEnabled()) {
+        output_channel.SetEnabled(true);
+        output_channel.Clear();
+      } else if (&input != output) {
+        output_channel.SetEnabled(true);
+        output_channel = input[channel];
+      }
+    }
+  }
+
+  // Rotates the frames `[begin_frame, begin_frame + num_frames)` of the active
+  // bands in place. The zeroth order is invariant to rotations.
+  const int channel_stride = static_cast<int>(output->GetChannelStride());
+  auto rotate_bands = [&](size_t begin_frame, size_t num_frames) {
+    for (int order = 1; order <= ambisonic_order_; ++order) {
+      AudioBuffer::Channel& first_channel =
+          (*output)[static_cast<size_t>(order * order)];
+      if (!first_channel.IsEnabled()) {
+        continue;
+      }
+      Eigen::Map<RowMajorMatrixf, Eigen::Unaligned, Eigen::OuterStride<>> band(
+          first_channel.begin() + begin_frame, 2 * order + 1,
+          static_cast<int>(num_frames), Eigen::OuterStride<>(channel_stride));
+      RotateChunk(rotation_matrices_[order], band, band);
+    }
+  };
+
+  // Smooth rotation in chunks of `kSlerpFrameInterval` frames, see `Process()`.
+  const bool is_rotation_changing =
+      current_rotation_.AngularDifferenceRad(target_rotation) >=
+      kRotationQuantizationRad;
+  for (size_t i = 0; i < output->num_frames(); i += kSlerpFrameInterval) {
+    const size_t duration =
+        std::min(output->num_frames() - i, size_t{kSlerpFrameInterval});
+    if (is_rotation_changing) {
+      const float interpolation_factor =
+          static_cast<float>(i + duration) /
+          static_cast<float>(output->num_frames());
+      UpdateRotationMatrix(
+          current_rotation_.slerp(interpolation_factor, target_rotation));
+    }
+    rotate_bands(i, duration);
+  }
+  current_rotation_ = target_rotation;
+}
+
 void AmbisonicRotator::UpdateRotationMatrix(const WorldRotation& rotation) {
   // There is no need to update 0th order 1-element sub-matrix.
   // First order sub-matrix can be updated directly from the WorldRotation
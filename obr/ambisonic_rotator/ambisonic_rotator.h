@@ -32,10 +32,15 @@ class AmbisonicRotator {
   /*!\brief Performs a smooth inplace rotation of a sound field buffer from
    * |current_rotation_| to |target_rotation|.
    *
+   * Disabled input channels are treated as silence. Bands of a single order
+   * without enabled channels are not rotated and their output channels are
+   * disabled.
+   *
    * @param target_rotation Target rotation to be applied to the input buffer.
    * @param input Ambisonic sound field input buffer to be rotated.
    * @param output Pointer to output buffer.
-   * @return True if rotation has been applied.
+   * @return True if rotation has been applied. Otherwise `output` is left
+   *     untouched.
    */
   bool Process(const WorldRotation& target_rotation, const AudioBuffer& input,
                AudioBuffer* output);
@@ -47,6 +52,15 @@ class AmbisonicRotator {
    */
   void UpdateRotationMatrix(const WorldRotation& rotation);
 
+  /*!\brief Rotates only the bands of orders with enabled input channels.
+   *
+   * @param target_rotation Target rotation to be applied to the input buffer.
+   * @param input Ambisonic sound field input buffer with disabled channels.
+   * @param output Pointer to output buffer.
+   */
+  void RotateActiveBands(const WorldRotation& target_rotation,
+                         const AudioBuffer& input, AudioBuffer* output);
+
   // Order of the ambisonic sound field handled by the rotator.
   const int ambisonic_order_;
 
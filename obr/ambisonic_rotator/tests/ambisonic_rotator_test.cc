@@ -156,6 +156,97 @@ TEST_F(AmbisonicRotatorTest, RotationThresholdTest) {
       hoa_rotator_->Process(kLargeRotation, input_buffer, &output_buffer));
 }
 
+// Tests that disabled channels are rotated as silence and that orders without
+// enabled channels stay disabled, for smooth and constant rotations.
+TEST_F(AmbisonicRotatorTest, DisabledChannelsTest) {
+  const size_t kNumThirdOrderAmbisonicChannels = 16;
+  const size_t kFramesPerBuffer = kSlerpFrameInterval + 3;
+  const WorldRotation kRotation = WorldRotation(1.0f, 0.1f, 0.2f, 0.3f);
+  AmbisonicRotator rotator(kAmbisonicOrder);
+  AmbisonicRotator reference_rotator(kAmbisonicOrder);
+  AudioBuffer input_buffer(kNumThirdOrderAmbisonicChannels, kFramesPerBuffer);
+  AudioBuffer output_buffer(kNumThirdOrderAmbisonicChannels, kFramesPerBuffer);
+  AudioBuffer reference_buffer(kNumThirdOrderAmbisonicChannels,
+                               kFramesPerBuffer);
+
+  // The first smooth rotation runs in place, the following constant one out of
+  // place.
+  for (size_t run = 0; run < 2; ++run) {
+    input_buffer.Clear();
+    for (size_t channel = 0; channel < kNumThirdOrderAmbisonicChannels;
+         ++channel) {
+      for (size_t frame = 0; frame < kFramesPerBuffer; ++frame) {
+        input_buffer[channel][frame] =
+            static_cast<float>((channel * 7 + frame * 3 + run) % 11) - 5.0f;
+      }
+    }
+    // Disable one channel of the first order and all of the second order.
+    for (const size_t channel : {1, 4, 5, 6, 7, 8}) {
+      input_buffer[channel].Clear();
+    }
+    reference_buffer = input_buffer;
+    for (const size_t channel : {1, 4, 5, 6, 7, 8}) {
+      input_buffer[channel].SetEnabled(false);
+    }
+    output_buffer.Clear();
+    AudioBuffer* output = run == 0 ? &input_buffer : &output_buffer;
+    EXPECT_TRUE(rotator.Process(kRotation, input_buffer, output));
+    EXPECT_TRUE(reference_rotator.Process(kRotation, reference_buffer,
+                                          &reference_buffer));
+
+    for (size_t channel = 0; channel < kNumThirdOrderAmbisonicChannels;
+         ++channel) {
+      const bool is_second_order = channel >= 4 && channel < 9;
+      ASSERT_EQ((*output)[channel].IsEnabled(), !is_second_order);
+      if (is_second_order) {
+        continue;
+      }
+      for (size_t frame = 0; frame < kFramesPerBuffer; ++frame) {
+        EXPECT_NEAR((*output)[channel][frame],
+                    reference_buffer[channel][frame], kEpsilonFloat);
+      }
+    }
+  }
+}
+
+// Tests that rotating out of place enables all channels of the output buffer,
+// even if they were disabled before.
+TEST_F(AmbisonicRotatorTest, OutOfPlaceEnablesOutputChannelsTest) {
+  const size_t kNumThirdOrderAmbisonicChannels = 16;
+  const size_t kFramesPerBuffer = 16;
+  const WorldRotation kRotation = WorldRotation(1.0f, 0.1f, 0.2f, 0.3f);
+  AmbisonicRotator rotator(kAmbisonicOrder);
+  AmbisonicRotator reference_rotator(kAmbisonicOrder);
+  AudioBuffer input_buffer(kNumThirdOrderAmbisonicChannels, kFramesPerBuffer);
+  AudioBuffer output_buffer(kNumThirdOrderAmbisonicChannels, kFramesPerBuffer);
+  for (size_t channel = 0; channel < kNumThirdOrderAmbisonicChannels;
+       ++channel) {
+    for (size_t frame = 0; frame < kFramesPerBuffer; ++frame) {
+      input_buffer[channel][frame] =
+          static_cast<float>((channel * 5 + frame) % 7) - 3.0f;
+    }
+  }
+  AudioBuffer reference_buffer(kNumThirdOrderAmbisonicChannels,
+                               kFramesPerBuffer);
+  reference_buffer = input_buffer;
+  output_buffer.Clear();
+  for (const size_t channel : {0, 3, 9}) {
+    output_buffer[channel].SetEnabled(false);
+  }
+
+  EXPECT_TRUE(rotator.Process(kRotation, input_buffer, &output_buffer));
+  EXPECT_TRUE(reference_rotator.Process(kRotation, reference_buffer,
+                                        &reference_buffer));
+  for (size_t channel = 0; channel < kNumThirdOrderAmbisonicChannels;
+       ++channel) {
+    ASSERT_TRUE(output_buffer[channel].IsEnabled());
+    for (size_t frame = 0; frame < kFramesPerBuffer; ++frame) {
+      EXPECT_NEAR(output_buffer[channel][frame],
+                  reference_buffer[channel][frame], kEpsilonFloat);
+    }
+  }
+}
+
 typedef tuple<WorldPosition, SphericalAngle> TestParams;
 class AmbisonicAxesRotationTest
     : public AmbisonicRotatorTest,
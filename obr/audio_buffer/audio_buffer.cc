@@ -11,19 +11,52 @@
 #include <cstddef>
 #include <utility>
 
+#include "absl/log/check.h"
 #include "obr/audio_buffer/channel_view.h"
 #include "obr/audio_buffer/simd_utils.h"
 #include "obr/common/constants.h"
 
 namespace obr {
 
-AudioBuffer::AudioBuffer() : num_frames_(0) {}
+AudioBuffer::AudioBuffer() : num_frames_(0), data_size_(0), is_view_(false) {}
 
 AudioBuffer::AudioBuffer(size_t num_channels, size_t num_frames)
     : num_frames_(num_frames) {
   InitChannelViews(num_channels);
 }
 
+AudioBuffer::AudioBuffer(float* const* channel_ptrs, size_t num_channels,
+                         size_t num_frames)
+    : num_frames_(num_frames), data_size_(0), is_view_(true) {
+  Wrap(channel_ptrs, num_channels, num_frames);
+}
+
+void AudioBuffer::Wrap(float* const* channel_ptrs, size_t num_channels,
+                       size_t num_frames) {
+  DCHECK(channel_ptrs != nullptr || num_channels == 0);
+  DCHECK(CanWrap(channel_ptrs, num_channels));
+  num_frames_ = num_frames;
+  // Keeps the capacity of both vectors, so that re-wrapping on the audio
+  // thread does not allocate.
+  data_.clear();
+  data_size_ = 0;
+  is_view_ = true;
+  channel_views_.clear();
+  for (size_t i = 0; i < num_channels; ++i) {
+    channel_views_.push_back(ChannelView(channel_ptrs[i], num_frames_));
+  }
+}
+
+bool AudioBuffer::CanWrap(const float* const* channel_ptrs,
+                          size_t num_channels) {
+  for (size_t i = 0; i < num_channels; ++i) {
+    if (channel_ptrs[i] == nullptr || !IsAligned(channel_ptrs[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Copy assignment from AudioBuffer.
 AudioBuffer& AudioBuffer::operator=(const AudioBuffer& other) {
   if (this != &other) {
@@ -42,6 +75,7 @@ AudioBuffer::AudioBuffer(AudioBuffer&& other) {
   data_ = std::move(other.data_);
   data_size_ = other.data_size_;
   other.data_size_ = 0;
+  is_view_ = other.is_view_;
   channel_views_ = std::move(other.channel_views_);
 }
 
@@ -51,6 +85,7 @@ void AudioBuffer::InitChannelViews(size_t num_channels) {
 
   data_size_ = num_channels * num_frames_to_next_channel;
   data_.resize(data_size_);
+  is_view_ = false;
 
   channel_views_.clear();
   channel_views_.reserve(num_channels);
@@ -99,6 +99,16 @@ class AudioBuffer {
    */
   AudioBuffer(size_t num_channels, size_t num_frames);
 
+  /*!\brief Constructs a non-owning view of external planar audio data, see
+   * `Wrap()`.
+   *
+   * \param channel_ptrs Pointers to the first frame of each channel.
+   * \param num_channels Number of channels.
+   * \param num_frames Number of frames.
+   */
+  AudioBuffer(float* const* channel_ptrs, size_t num_channels,
+              size_t num_frames);
+
   // Move constructor.
   AudioBuffer(AudioBuffer&& other);
 
@@ -109,6 +119,31 @@ class AudioBuffer {
   // Copy assignment from AudioBuffer.
   AudioBuffer& operator=(const AudioBuffer& other);
 
+  /*!\brief Turns the buffer into a non-owning view of external planar audio
+   * data, which must outlive the view. The channels must be aligned for SIMD,
+   * see `CanWrap()`. Previously owned data is no longer used. Does not
+   * allocate as long as `num_channels` does not exceed the number of channels
+   * the buffer had before.
+   *
+   * \param channel_ptrs Pointers to the first frame of each channel.
+   * \param num_channels Number of channels.
+   * \param num_frames Number of frames.
+   */
+  void Wrap(float* const* channel_ptrs, size_t num_channels,
+            size_t num_frames);
+
+  /*!\brief Checks if external planar audio data can be wrapped without
+   * copying, i.e. if all channels are aligned for SIMD.
+   *
+   * \param channel_ptrs Pointers to the first frame of each channel.
+   * \param num_channels Number of channels.
+   * \return True if the channels can be wrapped.
+   */
+  static bool CanWrap(const float* const* channel_ptrs, size_t num_channels);
+
+  // Returns true if the buffer is a view of external data, see `Wrap()`.
+  bool IsView() const { return is_view_; }
+
   // Returns the number of audio channels.
   size_t num_channels() const { return channel_views_.size(); }
 
@@ -182,8 +217,9 @@ class AudioBuffer {
 
   // Returns the number of allocated frames per `Channel`. Note this may
   // differ from the actual size of the `Channel` to ensure alignment of all
-  // `Channel`s.
+  // `Channel`s. Views of external data have no common stride.
   size_t GetChannelStride() const {
+    DCHECK(!is_view_);
     return FindNextAlignedArrayIndex(num_frames_, sizeof(float),
                                      kMemoryAlignmentBytes);
   }
@@ -199,9 +235,12 @@ class AudioBuffer {
   // format.
   AlignedFloatVector data_;
 
-  // Size of audio buffer.
+  // Size of audio buffer, zero for views of external data.
   size_t data_size_;
 
+  // True if the `Channel`s point to external data.
+  bool is_view_;
+
   // Vector of `AudioBuffer::Channel`s.
   std::vector<Channel> channel_views_;
 };
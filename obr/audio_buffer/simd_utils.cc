@@ -14,14 +14,25 @@
 #include "obr/audio_buffer/simd_utils.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "absl/log/check.h"
 #include "obr/audio_buffer/simd_macros.h"
 #include "obr/common/constants.h"
 #include "obr/common/misc_math.h"
 
+#if defined(SIMD_NEON) || \
+    (defined(SIMD_SSE) && (defined(__SSE2__) || defined(_M_X64)))
+// Half precision values can be widened with SIMD integer instructions.
+#define SIMD_HALF_PRECISION
+#ifdef SIMD_SSE
+#include <emmintrin.h>
+#endif  // SIMD_SSE
+#endif  // defined(SIMD_NEON) || defined(SIMD_SSE) ...
+
 namespace obr {
 
 namespace {
@@ -60,6 +71,129 @@ inline void ComplexMagnitude(float real, float imaginary, float* output) {
 }
 #endif  // defined(SIMD_DISABLED)
 
+// Float bits of the smallest value which rounds to infinity in half precision.
+const uint32_t kHalfOverflowFloatBits = 0x477ff000;
+
+// Float bits of the smallest normal half precision value, 2^-14.
+const uint32_t kMinNormalHalfFloatBits = 0x38800000;
+
+// Largest finite half precision value, 65504.
+const uint16_t kMaxHalf = 0x7bff;
+
+// Float bits of 2^112, which rebiases a half precision exponent moved into the
+// float exponent field, including for subnormal values.
+const uint32_t kHalfExponentRebiasBits = 0x77800000;
+
+inline uint16_t HalfFromFloatScalar(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  bits &= 0x7fffffff;
+  if (bits >= kHalfOverflowFloatBits) {
+    return sign | kMaxHalf;
+  }
+  if (bits < kMinNormalHalfFloatBits) {
+    // Adding 0.5 moves the subnormal half mantissa into the lowest float
+    // mantissa bits, rounded to nearest even by the FPU.
+    float subnormal;
+    std::memcpy(&subnormal, &bits, sizeof(subnormal));
+    subnormal += 0.5f;
+    std::memcpy(&bits, &subnormal, sizeof(bits));
+    return sign | static_cast<uint16_t>(bits - 0x3f000000);
+  }
+  // Rebias the exponent from 127 to 15 and round to nearest even.
+  const uint32_t mantissa_odd = (bits >> 13) & 1;
+  bits += 0xc8000fff + mantissa_odd;
+  return sign | static_cast<uint16_t>(bits >> 13);
+}
+
+inline float FloatFromHalfScalar(uint16_t half) {
+  const uint32_t magnitude_bits = static_cast<uint32_t>(half & 0x7fff) << 13;
+  float magnitude, rebias;
+  std::memcpy(&magnitude, &magnitude_bits, sizeof(magnitude));
+  std::memcpy(&rebias, &kHalfExponentRebiasBits, sizeof(rebias));
+  magnitude *= rebias;
+  return (half & 0x8000) != 0 ? -magnitude : magnitude;
+}
+
+inline float ToFloat(float value) { return value; }
+
+inline float ToFloat(uint16_t half) { return FloatFromHalfScalar(half); }
+
+#ifdef SIMD_HALF_PRECISION
+// Widens `SIMD_LENGTH` half precision values, see `FloatFromHalfScalar`.
+inline SimdVector LoadSimdVector(const uint16_t* input) {
+#ifdef SIMD_SSE
+  const __m128i wide = _mm_unpacklo_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input)),
+      _mm_setzero_si128());
+  const __m128i sign =
+      _mm_slli_epi32(_mm_and_si128(wide, _mm_set1_epi32(0x8000)), 16);
+  const __m128i magnitude =
+      _mm_slli_epi32(_mm_and_si128(wide, _mm_set1_epi32(0x7fff)), 13);
+  const __m128 rebiased_magnitude =
+      _mm_mul_ps(_mm_castsi128_ps(magnitude),
+                 _mm_castsi128_ps(_mm_set1_epi32(kHalfExponentRebiasBits)));
+  return _mm_or_ps(rebiased_magnitude, _mm_castsi128_ps(sign));
+#else
+  const uint32x4_t wide = vmovl_u16(vld1_u16(input));
+  const uint32x4_t sign = vshlq_n_u32(vandq_u32(wide, vdupq_n_u32(0x8000)), 16);
+  const uint32x4_t magnitude =
+      vshlq_n_u32(vandq_u32(wide, vdupq_n_u32(0x7fff)), 13);
+  const float32x4_t rebiased_magnitude =
+      vmulq_f32(vreinterpretq_f32_u32(magnitude),
+                vreinterpretq_f32_u32(vdupq_n_u32(kHalfExponentRebiasBits)));
+  return vreinterpretq_f32_u32(
+      vorrq_u32(vreinterpretq_u32_f32(rebiased_magnitude), sign));
+#endif  // SIMD_SSE
+}
+
+inline SimdVector LoadSimdVector(const float* input) {
+  return *reinterpret_cast<const SimdVector*>(input);
+}
+#endif  // SIMD_HALF_PRECISION
+
+template <typename InputType>
+void ComplexMultiplyAndAccumulateHalfTemplated(size_t length, float gain,
+                                               const InputType* input_a,
+                                               const uint16_t* input_b,
+                                               float* accumulator) {
+  DCHECK_NE(input_a, nullptr);
+  DCHECK_NE(input_b, nullptr);
+  DCHECK_NE(accumulator, nullptr);
+  DCHECK_EQ(length % (2 * SIMD_LENGTH), 0U);
+#ifdef SIMD_HALF_PRECISION
+  DCHECK(IsAligned(accumulator));
+  const SimdVector gain_vector = SIMD_LOAD_ONE_FLOAT(gain);
+  SimdVector* accumulator_vector = reinterpret_cast<SimdVector*>(accumulator);
+  for (size_t i = 0; i < length; i += 2 * SIMD_LENGTH) {
+    const SimdVector real_a = LoadSimdVector(input_a + i);
+    const SimdVector imag_a = LoadSimdVector(input_a + i + SIMD_LENGTH);
+    const SimdVector real_b = LoadSimdVector(input_b + i);
+    const SimdVector imag_b = LoadSimdVector(input_b + i + SIMD_LENGTH);
+    const SimdVector real =
+        SIMD_SUB(SIMD_MULTIPLY(real_a, real_b), SIMD_MULTIPLY(imag_a, imag_b));
+    const SimdVector imag =
+        SIMD_MULTIPLY_ADD(real_a, imag_b, SIMD_MULTIPLY(imag_a, real_b));
+    SimdVector* block = accumulator_vector + i / SIMD_LENGTH;
+    block[0] = SIMD_MULTIPLY_ADD(gain_vector, real, block[0]);
+    block[1] = SIMD_MULTIPLY_ADD(gain_vector, imag, block[1]);
+  }
+#else
+  for (size_t i = 0; i < length; i += 2 * SIMD_LENGTH) {
+    for (size_t j = i; j < i + SIMD_LENGTH; ++j) {
+      const float real_a = ToFloat(input_a[j]);
+      const float imag_a = ToFloat(input_a[j + SIMD_LENGTH]);
+      const float real_b = FloatFromHalfScalar(input_b[j]);
+      const float imag_b = FloatFromHalfScalar(input_b[j + SIMD_LENGTH]);
+      accumulator[j] += gain * (real_a * real_b - imag_a * imag_b);
+      accumulator[j + SIMD_LENGTH] +=
+          gain * (real_a * imag_b + imag_a * real_b);
+    }
+  }
+#endif  // SIMD_HALF_PRECISION
+}
+
 }  // namespace
 
 bool IsAligned(const float* pointer) {
@@ -106,14 +240,14 @@ void AddPointwise(size_t length, const float* input_a, const float* input_b,
     }
   } else if (output_aligned) {
     for (size_t i = 0; i < num_chunks; ++i) {
-      const SimdVector input_a_temp = _mm_load_ps(&input_a[i * SIMD_LENGTH]);
-      const SimdVector input_b_temp = _mm_load_ps(&input_b[i * SIMD_LENGTH]);
+      const SimdVector input_a_temp = _mm_loadu_ps(&input_a[i * SIMD_LENGTH]);
+      const SimdVector input_b_temp = _mm_loadu_ps(&input_b[i * SIMD_LENGTH]);
       output_vector[i] = SIMD_ADD(input_a_temp, input_b_temp);
     }
   } else {
     for (size_t i = 0; i < num_chunks; ++i) {
-      const SimdVector input_a_temp = _mm_load_ps(&input_a[i * SIMD_LENGTH]);
-      const SimdVector input_b_temp = _mm_load_ps(&input_b[i * SIMD_LENGTH]);
+      const SimdVector input_a_temp = _mm_loadu_ps(&input_a[i * SIMD_LENGTH]);
+      const SimdVector input_b_temp = _mm_loadu_ps(&input_b[i * SIMD_LENGTH]);
       const SimdVector output_temp = SIMD_ADD(input_a_temp, input_b_temp);
       _mm_storeu_ps(&output[i * SIMD_LENGTH], output_temp);
     }
@@ -160,14 +294,14 @@ void SubtractPointwise(size_t length, const float* input_a,
     }
   } else if (output_aligned) {
     for (size_t i = 0; i < num_chunks; ++i) {
-      const SimdVector input_a_temp = _mm_load_ps(&input_a[i * SIMD_LENGTH]);
-      const SimdVector input_b_temp = _mm_load_ps(&input_b[i * SIMD_LENGTH]);
+      const SimdVector input_a_temp = _mm_loadu_ps(&input_a[i * SIMD_LENGTH]);
+      const SimdVector input_b_temp = _mm_loadu_ps(&input_b[i * SIMD_LENGTH]);
       output_vector[i] = SIMD_SUB(input_b_temp, input_a_temp);
     }
   } else {
     for (size_t i = 0; i < num_chunks; ++i) {
-      const SimdVector input_a_temp = _mm_load_ps(&input_a[i * SIMD_LENGTH]);
-      const SimdVector input_b_temp = _mm_load_ps(&input_b[i * SIMD_LENGTH]);
+      const SimdVector input_a_temp = _mm_loadu_ps(&input_a[i * SIMD_LENGTH]);
+      const SimdVector input_b_temp = _mm_loadu_ps(&input_b[i * SIMD_LENGTH]);
       const SimdVector output_temp = SIMD_SUB(input_b_temp, input_a_temp);
       _mm_storeu_ps(&output[i * SIMD_LENGTH], output_temp);
     }
@@ -1186,4 +1320,76 @@ void DeinterleaveStereo(size_t length, const int16_t* interleaved_buffer,
   }
 }
 
+void HalfFromFloat(size_t length, float gain, const float* input,
+                   uint16_t* output) {
+  DCHECK_NE(input, nullptr);
+  DCHECK_NE(output, nullptr);
+  for (size_t i = 0; i < length; ++i) {
+    output[i] = HalfFromFloatScalar(gain * input[i]);
+  }
+}
+
+void FloatFromHalf(size_t length, const uint16_t* input, float* output) {
+  DCHECK_NE(input, nullptr);
+  DCHECK_NE(output, nullptr);
+  size_t leftover_samples = length;
+#ifdef SIMD_HALF_PRECISION
+  for (size_t i = 0; i < GetNumChunks(length); ++i) {
+    const SimdVector output_temp = LoadSimdVector(&input[i * SIMD_LENGTH]);
+#ifdef SIMD_SSE
+    _mm_storeu_ps(&output[i * SIMD_LENGTH], output_temp);
+#else
+    vst1q_f32(&output[i * SIMD_LENGTH], output_temp);
+#endif  // SIMD_SSE
+  }
+  leftover_samples = GetLeftoverSamples(length);
+#endif  // SIMD_HALF_PRECISION
+
+  // The remainder.
+  for (size_t i = length - leftover_samples; i < length; ++i) {
+    output[i] = FloatFromHalfScalar(input[i]);
+  }
+}
+
+size_t GetSimdLength() { return SIMD_LENGTH; }
+
+void ComplexMultiplyAndAccumulateHalf(size_t length, float gain,
+                                      const float* input_a,
+                                      const uint16_t* input_b,
+                                      float* accumulator) {
+  ComplexMultiplyAndAccumulateHalfTemplated(length, gain, input_a, input_b,
+                                            accumulator);
+}
+
+void ComplexMultiplyAndAccumulateHalf(size_t length, float gain,
+                                      const uint16_t* input_a,
+                                      const uint16_t* input_b,
+                                      float* accumulator) {
+  ComplexMultiplyAndAccumulateHalfTemplated(length, gain, input_a, input_b,
+                                            accumulator);
+}
+
+bool IsBelowThreshold(size_t length, float threshold, const float* input) {
+  DCHECK_NE(input, nullptr);
+  // Blocks of values are reduced at once, which vectorizes and still returns
+  // early for arrays with values above the threshold.
+  const size_t kBlockSize = 4 * SIMD_LENGTH;
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize) {
+    float max_magnitude = 0.0f;
+    for (size_t j = i; j < i + kBlockSize; ++j) {
+      max_magnitude = std::max(max_magnitude, std::abs(input[j]));
+    }
+    if (max_magnitude >= threshold) {
+      return false;
+    }
+  }
+  for (; i < length; ++i) {
+    if (std::abs(input[i]) >= threshold) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace obr
@@ -36,7 +36,8 @@ size_t FindNextAlignedArrayIndex(size_t length, size_t type_size_bytes,
                                  size_t memory_alignment_bytes);
 
 /*!\brief Adds a float array `input_a` to another float array `input_b` and
- * stores the result in `output`.
+ * stores the result in `output`. The arrays need not be aligned, e.g. for the
+ * overlap-add of non power of two block sizes.
  *
  * \param length Number of floats.
  * \param input_a Pointer to the first float in input_a array.
@@ -181,6 +182,67 @@ void Int16FromFloat(size_t length, const float* input, int16_t* output);
  */
 void FloatFromInt16(size_t length, const int16_t* input, float* output);
 
+/*!\brief Converts an array of 32 bit floats, multiplied by a gain, to IEEE 754
+ * half precision (16 bit) floats with round to nearest even. Values beyond the
+ * half precision range are clamped to the largest finite half precision value.
+ *
+ * \param length Number of floats in the input array and halfs in the output.
+ * \param gain Gain applied to the input before the conversion.
+ * \param input Float array.
+ * \param output Half precision array.
+ */
+void HalfFromFloat(size_t length, float gain, const float* input,
+                   uint16_t* output);
+
+/*!\brief Converts an array of IEEE 754 half precision floats to 32 bit floats.
+ * Infinities and NaNs are not supported.
+ *
+ * \param length Number of halfs in the input array and floats in the output.
+ * \param input Half precision array.
+ * \param output Float array.
+ */
+void FloatFromHalf(size_t length, const uint16_t* input, float* output);
+
+/*!\brief Returns the number of floats processed by a single SIMD instruction,
+ * or 1 if SIMD is disabled.
+ *
+ * \return SIMD vector length in floats.
+ */
+size_t GetSimdLength();
+
+/*!\brief Multiplies two arrays of complex numbers pointwise and adds the
+ * products, multiplied by `gain`, to `accumulator`. The complex numbers are
+ * stored in blocks of `GetSimdLength()` real parts followed by the same number
+ * of imaginary parts, which is the spectrum layout of SIMD enabled pffft
+ * builds. The second input is stored in half precision and widened on the fly,
+ * which halves its memory traffic. All arrays must be aligned.
+ *
+ * \param length Number of floats in each array, a multiple of twice
+ *     `GetSimdLength()`.
+ * \param gain Gain applied to the products.
+ * \param input_a First input array.
+ * \param input_b Second input array in half precision.
+ * \param accumulator Array the products are added to.
+ */
+void ComplexMultiplyAndAccumulateHalf(size_t length, float gain,
+                                      const float* input_a,
+                                      const uint16_t* input_b,
+                                      float* accumulator);
+
+/*!\brief As above, but with both inputs stored in half precision.
+ *
+ * \param length Number of values in each array, a multiple of twice
+ *     `GetSimdLength()`.
+ * \param gain Gain applied to the products.
+ * \param input_a First input array in half precision.
+ * \param input_b Second input array in half precision.
+ * \param accumulator Array the products are added to.
+ */
+void ComplexMultiplyAndAccumulateHalf(size_t length, float gain,
+                                      const uint16_t* input_a,
+                                      const uint16_t* input_b,
+                                      float* accumulator);
+
 /*!\brief Interleaves a pair of mono buffers of int16_t data into a stereo
  * buffer.
  *
@@ -252,6 +314,17 @@ void DeinterleaveStereo(size_t length, const float* interleaved_buffer,
 void DeinterleaveStereo(size_t length, const int16_t* interleaved_buffer,
                         float* channel_0, float* channel_1);
 
+/*!\brief Checks if the magnitudes of all values of an array are below a
+ * threshold, e.g. to detect silent channels. Returns early for arrays with
+ * values above the threshold.
+ *
+ * \param length Length of the array.
+ * \param threshold Magnitude threshold.
+ * \param input Float array.
+ * \return True if all magnitudes are below `threshold`.
+ */
+bool IsBelowThreshold(size_t length, float threshold, const float* input);
+
 }  // namespace obr
 
 #endif  // OBR_AUDIO_BUFFER_SIMD_UTILS_H_
@@ -83,6 +83,56 @@ TEST(AudioBuffer, AudioBufferMoveConstructor) {
   }
 }
 
+// Tests that views of external data access it without copies.
+TEST(AudioBuffer, AudioBufferView) {
+  static const size_t kNumChannels = 3;
+  static const size_t kFramesPerBuffer = 5;
+  AudioBuffer storage(kNumChannels, kFramesPerBuffer);
+  float* channel_ptrs[kNumChannels];
+  for (size_t channel = 0; channel < kNumChannels; ++channel) {
+    channel_ptrs[channel] = storage[channel].begin();
+  }
+  EXPECT_TRUE(AudioBuffer::CanWrap(channel_ptrs, kNumChannels));
+
+  AudioBuffer view(channel_ptrs, kNumChannels, kFramesPerBuffer);
+  EXPECT_TRUE(view.IsView());
+  EXPECT_FALSE(storage.IsView());
+  EXPECT_EQ(view.num_channels(), kNumChannels);
+  EXPECT_EQ(view.num_frames(), kFramesPerBuffer);
+  view.Clear();
+  view[1][2] = 1.0f;
+  for (size_t channel = 0; channel < kNumChannels; ++channel) {
+    EXPECT_EQ(view[channel].begin(), channel_ptrs[channel]);
+    for (size_t frame = 0; frame < kFramesPerBuffer; ++frame) {
+      EXPECT_EQ(storage[channel][frame],
+                channel == 1 && frame == 2 ? 1.0f : 0.0f);
+    }
+  }
+
+  // Re-wrapping fewer channels and frames, and turning an owning buffer into
+  // a view.
+  view.Wrap(channel_ptrs + 1, 2, 3);
+  EXPECT_EQ(view.num_channels(), 2U);
+  EXPECT_EQ(view.num_frames(), 3U);
+  EXPECT_EQ(view[0][2], 1.0f);
+  AudioBuffer owning_buffer(1, kFramesPerBuffer);
+  owning_buffer.Wrap(channel_ptrs, 1, kFramesPerBuffer);
+  EXPECT_TRUE(owning_buffer.IsView());
+  EXPECT_EQ(owning_buffer[0].begin(), channel_ptrs[0]);
+}
+
+// Tests that only aligned channels can be wrapped.
+TEST(AudioBuffer, AudioBufferCanWrap) {
+  AudioBuffer storage(2, 16);
+  const float* channel_ptrs[] = {storage[0].begin(), storage[1].begin()};
+  EXPECT_TRUE(AudioBuffer::CanWrap(channel_ptrs, 2));
+  channel_ptrs[1] += 1;
+  EXPECT_FALSE(AudioBuffer::CanWrap(channel_ptrs, 2));
+  channel_ptrs[1] = nullptr;
+  EXPECT_FALSE(AudioBuffer::CanWrap(channel_ptrs, 2));
+  EXPECT_TRUE(AudioBuffer::CanWrap(channel_ptrs, 1));
+}
+
 // Tests memory alignment of each channel buffer. The address if the first
 // element of each channel should be memory aligned.
 TEST(AudioBuffer, TestBufferAlignment) {
@@ -12,9 +12,11 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "obr/audio_buffer/aligned_allocator.h"
 #include "obr/audio_buffer/audio_buffer.h"
 #include "obr/common/constants.h"
 
@@ -92,6 +94,29 @@ TEST(SimdUtilsTest, AddPointwiseInPlaceTest) {
   }
 }
 
+// Tests that every combination of aligned and unaligned arrays is summed up
+// correctly, as required by the overlap-add of non power of two block sizes.
+TEST(SimdUtilsTest, AddPointwiseUnalignedTest) {
+  const size_t kLength = 37;
+  AudioBuffer audio_buffer(kNumTestChannels, kLength + 1);
+  for (size_t input_offset = 0; input_offset < 2; ++input_offset) {
+    for (size_t output_offset = 0; output_offset < 2; ++output_offset) {
+      audio_buffer.Clear();
+      for (size_t i = 0; i < kLength; ++i) {
+        audio_buffer[0][i + input_offset] = static_cast<float>(i);
+        audio_buffer[1][i + input_offset] = static_cast<float>(2 * i);
+      }
+      AddPointwise(kLength, &audio_buffer[0][input_offset],
+                   &audio_buffer[1][input_offset],
+                   &audio_buffer[2][output_offset]);
+      for (size_t i = 0; i < kLength; ++i) {
+        EXPECT_FLOAT_EQ(audio_buffer[2][i + output_offset],
+                        static_cast<float>(3 * i));
+      }
+    }
+  }
+}
+
 TEST(SimdUtilsTest, SubtractPointwiseTest) {
   AudioBuffer aligned_audio_buffer(kNumStereoChannels, kInputSize);
   aligned_audio_buffer.Clear();
@@ -577,6 +602,122 @@ TEST(SimdUtilsTest, FloatFromInt16Test) {
   }
 }
 
+TEST(SimdUtilsTest, HalfFromFloatTest) {
+  // Inputs with their expected half precision bits, covering rounding to
+  // nearest even, subnormals and clamping to the largest finite value.
+  const std::vector<std::pair<float, uint16_t>> kExpectedHalfs = {
+      {0.0f, 0x0000},
+      {1.0f, 0x3c00},
+      {-2.0f, 0xc000},
+      {0.1f, 0x2e66},
+      {1.0f + std::ldexp(1.0f, -11), 0x3c00},
+      {1.0f + 3.0f * std::ldexp(1.0f, -11), 0x3c02},
+      {std::ldexp(1.0f, -24), 0x0001},
+      {-std::ldexp(1.0f, -15), 0x8200},
+      {65504.0f, 0x7bff},
+      {1e6f, 0x7bff},
+      {-1e6f, 0xfbff}};
+  for (const auto& [input, expected_half] : kExpectedHalfs) {
+    uint16_t half;
+    HalfFromFloat(1, 1.0f, &input, &half);
+    EXPECT_EQ(half, expected_half) << input;
+  }
+
+  // The gain is applied before the conversion.
+  const float kInput = 0.25f;
+  uint16_t half;
+  HalfFromFloat(1, 4.0f, &kInput, &half);
+  EXPECT_EQ(half, 0x3c00);
+}
+
+TEST(SimdUtilsTest, FloatFromHalfTest) {
+  // All finite half precision values are converted exactly and back.
+  std::vector<uint16_t> halfs;
+  for (uint32_t half = 0; half <= 0xffff; ++half) {
+    if ((half & 0x7c00) != 0x7c00) {
+      halfs.push_back(static_cast<uint16_t>(half));
+    }
+  }
+  std::vector<float> floats(halfs.size());
+  FloatFromHalf(halfs.size(), halfs.data(), floats.data());
+  EXPECT_EQ(floats[0x3c00], 1.0f);
+  EXPECT_EQ(floats[0x0001], std::ldexp(1.0f, -24));
+  EXPECT_EQ(floats[0x7bff], 65504.0f);
+
+  std::vector<uint16_t> converted_halfs(halfs.size());
+  HalfFromFloat(floats.size(), 1.0f, floats.data(), converted_halfs.data());
+  for (size_t i = 0; i < halfs.size(); ++i) {
+    EXPECT_EQ(converted_halfs[i], halfs[i]);
+  }
+}
+
+TEST(SimdUtilsTest, ComplexMultiplyAndAccumulateHalfTest) {
+  const size_t kLength = 8 * GetSimdLength();
+  const float kGain = 0.5f;
+  AudioBuffer buffer(4, kLength);
+  for (size_t i = 0; i < kLength; ++i) {
+    buffer[0][i] = std::sin(static_cast<float>(i));
+    buffer[1][i] = std::cos(static_cast<float>(3 * i));
+    buffer[2][i] = 0.25f * static_cast<float>(i);
+  }
+  std::vector<uint16_t, AlignedAllocator<uint16_t, kMemoryAlignmentBytes>>
+      half_a(kLength), half_b(kLength);
+  HalfFromFloat(kLength, 1.0f, &buffer[0][0], half_a.data());
+  HalfFromFloat(kLength, 1.0f, &buffer[1][0], half_b.data());
+  // Use the half precision values as float input so that the results can be
+  // compared to a float reference.
+  FloatFromHalf(kLength, half_a.data(), &buffer[0][0]);
+  FloatFromHalf(kLength, half_b.data(), &buffer[1][0]);
+
+  // Reference product of blocks of `GetSimdLength()` real parts followed by
+  // the same number of imaginary parts.
+  const size_t simd_length = GetSimdLength();
+  std::vector<float> expected(kLength);
+  for (size_t block = 0; block < kLength; block += 2 * simd_length) {
+    for (size_t i = block; i < block + simd_length; ++i) {
+      const float real_a = buffer[0][i];
+      const float imag_a = buffer[0][i + simd_length];
+      const float real_b = buffer[1][i];
+      const float imag_b = buffer[1][i + simd_length];
+      expected[i] =
+          buffer[2][i] + kGain * (real_a * real_b - imag_a * imag_b);
+      expected[i + simd_length] = buffer[2][i + simd_length] +
+                                  kGain * (real_a * imag_b + imag_a * real_b);
+    }
+  }
+
+  buffer[3] = buffer[2];
+  ComplexMultiplyAndAccumulateHalf(kLength, kGain, &buffer[0][0],
+                                   half_b.data(), &buffer[2][0]);
+  ComplexMultiplyAndAccumulateHalf(kLength, kGain, half_a.data(),
+                                   half_b.data(), &buffer[3][0]);
+  for (size_t i = 0; i < kLength; ++i) {
+    EXPECT_NEAR(buffer[2][i], expected[i], kFloatEpsilon);
+    EXPECT_NEAR(buffer[3][i], expected[i], kFloatEpsilon);
+  }
+}
+
+TEST(SimdUtilsTest, IsBelowThresholdTest) {
+  const float kThreshold = 1e-3f;
+  // Lengths covering the vectorized blocks and the scalar remainder.
+  for (size_t length : {size_t{1}, size_t{7}, 4 * GetSimdLength(),
+                        9 * GetSimdLength() + 3}) {
+    AudioBuffer buffer(kNumMonoChannels, length);
+    buffer.Clear();
+    EXPECT_TRUE(IsBelowThreshold(length, kThreshold, &buffer[0][0]));
+    for (size_t i = 0; i < length; ++i) {
+      buffer[0][i] = (i % 2 == 0 ? 0.5f : -0.5f) * kThreshold;
+    }
+    EXPECT_TRUE(IsBelowThreshold(length, kThreshold, &buffer[0][0]));
+    // A single negative value exceeding the threshold is detected anywhere.
+    for (size_t i = 0; i < length; ++i) {
+      buffer[0][i] = -2.0f * kThreshold;
+      EXPECT_FALSE(IsBelowThreshold(length, kThreshold, &buffer[0][0]));
+      buffer[0][i] = 0.0f;
+    }
+  }
+}
+
 }  // namespace
 
 }  // namespace obr
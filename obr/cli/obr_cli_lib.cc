@@ -19,7 +19,6 @@
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
-#include "obr/audio_buffer/audio_buffer.h"
 #include "obr/cli/proto/oba_metadata.pb.h"
 #include "obr/renderer/audio_element_type.h"
 #include "obr/renderer/obr_impl.h"
@@ -102,17 +101,19 @@ absl::Status ObrCliMain(AudioElementType input_type,
   // Initialize the buffers.
   std::vector<int16_t> input_buffer_int16(buffer_size * input_wav_nch);
   std::vector<int16_t> output_buffer_int16(buffer_size * output_wav_nch);
-  std::vector<std::vector<float>> input_buffer_float(
-      input_wav_nch, std::vector<float>(buffer_size));
-  std::vector<std::vector<float>> output_buffer_float(
-      output_wav_nch, std::vector<float>(buffer_size));
 
   // Initialize obr object.
   ObrImpl obr_obj(buffer_size, input_wav_fs);
 
-  // If OBA input, set the sources within the renderer.
+  // If OBA input, set the sources within the renderer. The DSP is initialized
+  // once for all objects.
   if (input_type == AudioElementType::kObjectMono) {
     LOG(INFO) << "Providing OBA metadata to the renderer:";
+    auto status = obr_obj.BeginConfiguration();
+    if (!status.ok()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Error starting configuration: ", status.message()));
+    }
     for (const auto& source : source_list.source()) {
       LOG(INFO) << "  WAV file ch (0-indexed): " << source.input_channel();
       LOG(INFO) << "    Azimuth: " << source.azimuth();
@@ -121,7 +122,7 @@ absl::Status ObrCliMain(AudioElementType input_type,
       LOG(INFO) << "    Gain: " << source.gain();
 
       // Add audio element.
-      auto status = obr_obj.AddAudioElement(input_type);
+      status = obr_obj.AddAudioElement(input_type);
       if (!status.ok()) {
         return absl::InvalidArgumentError(
             absl::StrCat("Error adding audio element: ", status.message()));
@@ -139,6 +140,11 @@ absl::Status ObrCliMain(AudioElementType input_type,
             absl::StrCat("Error updating object position: ", status.message()));
       }
     }
+    status = obr_obj.CommitConfiguration();
+    if (!status.ok()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Error committing configuration: ", status.message()));
+    }
   } else {
     // Add single audio element.
     auto status = obr_obj.AddAudioElement(input_type);
@@ -187,34 +193,9 @@ absl::Status ObrCliMain(AudioElementType input_type,
         Read16BitWavSamples(input_file, &info, input_buffer_int16.data(),
                             input_buffer_int16.size());
 
-    // Convert int16_t interleaved to float planar.
-    for (size_t smp = 0; smp < buffer_size; smp++) {
-      for (size_t ch = 0; ch < input_wav_nch; ch++) {
-        input_buffer_float[ch][smp] =
-            static_cast<float>(input_buffer_int16[smp * input_wav_nch + ch]) /
-            32768.0f;
-      }
-    }
-    AudioBuffer input_buffer(input_wav_nch, buffer_size);
-    input_buffer = input_buffer_float;
-    AudioBuffer output_buffer(output_wav_nch, buffer_size);
-
-    // Process.
-    obr_obj.Process(input_buffer, &output_buffer);
-
-    for (size_t smp = 0; smp < output_buffer.num_frames(); smp++) {
-      for (size_t ch = 0; ch < output_buffer.num_channels(); ch++) {
-        output_buffer_float[ch][smp] = output_buffer[ch][smp];
-      }
-    }
-
-    // Convert float planar to int16_t interleaved.
-    for (size_t smp = 0; smp < buffer_size; smp++) {
-      for (size_t ch = 0; ch < output_wav_nch; ch++) {
-        output_buffer_int16[smp * output_wav_nch + ch] =
-            static_cast<int16_t>((output_buffer_float[ch][smp]) * 32768.0f);
-      }
-    }
+    // Process the int16_t interleaved samples directly.
+    obr_obj.Process(input_buffer_int16.data(), input_wav_nch,
+                    output_buffer_int16.data());
 
     // Write to the output file
     WriteWavSamples(output_file, output_buffer_int16.data(),
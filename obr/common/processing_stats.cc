@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/common/processing_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace obr {
+
+RollingStatsSummary RollingStats::Get() const {
+  RollingStatsSummary summary;
+#if !defined(OBR_DISABLE_STATS)
+  if (num_values_ == 0) {
+    return summary;
+  }
+  std::vector<float> values(values_.begin(), values_.begin() + num_values_);
+  const auto [min, max] = std::minmax_element(values.begin(), values.end());
+  summary.min = *min;
+  summary.max = *max;
+  double sum = 0.0;
+  for (const float value : values) {
+    sum += value;
+  }
+  summary.mean = static_cast<float>(sum / static_cast<double>(num_values_));
+
+  // Nearest rank percentile.
+  const size_t p99_index = static_cast<size_t>(
+      std::ceil(0.99 * static_cast<double>(num_values_)) - 1.0);
+  std::nth_element(values.begin(), values.begin() + p99_index, values.end());
+  summary.p99 = values[p99_index];
+  summary.num_values = num_values_;
+#endif
+  return summary;
+}
+
+void RollingStats::Reset() {
+#if !defined(OBR_DISABLE_STATS)
+  next_index_ = 0;
+  num_values_ = 0;
+#endif
+}
+
+}  // namespace obr
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#ifndef OBR_COMMON_PROCESSING_STATS_H_
+#define OBR_COMMON_PROCESSING_STATS_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+// The processing time instrumentation is compiled in by default. Defining
+// `OBR_DISABLE_STATS` for all translation units, e.g. with the CMake option of
+// the same name or `--copt=-DOBR_DISABLE_STATS` in Bazel, removes it. The
+// timers and rolling statistics below then compile to nothing.
+
+namespace obr {
+
+/*!\brief Summary of the values in a `RollingStats` window. All members are zero
+ * if the window is empty.
+ */
+struct RollingStatsSummary {
+  float min = 0.0f;
+  float mean = 0.0f;
+  float p99 = 0.0f;
+  float max = 0.0f;
+
+  // Number of values in the window.
+  size_t num_values = 0;
+};
+
+/*!\brief Measures the time of consecutive processing stages. Each lap
+ * accumulates the time since the previous lap, or since `Start()`, into the
+ * given counter.
+ */
+class StageTimer {
+ public:
+  /*!\brief Starts timing the first stage.
+   */
+  void Start() {
+#if !defined(OBR_DISABLE_STATS)
+    start_ = std::chrono::steady_clock::now();
+#endif
+  }
+
+  /*!\brief Ends the current stage and starts the next one.
+   *
+   * \param elapsed_us Counter to add the time of the current stage to, in
+   *        microseconds.
+   */
+  void Lap(float* elapsed_us) {
+#if !defined(OBR_DISABLE_STATS)
+    const std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    *elapsed_us +=
+        std::chrono::duration<float, std::micro>(now - start_).count();
+    start_ = now;
+#else
+    static_cast<void>(elapsed_us);
+#endif
+  }
+
+ private:
+#if !defined(OBR_DISABLE_STATS)
+  std::chrono::steady_clock::time_point start_;
+#endif
+};
+
+/*!\brief Minimum, mean, 99th percentile and maximum of the last
+ * `kRollingStatsWindowSize` values of a measurement, e.g. the processing time
+ * per block. Adding values neither allocates nor blocks, the summary is
+ * computed on demand.
+ */
+class RollingStats {
+ public:
+  static constexpr size_t kRollingStatsWindowSize = 1024;
+
+  /*!\brief Adds a value, replacing the oldest one once the window is full.
+   *
+   * \param value New value.
+   */
+  void Add(float value) {
+#if !defined(OBR_DISABLE_STATS)
+    values_[next_index_] = value;
+    next_index_ = (next_index_ + 1) % kRollingStatsWindowSize;
+    if (num_values_ < kRollingStatsWindowSize) {
+      ++num_values_;
+    }
+#else
+    static_cast<void>(value);
+#endif
+  }
+
+  /*!\brief Computes the summary of the values in the window.
+   *
+   * \return Summary of the window.
+   */
+  RollingStatsSummary Get() const;
+
+  /*!\brief Removes all values.
+   */
+  void Reset();
+
+ private:
+#if !defined(OBR_DISABLE_STATS)
+  std::array<float, kRollingStatsWindowSize> values_ = {};
+  size_t next_index_ = 0;
+  size_t num_values_ = 0;
+#endif
+};
+
+}  // namespace obr
+
+#endif  // OBR_COMMON_PROCESSING_STATS_H_
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/common/processing_stats.h"
+
+#include <cstddef>
+
+#include "gtest/gtest.h"
+
+namespace obr {
+
+namespace {
+
+class ProcessingStatsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+#if defined(OBR_DISABLE_STATS)
+    GTEST_SKIP() << "Processing statistics are disabled.";
+#endif
+  }
+};
+
+// Tests the summary of a partially filled window.
+TEST_F(ProcessingStatsTest, SummaryTest) {
+  RollingStats stats;
+  RollingStatsSummary summary = stats.Get();
+  EXPECT_EQ(summary.num_values, 0U);
+  EXPECT_EQ(summary.max, 0.0f);
+
+  // Values 1 to 200 in shuffled order.
+  for (size_t i = 0; i < 200; ++i) {
+    stats.Add(static_cast<float>((i * 7) % 200 + 1));
+  }
+  summary = stats.Get();
+  EXPECT_EQ(summary.num_values, 200U);
+  EXPECT_FLOAT_EQ(summary.min, 1.0f);
+  EXPECT_FLOAT_EQ(summary.mean, 100.5f);
+  EXPECT_FLOAT_EQ(summary.p99, 198.0f);
+  EXPECT_FLOAT_EQ(summary.max, 200.0f);
+
+  stats.Reset();
+  EXPECT_EQ(stats.Get().num_values, 0U);
+}
+
+// Tests that only the last `kRollingStatsWindowSize` values are summarized.
+TEST_F(ProcessingStatsTest, WindowTest) {
+  RollingStats stats;
+  for (size_t i = 0; i < RollingStats::kRollingStatsWindowSize; ++i) {
+    stats.Add(1000.0f);
+  }
+  for (size_t i = 0; i < RollingStats::kRollingStatsWindowSize; ++i) {
+    stats.Add(2.0f);
+  }
+  const RollingStatsSummary summary = stats.Get();
+  EXPECT_EQ(summary.num_values, RollingStats::kRollingStatsWindowSize);
+  EXPECT_FLOAT_EQ(summary.min, 2.0f);
+  EXPECT_FLOAT_EQ(summary.mean, 2.0f);
+  EXPECT_FLOAT_EQ(summary.max, 2.0f);
+}
+
+// Tests that the timer accumulates the time of consecutive stages.
+TEST_F(ProcessingStatsTest, StageTimerTest) {
+  StageTimer timer;
+  float first_stage_us = 0.0f;
+  float second_stage_us = 0.0f;
+  timer.Start();
+  volatile float sum = 0.0f;
+  for (int i = 0; i < 100000; ++i) {
+    sum = sum + 1.0f;
+  }
+  timer.Lap(&first_stage_us);
+  timer.Lap(&second_stage_us);
+  EXPECT_GT(first_stage_us, 0.0f);
+  EXPECT_GE(second_stage_us, 0.0f);
+
+  const float previous_first_stage_us = first_stage_us;
+  timer.Lap(&first_stage_us);
+  EXPECT_GE(first_stage_us, previous_first_stage_us);
+}
+
+}  // namespace
+
+}  // namespace obr
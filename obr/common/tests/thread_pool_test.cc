@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/common/thread_pool.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace obr {
+
+namespace {
+
+// Tests that every task runs exactly once per call, over many consecutive calls
+// and for different numbers of tasks and worker threads.
+TEST(ThreadPoolTest, RunsEachTaskOnce) {
+  const size_t kNumCalls = 200;
+  const std::vector<size_t> kNumWorkerThreads = {0, 1, 3};
+  const std::vector<size_t> kNumTasks = {0, 1, 2, 4, 17};
+
+  for (const size_t num_worker_threads : kNumWorkerThreads) {
+    ThreadPool thread_pool(num_worker_threads);
+    EXPECT_EQ(thread_pool.GetNumWorkerThreads(), num_worker_threads);
+    for (const size_t num_tasks : kNumTasks) {
+      std::vector<int> counts(num_tasks, 0);
+      for (size_t call = 0; call < kNumCalls; ++call) {
+        thread_pool.ParallelFor(num_tasks, [&](size_t task) { ++counts[task]; });
+      }
+      for (const int count : counts) {
+        EXPECT_EQ(count, static_cast<int>(kNumCalls));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+}  // namespace obr
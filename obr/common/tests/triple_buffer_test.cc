@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/common/triple_buffer.h"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace obr {
+
+namespace {
+
+// Value with redundant fields to detect torn reads.
+struct TestValue {
+  int counter = 0;
+  int negated_counter = 0;
+};
+
+// Tests that only the latest value is picked up and only once.
+TEST(TripleBufferTest, PicksUpLatestValue) {
+  TripleBuffer<int> triple_buffer;
+  EXPECT_FALSE(triple_buffer.Update());
+  EXPECT_EQ(triple_buffer.Get(), 0);
+
+  triple_buffer.Write(1);
+  EXPECT_TRUE(triple_buffer.Update());
+  EXPECT_EQ(triple_buffer.Get(), 1);
+  EXPECT_FALSE(triple_buffer.Update());
+  EXPECT_EQ(triple_buffer.Get(), 1);
+
+  triple_buffer.Write(2);
+  triple_buffer.Write(3);
+  triple_buffer.Write(4);
+  EXPECT_TRUE(triple_buffer.Update());
+  EXPECT_EQ(triple_buffer.Get(), 4);
+  EXPECT_FALSE(triple_buffer.Update());
+}
+
+// Tests that a reader running concurrently with a writer sees complete values
+// in the order they were written.
+TEST(TripleBufferTest, ConcurrentWriterAndReader) {
+  const int kNumValues = 100000;
+  TripleBuffer<TestValue> triple_buffer;
+  std::thread writer([&triple_buffer]() {
+    for (int i = 1; i <= kNumValues; ++i) {
+      triple_buffer.Write({i, -i});
+    }
+  });
+
+  int last_counter = 0;
+  while (last_counter < kNumValues) {
+    if (!triple_buffer.Update()) {
+      continue;
+    }
+    const TestValue& value = triple_buffer.Get();
+    ASSERT_EQ(value.negated_counter, -value.counter);
+    ASSERT_GT(value.counter, last_counter);
+    last_counter = value.counter;
+  }
+  writer.join();
+}
+
+}  // namespace
+
+}  // namespace obr
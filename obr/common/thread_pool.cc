@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#include "obr/common/thread_pool.h"
+
+#include <cstddef>
+#include <thread>
+
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+
+namespace obr {
+
+ThreadPool::ThreadPool(size_t num_worker_threads)
+    : generation_(0),
+      num_busy_workers_(0),
+      stop_(false),
+      task_(nullptr),
+      num_tasks_(0),
+      next_task_(0) {
+  worker_threads_.reserve(num_worker_threads);
+  for (size_t i = 0; i < num_worker_threads; ++i) {
+    worker_threads_.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stop_ = true;
+    work_available_.SignalAll();
+  }
+  for (auto& thread : worker_threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t num_tasks,
+                             absl::FunctionRef<void(size_t)> task) {
+  if (worker_threads_.empty() || num_tasks <= 1) {
+    for (size_t i = 0; i < num_tasks; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    task_ = &task;
+    num_tasks_ = num_tasks;
+    next_task_.store(0, std::memory_order_relaxed);
+    num_busy_workers_ = worker_threads_.size();
+    ++generation_;
+    work_available_.SignalAll();
+  }
+
+  RunTasks();
+
+  // Wait until every worker thread has left `RunTasks()`, so none of them can
+  // touch `task_` after returning.
+  absl::MutexLock lock(&mutex_);
+  while (num_busy_workers_ > 0) {
+    worker_done_.Wait(&mutex_);
+  }
+  task_ = nullptr;
+}
+
+void ThreadPool::RunTasks() {
+  for (size_t i = next_task_.fetch_add(1, std::memory_order_relaxed);
+       i < num_tasks_; i = next_task_.fetch_add(1, std::memory_order_relaxed)) {
+    (*task_)(i);
+  }
+}
+
+void ThreadPool::WorkerLoop() {
+  uint64_t last_generation = 0;
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      while (!stop_ && generation_ == last_generation) {
+        work_available_.Wait(&mutex_);
+      }
+      if (stop_) {
+        return;
+      }
+      last_generation = generation_;
+    }
+
+    RunTasks();
+
+    absl::MutexLock lock(&mutex_);
+    --num_busy_workers_;
+    if (num_busy_workers_ == 0) {
+      worker_done_.Signal();
+    }
+  }
+}
+
+}  // namespace obr
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#ifndef OBR_COMMON_THREAD_POOL_H_
+#define OBR_COMMON_THREAD_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+
+namespace obr {
+
+/*!\brief Persistent pool of worker threads running blocking parallel loops.
+ *
+ * The worker threads are created once and wait for work between calls, so no
+ * threads are created or destroyed while processing audio. The calling thread
+ * takes part in running the tasks.
+ */
+class ThreadPool {
+ public:
+  /*!\brief Constructor starts the worker threads.
+   *
+   * \param num_worker_threads Number of worker threads in addition to the
+   *        calling thread.
+   */
+  explicit ThreadPool(size_t num_worker_threads);
+
+  /*!\brief Destructor stops and joins the worker threads.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /*!\brief Runs `task(i)` for every `i` in `[0, num_tasks)` and returns once
+   * all tasks are done. Tasks are picked up by the worker threads and the
+   * calling thread in no particular order, so they must be independent.
+   *
+   * \param num_tasks Number of tasks.
+   * \param task Function to run for each task index.
+   */
+  void ParallelFor(size_t num_tasks, absl::FunctionRef<void(size_t)> task);
+
+  /*!\brief Returns the number of worker threads.
+   *
+   * \return Number of worker threads, not counting the calling thread.
+   */
+  size_t GetNumWorkerThreads() const { return worker_threads_.size(); }
+
+ private:
+  /*!\brief Main loop of each worker thread.
+   */
+  void WorkerLoop();
+
+  /*!\brief Claims and runs tasks of the current `ParallelFor` call until none
+   * are left.
+   */
+  void RunTasks();
+
+  absl::Mutex mutex_;
+
+  // Signaled when a new `ParallelFor` call starts or the pool is stopped.
+  absl::CondVar work_available_;
+
+  // Signaled when a worker thread finishes its share of a `ParallelFor` call.
+  absl::CondVar worker_done_;
+
+  // Incremented with each `ParallelFor` call to wake up the worker threads.
+  uint64_t generation_ ABSL_GUARDED_BY(mutex_);
+
+  // Number of worker threads still running tasks of the current call.
+  size_t num_busy_workers_ ABSL_GUARDED_BY(mutex_);
+
+  // True when the worker threads should exit.
+  bool stop_ ABSL_GUARDED_BY(mutex_);
+
+  // Task and number of tasks of the current call. Written before waking up
+  // the worker threads and constant while they run.
+  const absl::FunctionRef<void(size_t)>* task_;
+  size_t num_tasks_;
+
+  // Index of the next task to be claimed.
+  std::atomic<size_t> next_task_;
+
+  std::vector<std::thread> worker_threads_;
+};
+
+}  // namespace obr
+
+#endif  // OBR_COMMON_THREAD_POOL_H_
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+#ifndef OBR_COMMON_TRIPLE_BUFFER_H_
+#define OBR_COMMON_TRIPLE_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace obr {
+
+/*!\brief Wait-free exchange of the latest value of a parameter between one
+ * writer thread and one reader thread, e.g. a control thread and the audio
+ * thread.
+ *
+ * The value is held in three slots. The writer fills its back slot and swaps
+ * it with the middle slot, the reader swaps its front slot with the middle
+ * slot if it holds a newer value. Neither side ever waits for the other, and
+ * the reader always sees a complete value. Intermediate values are dropped if
+ * the writer is faster than the reader. Multiple writers must be serialized
+ * by the caller.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() : middle_(kInitialMiddle), back_(kInitialBack), front_(0) {}
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  /*!\brief Publishes a new value. Must only be called by the writer thread.
+   *
+   * \param value New value.
+   */
+  void Write(const T& value) {
+    slots_[back_] = value;
+    const uint8_t previous_middle = middle_.exchange(
+        static_cast<uint8_t>(back_ | kNewValueFlag), std::memory_order_acq_rel);
+    back_ = static_cast<uint8_t>(previous_middle & kIndexMask);
+  }
+
+  /*!\brief Picks up the latest published value, if any. Must only be called by
+   * the reader thread.
+   *
+   * \return True if a new value was picked up since the last call.
+   */
+  bool Update() {
+    if ((middle_.load(std::memory_order_relaxed) & kNewValueFlag) == 0) {
+      return false;
+    }
+    const uint8_t previous_middle =
+        middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = static_cast<uint8_t>(previous_middle & kIndexMask);
+    return true;
+  }
+
+  /*!\brief Returns the value picked up by the last call of `Update()`, or a
+   * default constructed value before the first one. Must only be called by the
+   * reader thread.
+   *
+   * \return Current value.
+   */
+  const T& Get() const { return slots_[front_]; }
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kNewValueFlag = 0x4;
+  static constexpr uint8_t kInitialMiddle = 1;
+  static constexpr uint8_t kInitialBack = 2;
+
+  T slots_[3] = {};
+
+  // Index of the middle slot, with `kNewValueFlag` set while it holds a value
+  // which the reader has not picked up yet.
+  std::atomic<uint8_t> middle_;
+
+  // Slot index owned by the writer thread.
+  uint8_t back_;
+
+  // Slot index owned by the reader thread.
+  uint8_t front_;
+};
+
+}  // namespace obr
+
+#endif  // OBR_COMMON_TRIPLE_BUFFER_H_
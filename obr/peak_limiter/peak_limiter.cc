@@ -10,10 +10,10 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
-#include <cstdlib>
-#include <vector>
+#include <cstdint>
 
 #include "absl/log/check.h"
+#include "obr/ambisonic_binaural_decoder/sample_type_conversion.h"
 #include "obr/audio_buffer/audio_buffer.h"
 
 namespace obr {
@@ -24,45 +24,89 @@ PeakLimiter::PeakLimiter(const int sampling_rate, const double release_ms,
       ceiling_(std::pow(10, ceiling_db / 20)),
       release_time_constant_(
           std::exp(-3 / (sampling_rate_ * release_ms / 1000))),
-      env_(1.0) {}
+      env_(1.0),
+      num_limited_frames_(0),
+      num_limited_buffers_(0) {}
 
 void PeakLimiter::Process(const AudioBuffer& input, AudioBuffer* output) {
   CHECK_EQ(input.num_channels(), output->num_channels());
   CHECK_EQ(input.num_frames(), output->num_frames());
   const size_t num_channels = input.num_channels();
   const size_t num_frames = input.num_frames();
+  const size_t previous_num_limited_frames = num_limited_frames_;
 
-  // Get a vector of maximum sample values across all channels.
-  std::vector<float> max_samples(num_frames, 0.0);
-  for (const auto& channel : input) {
-    for (size_t frame = 0; frame < num_frames; ++frame) {
-      max_samples[frame] = std::max(max_samples[frame], abs(channel[frame]));
+  // The envelope only depends on the current frame, so the limiter runs in a
+  // single pass over the frames without any scratch memory.
+  for (size_t frame = 0; frame < num_frames; ++frame) {
+    // Get the maximum sample value across all channels.
+    float max_sample = 0.0f;
+    for (size_t channel = 0; channel < num_channels; ++channel) {
+      max_sample = std::max(max_sample, std::abs(input[channel][frame]));
+    }
+
+    // Apply the limiter envelope.
+    const float gain = UpdateEnvelope(max_sample);
+    for (size_t channel = 0; channel < num_channels; ++channel) {
+      (*output)[channel][frame] = input[channel][frame] * gain;
     }
   }
+  num_limited_buffers_ += num_limited_frames_ != previous_num_limited_frames;
+}
+
+void PeakLimiter::Process(const AudioBuffer& input, float* interleaved_output) {
+  ProcessInterleaved(input, interleaved_output);
+}
+
+void PeakLimiter::Process(const AudioBuffer& input,
+                          int16_t* interleaved_output) {
+  ProcessInterleaved(input, interleaved_output);
+}
+
+template <typename SampleType>
+void PeakLimiter::ProcessInterleaved(const AudioBuffer& input,
+                                     SampleType* interleaved_output) {
+  CHECK_NE(interleaved_output, nullptr);
+  const size_t num_channels = input.num_channels();
+  const size_t num_frames = input.num_frames();
+  const size_t previous_num_limited_frames = num_limited_frames_;
 
-  // Get the limiter envelope.
-  std::vector<float> limiter_env(num_frames, 0.0);
+  // The envelope is a recursion over the frames, so limiting, sample format
+  // conversion and interleaving are done frame by frame in a single pass.
   for (size_t frame = 0; frame < num_frames; ++frame) {
-    double max_req_gain = GetMaximumRequiredGain(max_samples[frame]);
-    if (max_req_gain < env_) {
-      env_ = max_req_gain;
-    } else {
-      env_ = release_time_constant_ * (env_ - max_req_gain) + max_req_gain;
+    float max_sample = 0.0f;
+    for (size_t channel = 0; channel < num_channels; ++channel) {
+      max_sample = std::max(max_sample, std::abs(input[channel][frame]));
     }
-    limiter_env[frame] = static_cast<float>(env_);
-  }
 
-  // Apply the limiter envelope to the input buffer.
-  for (size_t channel = 0; channel < num_channels; ++channel) {
-    for (size_t frame = 0; frame < num_frames; ++frame) {
-      (*output)[channel][frame] = input[channel][frame] * limiter_env[frame];
+    const float gain = UpdateEnvelope(max_sample);
+    for (size_t channel = 0; channel < num_channels; ++channel) {
+      ConvertSampleFromFloatFormat(input[channel][frame] * gain,
+                                   interleaved_output++);
     }
   }
+  num_limited_buffers_ += num_limited_frames_ != previous_num_limited_frames;
+}
+
+void PeakLimiter::ResetCounters() {
+  num_limited_frames_ = 0;
+  num_limited_buffers_ = 0;
+}
+
+float PeakLimiter::UpdateEnvelope(float max_sample) {
+  const double max_req_gain = GetMaximumRequiredGain(max_sample);
+  if (max_req_gain < env_) {
+    env_ = max_req_gain;
+  } else {
+    env_ = release_time_constant_ * (env_ - max_req_gain) + max_req_gain;
+  }
+  const float gain = static_cast<float>(env_);
+  num_limited_frames_ += gain < 1.0f;
+  return gain;
 }
 
 double PeakLimiter::GetMaximumRequiredGain(double sample) const {
-  if (abs(sample) > ceiling_) {
-    return ceiling_ / abs(sample);
+  if (std::abs(sample) > ceiling_) {
+    return ceiling_ / std::abs(sample);
   } else {
     return 1;
   }
@@ -9,6 +9,9 @@
 #ifndef OBR_PEAK_LIMITER_H_
 #define OBR_PEAK_LIMITER_H_
 
+#include <cstddef>
+#include <cstdint>
+
 #include "obr/audio_buffer/audio_buffer.h"
 
 namespace obr {
@@ -33,11 +36,49 @@ class PeakLimiter {
    */
   void Process(const AudioBuffer& input, AudioBuffer* output);
 
+  /*!\brief Applies peak limiting to the input audio buffer and writes the
+   * result as interleaved float samples in the same pass.
+   *
+   * \param input Input audio buffer.
+   * \param interleaved_output Output of `input.num_frames()` interleaved frames
+   *     of `input.num_channels()` channels.
+   */
+  void Process(const AudioBuffer& input, float* interleaved_output);
+
+  /*!\brief Applies peak limiting to the input audio buffer and writes the
+   * result as interleaved int16_t samples in the same pass.
+   *
+   * \param input Input audio buffer.
+   * \param interleaved_output Output of `input.num_frames()` interleaved frames
+   *     of `input.num_channels()` channels.
+   */
+  void Process(const AudioBuffer& input, int16_t* interleaved_output);
+
+  /*!\brief Returns the number of frames processed so far with a gain below
+   * one.
+   *
+   * \return Number of limited frames.
+   */
+  size_t GetNumLimitedFrames() const { return num_limited_frames_; }
+
+  /*!\brief Returns the number of buffers processed so far in which at least
+   * one frame was limited.
+   *
+   * \return Number of limited buffers.
+   */
+  size_t GetNumLimitedBuffers() const { return num_limited_buffers_; }
+
+  /*!\brief Resets the counts of limited frames and buffers to zero.
+   */
+  void ResetCounters();
+
  private:
   const int sampling_rate_;
   const double ceiling_;
   const double release_time_constant_;
   double env_;
+  size_t num_limited_frames_;
+  size_t num_limited_buffers_;
 
   /*!\brief Returns the maximum gain required to limit the peak.
    *
@@ -45,6 +86,22 @@ class PeakLimiter {
    * \return Maximum gain required to limit the peak.
    */
   double GetMaximumRequiredGain(double sample) const;
+
+  /*!\brief Updates the limiter envelope with the peak of one frame.
+   *
+   * \param max_sample Maximum absolute sample value of the frame.
+   * \return Gain to apply to the frame.
+   */
+  float UpdateEnvelope(float max_sample);
+
+  /*!\brief Applies peak limiting and writes interleaved samples.
+   *
+   * \param input Input audio buffer.
+   * \param interleaved_output Interleaved output samples.
+   */
+  template <typename SampleType>
+  void ProcessInterleaved(const AudioBuffer& input,
+                          SampleType* interleaved_output);
 };
 
 }  // namespace obr
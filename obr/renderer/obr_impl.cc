@@ -8,26 +8,41 @@
 
 #include "obr/renderer/obr_impl.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <iomanip>
 #include <ios>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <system_error>
 #include <utility>
 #include <vector>
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "obr/ambisonic_binaural_decoder/ambisonic_binaural_decoder.h"
+#include "obr/ambisonic_binaural_decoder/binaural_filters/binaural_filters_wrapper.h"
+#include "obr/ambisonic_binaural_decoder/kernel_cache.h"
+#include "obr/ambisonic_binaural_decoder/kernel_registry.h"
+#include "obr/ambisonic_binaural_decoder/planar_interleaved_conversion.h"
 #include "obr/ambisonic_binaural_decoder/sh_hrir_creator.h"
 #include "obr/ambisonic_encoder/ambisonic_encoder.h"
 #include "obr/ambisonic_rotator/ambisonic_rotator.h"
 #include "obr/audio_buffer/audio_buffer.h"
+#include "obr/audio_buffer/simd_utils.h"
 #include "obr/common/constants.h"
 #include "obr/common/misc_math.h"
+#include "obr/common/processing_stats.h"
+#include "obr/common/triple_buffer.h"
 #include "obr/peak_limiter/peak_limiter.h"
 #include "obr/renderer/audio_element_config.h"
 #include "obr/renderer/audio_element_type.h"
@@ -42,40 +57,66 @@ namespace {
     if (!_status.ok()) return _status;    \
   } while (0)
 
+// Maximum per sample difference between the left ear SH-HRIRs and the mirrored
+// right ear SH-HRIRs for decoding with symmetric SH-HRIRs.
+const float kShHrirSymmetryTolerance = 1e-4f;
+
+// Copies `num_frames` frames of all channels from `source`, starting at
+// `source_offset`, to `destination`, starting at `destination_offset`.
+void CopyFrames(const AudioBuffer& source, size_t source_offset,
+                size_t num_frames, size_t destination_offset,
+                AudioBuffer* destination) {
+  DCHECK_EQ(source.num_channels(), destination->num_channels());
+  DCHECK_LE(source_offset + num_frames, source.num_frames());
+  DCHECK_LE(destination_offset + num_frames, destination->num_frames());
+  for (size_t channel = 0; channel < source.num_channels(); ++channel) {
+    std::copy_n(source[channel].begin() + source_offset, num_frames,
+                (*destination)[channel].begin() + destination_offset);
+  }
+}
+
 }  // namespace
 
+ObrImpl::BinauralStage::BinauralStage(size_t frames_per_buffer, int order)
+    : order(order),
+      fft_manager(frames_per_buffer),
+      ambisonic_rotator(std::make_unique<AmbisonicRotator>(order)) {}
+
+ObrImpl::DspGraph::DspGraph(size_t frames_per_buffer)
+    : num_input_channels(0),
+      ambisonic_pass_through(false),
+      crossfade_output(kNumBinauralChannels, frames_per_buffer),
+      has_processed(false) {}
+
 ObrImpl::ObrImpl(int buffer_size_per_channel, int sampling_rate)
     : buffer_size_per_channel_(buffer_size_per_channel),
       sampling_rate_(sampling_rate),
       head_tracking_enabled_(false),
-      world_rotation_(WorldRotation()),
-      fft_manager_(buffer_size_per_channel_) {
+      configuring_(false),
+      committed_binaural_stage_outdated_(false),
+      crossfade_(false),
+      finished_dsp_(nullptr),
+      binaural_stage_outdated_(false),
+      fifo_engaged_(false),
+      num_fifo_input_frames_(0),
+      fifo_output_block_(kNumBinauralChannels, buffer_size_per_channel_),
+      external_output_block_(kNumBinauralChannels, buffer_size_per_channel_),
+      external_output_view_(kNumBinauralChannels, 0),
+      num_blocks_(0),
+      num_limited_blocks_(0),
+      num_limited_frames_(0),
+      num_pending_blocks_(0),
+      stats_reset_requested_(false),
+      resetting_stats_(false) {
   CHECK_GT(buffer_size_per_channel_, 0);
   CHECK_GT(sampling_rate_, 0);
-}
-
-ObrImpl::~ObrImpl() = default;
 
-absl::Status ObrImpl::ResetDsp() {
-  LOG(INFO) << "Resetting DSP.";
-
-  // Enable the lock.
-  absl::MutexLock lock(&mutex_);
-
-  // Release resources.
-  ambisonic_binaural_decoder_.reset();
-  sh_hrirs_L_.reset();
-  sh_hrirs_R_.reset();
-  ambisonic_encoder_.reset();
-  peak_limiter_.reset();
-  ambisonic_rotator_.reset();
-
-  // Clear buffers.
-  ambisonic_mix_bed_.Clear();
-
-  return absl::OkStatus();
+  // The peak limiter is kept across DSP graph switches.
+  peak_limiter_ = std::make_unique<PeakLimiter>(sampling_rate_, 50, -0.5);
 }
 
+ObrImpl::~ObrImpl() { CollectFinishedDspGraph(); }
+
 absl::Status ObrImpl::InitializeDsp() {
   // Check that the audio elements list is not empty.
   if (audio_elements_.empty()) {
@@ -84,10 +125,15 @@ absl::Status ObrImpl::InitializeDsp() {
   }
 
   // Analyze the list of requested audio elements and initialize the necessary
-  // DSP.
-  // For now, until rendering of multiple AEs is implemented, initialize DSP
-  // using Ambisonic order of the first (and only) element.
-  const size_t order = audio_elements_[0].GetBinauralFiltersAmbisonicOrder();
+  // DSP. All elements are rendered through a single Ambisonic mix bed of the
+  // highest order required by any of them. Lower order Ambisonic elements are
+  // summed into the leading ACN channels of the bed.
+  size_t order = 0;
+  for (const auto& audio_element : audio_elements_) {
+    order = std::max(
+        order,
+        static_cast<size_t>(audio_element.GetBinauralFiltersAmbisonicOrder()));
+  }
   const size_t number_of_input_channels = GetNumberOfInputChannels();
 
   CHECK_NE(order, 0);
@@ -99,105 +145,656 @@ absl::Status ObrImpl::InitializeDsp() {
         "No input channels configured. Can't initialize DSP.");
   }
 
-  // Reset the DSP.
-  RETURN_IF_NOT_OK(ResetDsp());
-
-  // Enable the lock.
-  absl::MutexLock lock(&mutex_);
+  // The new graph is built without holding `mutex_`, so that the audio thread
+  // keeps processing the current graph meanwhile.
+  auto dsp = std::make_unique<DspGraph>(buffer_size_per_channel_);
+  dsp->num_input_channels = number_of_input_channels;
 
   // Setup Ambisonic mix bed.
-  ambisonic_mix_bed_ =
+  dsp->ambisonic_mix_bed =
       AudioBuffer((order + 1) * (order + 1), buffer_size_per_channel_);
+  dsp->fifo_input_block =
+      AudioBuffer(number_of_input_channels, buffer_size_per_channel_);
+  dsp->fifo_input_block.Clear();
+  dsp->external_input_block =
+      AudioBuffer(number_of_input_channels, buffer_size_per_channel_);
+  // Reserves the channels for wrapping the external input without allocating.
+  dsp->external_input_view = AudioBuffer(number_of_input_channels, 0);
+  dsp->external_input_ptrs.resize(number_of_input_channels);
+  for (const auto& audio_element : audio_elements_) {
+    if (IsAmbisonicsType(audio_element.GetType())) {
+      dsp->ambisonic_channel_ranges.emplace_back(
+          audio_element.GetFirstChannelIndex(),
+          audio_element.GetNumberOfInputChannels());
+    }
+  }
+  dsp->ambisonic_pass_through =
+      audio_elements_.size() == 1 && !dsp->ambisonic_channel_ranges.empty();
 
   LOG(INFO) << "Initializing DSP:";
   LOG(INFO) << "  - Number of input channels: " << number_of_input_channels;
   LOG(INFO) << "  - Binaural filters Ambisonic order: " << order;
   LOG(INFO) << "  - Number of Ambisonic mix bed channels: "
-            << ambisonic_mix_bed_.num_channels();
+            << dsp->ambisonic_mix_bed.num_channels();
 
   // Initialize Ambisonic encoder.
-  auto indices = GetAmbisonicEncoderSourceChannelIndices();
-  if (!indices.empty()) {
-    ambisonic_encoder_input_buffer_ =
-        AudioBuffer(indices.size(), buffer_size_per_channel_);
-    ambisonic_encoder_ =
-        std::make_unique<AmbisonicEncoder>(indices.size(), order);
+  dsp->encoder_source_channel_indices =
+      GetAmbisonicEncoderSourceChannelIndices();
+  const size_t num_sources = dsp->encoder_source_channel_indices.size();
+  if (num_sources > 0) {
+    dsp->ambisonic_encoder =
+        std::make_unique<AmbisonicEncoder>(num_sources, order);
+    const std::vector<SourcePosition> source_positions =
+        GetAmbisonicEncoderSourcePositions();
+    CHECK_EQ(source_positions.size(), num_sources);
+    for (size_t i = 0; i < num_sources; ++i) {
+      dsp->ambisonic_encoder->SetSource(i, 1.0f, source_positions[i].azimuth,
+                                        source_positions[i].elevation,
+                                        source_positions[i].distance);
+    }
+  }
+
+  // Initialize HOA rotator and Ambisonic binaural decoder, unless the ones of
+  // the current graph can be continued.
+  if (binaural_stage_ == nullptr ||
+      binaural_stage_->order != static_cast<int>(order) ||
+      binaural_stage_outdated_) {
+    auto binaural_stage = std::make_shared<BinauralStage>(
+        buffer_size_per_channel_, static_cast<int>(order));
+    RETURN_IF_NOT_OK(InitializeBinauralDecoder(binaural_stage.get()));
+    binaural_stage_ = std::move(binaural_stage);
+    binaural_stage_outdated_ = false;
+  } else {
+    LOG(INFO) << "  - Reusing binaural decoder";
+  }
+  dsp->binaural_stage = binaural_stage_;
+
+  {
+    absl::MutexLock lock(&kernel_pruning_stats_mutex_);
+    kernel_pruning_stats_ =
+        binaural_stage_->ambisonic_binaural_decoder->GetKernelPruningStats();
+  }
+  PublishDspGraph(std::move(dsp));
+
+  // Replace source positions published for the previous graph.
+  if (num_sources > 0) {
     RETURN_IF_NOT_OK(UpdateAmbisonicEncoder());
   }
 
-  // Initialize HOA rotator.
-  ambisonic_rotator_ = std::make_unique<AmbisonicRotator>(order);
+  return absl::OkStatus();
+}
 
-  // Initialize Ambisonic binaural decoder.
-  // Load filters matching the selected operational Ambisonic order.
-  std::string order_string = std::to_string(order);
-  sh_hrirs_L_ = CreateShHrirsFromAssets(order_string + "OA_L", sampling_rate_,
-                                        &resampler_);
-  sh_hrirs_R_ = CreateShHrirsFromAssets(order_string + "OA_R", sampling_rate_,
-                                        &resampler_);
+void ObrImpl::PublishDspGraph(std::unique_ptr<DspGraph> dsp) {
+  CollectFinishedDspGraph();
+  std::unique_ptr<DspGraph> unused_dsps[3];
+  {
+    absl::MutexLock lock(&mutex_);
+    unused_dsps[0] = std::move(pending_dsp_);
+    unused_dsps[1] = std::move(retired_dsp_);
+    if (!crossfade_) {
+      unused_dsps[2] = std::move(previous_dsp_);
+    }
+    pending_dsp_ = std::move(dsp);
+  }
+  // The unused graphs are destroyed here, outside of the lock.
+}
 
-  CHECK_EQ(sh_hrirs_L_->num_channels(), sh_hrirs_R_->num_channels());
-  CHECK_EQ(sh_hrirs_L_->num_frames(), sh_hrirs_R_->num_frames());
+void ObrImpl::SwitchDspGraph() {
+  if (pending_dsp_ == nullptr) {
+    return;
+  }
+  if (previous_dsp_ != nullptr) {
+    // Finish fading out the previous graph first. Only one graph can be
+    // switched per publication, so `retired_dsp_` is free.
+    if (crossfade_) {
+      return;
+    }
+    DCHECK(retired_dsp_ == nullptr);
+    retired_dsp_ = std::move(previous_dsp_);
+  }
+  previous_dsp_ = std::move(dsp_);
+  dsp_ = std::move(pending_dsp_);
+  // Graphs sharing the binaural stage continue seamlessly. The stage must not
+  // be processed twice per block anyway.
+  crossfade_ = previous_dsp_ != nullptr && previous_dsp_->has_processed &&
+               previous_dsp_->binaural_stage != dsp_->binaural_stage;
+
+  // Keep the frames buffered so far. Audio elements are added and removed at
+  // the end, so the channels of the remaining elements are in the same place.
+  if (previous_dsp_ != nullptr &&
+      fifo_engaged_.load(std::memory_order_relaxed)) {
+    const AudioBuffer& previous_block = previous_dsp_->fifo_input_block;
+    AudioBuffer& block = dsp_->fifo_input_block;
+    for (size_t channel = 0; channel < std::min(previous_block.num_channels(),
+                                                block.num_channels());
+         ++channel) {
+      std::copy_n(previous_block[channel].begin(), num_fifo_input_frames_,
+                  block[channel].begin());
+    }
+  }
+  if (!crossfade_) {
+    FinishPreviousDspGraph();
+  }
+}
 
-  ambisonic_binaural_decoder_ = std::make_unique<AmbisonicBinauralDecoder>(
-      *sh_hrirs_L_, *sh_hrirs_R_, buffer_size_per_channel_, &fft_manager_);
+void ObrImpl::FinishPreviousDspGraph() {
+  if (previous_dsp_ == nullptr) {
+    return;
+  }
+  DspGraph* expected = nullptr;
+  if (finished_dsp_.compare_exchange_strong(expected, previous_dsp_.get(),
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    previous_dsp_.release();
+  }
+}
 
-  // Initialize peak limiter.
-  peak_limiter_ = std::make_unique<PeakLimiter>(sampling_rate_, 50, -0.5);
+void ObrImpl::CollectFinishedDspGraph() {
+  // Destroyed here, on the calling thread.
+  std::unique_ptr<DspGraph> finished_dsp(
+      finished_dsp_.exchange(nullptr, std::memory_order_acquire));
+}
 
+absl::Status ObrImpl::InitializeBinauralDecoder(
+    BinauralStage* binaural_stage) {
+  const int order = binaural_stage->order;
+  // The plain uniformly partitioned mode only needs the frequency domain
+  // SH-HRIRs, which are shared by all renderers with the same configuration.
+  // The other modes need the time domain filters.
+  if (binaural_decoder_options_.convolution_mode ==
+          ConvolutionMode::kUniformPartitioned &&
+      !binaural_decoder_options_.symmetric_sh_hrirs &&
+      !binaural_decoder_options_.prune_kernels &&
+      !binaural_decoder_options_.shared_late_tail) {
+    FftManager* fft_manager = &binaural_stage->fft_manager;
+    absl::StatusOr<std::shared_ptr<const ShHrirKernelSet>> kernel_set =
+        KernelRegistry::GetInstance().GetOrCreate(
+            order, sampling_rate_, buffer_size_per_channel_,
+            [this, order, fft_manager]() {
+              return CreateShHrirKernelSet(order, fft_manager);
+            });
+    RETURN_IF_NOT_OK(kernel_set.status());
+    binaural_stage->ambisonic_binaural_decoder =
+        std::make_unique<AmbisonicBinauralDecoder>(
+            std::shared_ptr<const PartitionedFreqDomainKernels>(
+                *kernel_set, &(*kernel_set)->kernels_L),
+            std::shared_ptr<const PartitionedFreqDomainKernels>(
+                *kernel_set, &(*kernel_set)->kernels_R),
+            buffer_size_per_channel_, fft_manager, binaural_decoder_options_);
+    return absl::OkStatus();
+  }
+
+  // Load filters matching the selected operational Ambisonic order.
+  std::string order_string = std::to_string(order);
+  const std::unique_ptr<AudioBuffer> sh_hrirs_L = CreateShHrirsFromAssets(
+      order_string + "OA_L", sampling_rate_, &resampler_);
+  const std::unique_ptr<AudioBuffer> sh_hrirs_R = CreateShHrirsFromAssets(
+      order_string + "OA_R", sampling_rate_, &resampler_);
+
+  CHECK_EQ(sh_hrirs_L->num_channels(), sh_hrirs_R->num_channels());
+  CHECK_EQ(sh_hrirs_L->num_frames(), sh_hrirs_R->num_frames());
+
+  // Only decode with a single SH-HRIR set if the filters really describe a
+  // symmetric head.
+  AmbisonicBinauralDecoderOptions decoder_options = binaural_decoder_options_;
+  if (decoder_options.symmetric_sh_hrirs &&
+      !AreShHrirsSymmetric(*sh_hrirs_L, *sh_hrirs_R,
+                           kShHrirSymmetryTolerance)) {
+    LOG(WARNING) << "SH-HRIRs for order " << order
+                 << " are not symmetric. Decoding both ears separately.";
+    decoder_options.symmetric_sh_hrirs = false;
+  }
+
+  binaural_stage->ambisonic_binaural_decoder =
+      std::make_unique<AmbisonicBinauralDecoder>(
+          *sh_hrirs_L, *sh_hrirs_R, buffer_size_per_channel_,
+          &binaural_stage->fft_manager, decoder_options);
   return absl::OkStatus();
 }
 
+absl::StatusOr<ShHrirKernelSet> ObrImpl::CreateShHrirKernelSet(
+    int order, FftManager* fft_manager) {
+  std::string order_string = std::to_string(order);
+  const std::string asset_names[kNumBinauralChannels] = {order_string + "OA_L",
+                                                         order_string + "OA_R"};
+  ShHrirKernelSet kernel_set;
+  PartitionedFreqDomainKernels* kernels[kNumBinauralChannels] = {
+      &kernel_set.kernels_L, &kernel_set.kernels_R};
+
+  std::shared_ptr<const KernelCache> kernel_cache;
+  {
+    absl::MutexLock lock(&kernel_cache_mutex_);
+    kernel_cache = kernel_cache_;
+  }
+  KernelCacheKey cache_keys[kNumBinauralChannels];
+  if (kernel_cache != nullptr) {
+    BinauralFiltersWrapper hrtf_assets;
+    bool all_cached = true;
+    for (size_t ear = 0; ear < kNumBinauralChannels; ++ear) {
+      const std::unique_ptr<std::string> asset =
+          hrtf_assets.GetFile(asset_names[ear]);
+      if (asset == nullptr) {
+        return absl::NotFoundError(
+            absl::StrCat("Could not find asset: ", asset_names[ear]));
+      }
+      cache_keys[ear].ambisonic_order = order;
+      cache_keys[ear].ear = ear;
+      cache_keys[ear].sampling_rate = sampling_rate_;
+      cache_keys[ear].frames_per_buffer = buffer_size_per_channel_;
+      cache_keys[ear].asset_hash = ComputeKernelAssetHash(*asset);
+      if (!all_cached) {
+        continue;
+      }
+      absl::StatusOr<PartitionedFreqDomainKernels> cached_kernels =
+          kernel_cache->Load(cache_keys[ear], fft_manager->GetFftSize());
+      if (cached_kernels.ok()) {
+        *kernels[ear] = *std::move(cached_kernels);
+      } else {
+        all_cached = false;
+        if (!absl::IsNotFound(cached_kernels.status())) {
+          LOG(WARNING) << "Ignoring kernel cache entry: "
+                       << cached_kernels.status();
+        }
+      }
+    }
+    if (all_cached) {
+      LOG(INFO) << "  - Binaural filters loaded from kernel cache.";
+      return kernel_set;
+    }
+  }
+
+  for (size_t ear = 0; ear < kNumBinauralChannels; ++ear) {
+    const std::unique_ptr<AudioBuffer> sh_hrirs =
+        CreateShHrirsFromAssets(asset_names[ear], sampling_rate_, &resampler_);
+    *kernels[ear] = ComputePartitionedFreqDomainKernels(
+        *sh_hrirs, buffer_size_per_channel_, fft_manager);
+  }
+  CHECK_EQ(kernel_set.kernels_L.size(), kernel_set.kernels_R.size());
+
+  // A failure to store the kernels only costs the next session some time.
+  if (kernel_cache != nullptr) {
+    for (size_t ear = 0; ear < kNumBinauralChannels; ++ear) {
+      const absl::Status status =
+          kernel_cache->Store(cache_keys[ear], *kernels[ear]);
+      if (!status.ok()) {
+        LOG(WARNING) << "Could not store kernel cache entry: " << status;
+      }
+    }
+  }
+  return kernel_set;
+}
+
 void ObrImpl::Process(const AudioBuffer& input_buffer,
                       AudioBuffer* output_buffer) {
-  CHECK_EQ(input_buffer.num_channels(), GetNumberOfInputChannels());
   CHECK_EQ(input_buffer.num_frames(), buffer_size_per_channel_);
   CHECK_NE(output_buffer, nullptr);
   CHECK_EQ(output_buffer->num_channels(), GetNumberOfOutputChannels());
   CHECK_EQ(output_buffer->num_frames(), buffer_size_per_channel_);
 
+  // Goes through the re-buffering only if it is engaged.
+  Process(input_buffer, input_buffer.num_frames(), output_buffer);
+}
+
+void ObrImpl::Process(const AudioBuffer& input_buffer, size_t num_frames,
+                      AudioBuffer* output_buffer) {
+  CHECK_LE(num_frames, input_buffer.num_frames());
+  CHECK_NE(output_buffer, nullptr);
+  CHECK_EQ(output_buffer->num_channels(), GetNumberOfOutputChannels());
+  CHECK_LE(num_frames, output_buffer->num_frames());
+  if (num_frames == 0) {
+    return;
+  }
+
+  // Enable the lock.
+  absl::MutexLock lock(&mutex_);
+
+  // The input layout is checked against the graph in use, which may lag
+  // behind the audio element configuration until this point.
+  SwitchDspGraph();
+  CHECK(dsp_ != nullptr) << "No audio elements configured.";
+  CHECK_EQ(input_buffer.num_channels(), dsp_->num_input_channels);
+
+  UpdateParameters();
+
+  ProcessFrames(input_buffer, num_frames, output_buffer);
+}
+
+void ObrImpl::Process(const int16_t* interleaved_input,
+                      size_t num_input_channels, int16_t* interleaved_output) {
+  ProcessInterleaved(interleaved_input, num_input_channels,
+                     interleaved_output);
+}
+
+void ObrImpl::Process(const float* interleaved_input,
+                      size_t num_input_channels, float* interleaved_output) {
+  ProcessInterleaved(interleaved_input, num_input_channels,
+                     interleaved_output);
+}
+
+template <typename SampleType>
+void ObrImpl::ProcessInterleaved(const SampleType* interleaved_input,
+                                 size_t num_input_channels,
+                                 SampleType* interleaved_output) {
+  CHECK_NE(interleaved_input, nullptr);
+  CHECK_NE(interleaved_output, nullptr);
+
   // Enable the lock.
   absl::MutexLock lock(&mutex_);
 
+  SwitchDspGraph();
+  CHECK(dsp_ != nullptr) << "No audio elements configured.";
+  CHECK_EQ(num_input_channels, dsp_->num_input_channels);
+
+  UpdateParameters();
+
+  const size_t block_size = static_cast<size_t>(buffer_size_per_channel_);
+  AudioBuffer& input_block = dsp_->external_input_block;
+  FillAudioBuffer(interleaved_input, block_size, num_input_channels,
+                  &input_block);
+  if (!fifo_engaged_.load(std::memory_order_relaxed)) {
+    // The peak limiter writes the interleaved output.
+    RenderBlock(input_block, &external_output_block_);
+    StageTimer timer;
+    timer.Start();
+    peak_limiter_->Process(external_output_block_, interleaved_output);
+    timer.Lap(&block_timings_.peak_limiter_us);
+    RecordBlockStats();
+    return;
+  }
+  // A planar partial block was processed before, keep re-buffering.
+  ProcessFrames(input_block, block_size, &external_output_block_);
+  FillExternalBuffer(external_output_block_, interleaved_output, block_size,
+                     kNumBinauralChannels);
+}
+
+void ObrImpl::Process(const float* const* input_channels,
+                      float* const* output_channels, size_t num_frames) {
+  CHECK_NE(input_channels, nullptr);
+  CHECK_NE(output_channels, nullptr);
+  if (num_frames == 0) {
+    return;
+  }
+
+  // Enable the lock.
+  absl::MutexLock lock(&mutex_);
+
+  SwitchDspGraph();
+  CHECK(dsp_ != nullptr) << "No audio elements configured.";
+
+  UpdateParameters();
+
+  // Whole blocks are processed without re-buffering, only a trailing partial
+  // block engages it.
+  const size_t num_input_channels = dsp_->num_input_channels;
+  const size_t block_size = static_cast<size_t>(buffer_size_per_channel_);
+  AudioBuffer& input_block = dsp_->external_input_block;
+  AudioBuffer& input_view = dsp_->external_input_view;
+  std::vector<float*>& input_ptrs = dsp_->external_input_ptrs;
+  std::array<float*, kNumBinauralChannels> output_ptrs;
+  for (size_t frame = 0; frame < num_frames; frame += block_size) {
+    const size_t num_block_frames = std::min(block_size, num_frames - frame);
+    for (size_t channel = 0; channel < num_input_channels; ++channel) {
+      // The input view is only read from.
+      input_ptrs[channel] = const_cast<float*>(input_channels[channel]) + frame;
+    }
+    for (size_t channel = 0; channel < kNumBinauralChannels; ++channel) {
+      output_ptrs[channel] = output_channels[channel] + frame;
+    }
+    if (AudioBuffer::CanWrap(input_ptrs.data(), num_input_channels) &&
+        AudioBuffer::CanWrap(output_ptrs.data(), kNumBinauralChannels)) {
+      input_view.Wrap(input_ptrs.data(), num_input_channels,
+                      num_block_frames);
+      external_output_view_.Wrap(output_ptrs.data(), kNumBinauralChannels,
+                                 num_block_frames);
+      ProcessFrames(input_view, num_block_frames, &external_output_view_);
+      continue;
+    }
+
+    // Unaligned channels are copied.
+    for (size_t channel = 0; channel < num_input_channels; ++channel) {
+      std::copy_n(input_channels[channel] + frame, num_block_frames,
+                  input_block[channel].begin());
+    }
+    ProcessFrames(input_block, num_block_frames, &external_output_block_);
+    for (size_t channel = 0; channel < kNumBinauralChannels; ++channel) {
+      std::copy_n(external_output_block_[channel].begin(), num_block_frames,
+                  output_channels[channel] + frame);
+    }
+  }
+}
+
+void ObrImpl::ProcessFrames(const AudioBuffer& input_buffer, size_t num_frames,
+                            AudioBuffer* output_buffer) {
+  AudioBuffer& fifo_input_block = dsp_->fifo_input_block;
+  const size_t block_size = static_cast<size_t>(buffer_size_per_channel_);
+  const bool fifo_engaged = fifo_engaged_.load(std::memory_order_relaxed);
+  if (!fifo_engaged && num_frames == block_size) {
+    if (input_buffer.num_frames() == block_size &&
+        output_buffer->num_frames() == block_size) {
+      ProcessBlock(input_buffer, output_buffer);
+      return;
+    }
+    CopyFrames(input_buffer, 0, block_size, 0, &fifo_input_block);
+    ProcessBlock(fifo_input_block, &fifo_output_block_);
+    CopyFrames(fifo_output_block_, 0, block_size, 0, output_buffer);
+    return;
+  }
+
+  if (!fifo_engaged) {
+    // Output `block_size - 1` frames of silence while the first block is
+    // buffered.
+    fifo_engaged_.store(true, std::memory_order_relaxed);
+    num_fifo_input_frames_ = 0;
+    fifo_output_block_.Clear();
+  }
+  for (size_t frame = 0; frame < num_frames;) {
+    const size_t num_block_frames =
+        std::min(block_size - num_fifo_input_frames_, num_frames - frame);
+    CopyFrames(input_buffer, frame, num_block_frames, num_fifo_input_frames_,
+               &fifo_input_block);
+    const size_t output_offset = num_fifo_input_frames_ + 1;
+    num_fifo_input_frames_ += num_block_frames;
+    if (num_fifo_input_frames_ < block_size) {
+      CopyFrames(fifo_output_block_, output_offset, num_block_frames, frame,
+                 output_buffer);
+    } else {
+      // The previous block lacks one frame, which is the first frame of the
+      // output of the completed block.
+      CopyFrames(fifo_output_block_, output_offset, num_block_frames - 1,
+                 frame, output_buffer);
+      ProcessBlock(fifo_input_block, &fifo_output_block_);
+      CopyFrames(fifo_output_block_, 0, 1, frame + num_block_frames - 1,
+                 output_buffer);
+      num_fifo_input_frames_ = 0;
+    }
+    frame += num_block_frames;
+  }
+}
+
+void ObrImpl::ProcessBlock(const AudioBuffer& input_buffer,
+                           AudioBuffer* output_buffer) {
+  RenderBlock(input_buffer, output_buffer);
+
+  // Peak limit the output.
+  StageTimer timer;
+  timer.Start();
+  peak_limiter_->Process(*output_buffer, output_buffer);
+  timer.Lap(&block_timings_.peak_limiter_us);
+  RecordBlockStats();
+}
+
+void ObrImpl::RenderBlock(const AudioBuffer& input_buffer,
+                          AudioBuffer* output_buffer) {
+  // The statistics after a `ResetStats()` request start with this block.
+  if (stats_reset_requested_.load(std::memory_order_relaxed)) {
+    num_pending_blocks_ = 0;
+    peak_limiter_->ResetCounters();
+    resetting_stats_ = true;
+  }
+  block_timings_ = BlockTimings();
+  block_timer_.Start();
+  ProcessDspGraph(input_buffer, dsp_.get(), output_buffer);
+
+  if (crossfade_) {
+    // Fade linearly from the output of the previous graph, which still holds
+    // the reverberant tail of the earlier blocks, to the output of the new
+    // graph.
+    AudioBuffer& previous_output = previous_dsp_->crossfade_output;
+    ProcessDspGraph(input_buffer, previous_dsp_.get(), &previous_output);
+    const float gain_step = 1.0f / static_cast<float>(buffer_size_per_channel_);
+    for (size_t channel = 0; channel < output_buffer->num_channels();
+         ++channel) {
+      auto& output_channel = (*output_buffer)[channel];
+      const auto& previous_channel = previous_output[channel];
+      for (size_t frame = 0; frame < output_channel.size(); ++frame) {
+        const float gain = gain_step * static_cast<float>(frame + 1);
+        output_channel[frame] =
+            previous_channel[frame] +
+            gain * (output_channel[frame] - previous_channel[frame]);
+      }
+    }
+    crossfade_ = false;
+    FinishPreviousDspGraph();
+  }
+}
+
+void ObrImpl::ProcessDspGraph(const AudioBuffer& input_buffer, DspGraph* dsp,
+                              AudioBuffer* output_buffer) {
+  dsp->has_processed = true;
+
+  const bool head_tracking_enabled =
+      head_tracking_enabled_.load(std::memory_order_relaxed);
+  BinauralStage* binaural_stage = dsp->binaural_stage.get();
+  AudioBuffer& ambisonic_mix_bed = dsp->ambisonic_mix_bed;
+  StageTimer timer;
+  timer.Start();
+
+  // A single Ambisonic element which fills the mix bed is rotated from the
+  // input straight into the bed, or decoded directly without head tracking.
+  // The rotator needs contiguous input, which views of external data lack.
+  if (dsp->ambisonic_pass_through &&
+      input_buffer.num_channels() == ambisonic_mix_bed.num_channels() &&
+      !(head_tracking_enabled && input_buffer.IsView())) {
+    const AudioBuffer* decoder_input = &input_buffer;
+    if (head_tracking_enabled &&
+        binaural_stage->ambisonic_rotator->Process(
+            world_rotation_.Get(), input_buffer, &ambisonic_mix_bed)) {
+      decoder_input = &ambisonic_mix_bed;
+    }
+    timer.Lap(&block_timings_.rotator_us);
+    DecodeBlock(*decoder_input, binaural_stage, &timer, output_buffer);
+    return;
+  }
+
   // Pass audio through Ambisonic Encoder and render to Ambisonic
   // mix bed.
-  const auto indices = GetAmbisonicEncoderSourceChannelIndices();
+  const std::vector<size_t>& indices = dsp->encoder_source_channel_indices;
 
   if (!indices.empty()) {
-    // Create a copy of the input buffer with selected channels only.
-    for (size_t i = 0; i < indices.size(); ++i) {
-      ambisonic_encoder_input_buffer_[i] = input_buffer[indices[i]];
-    }
-
-    ambisonic_encoder_->ProcessPlanarAudioData(ambisonic_encoder_input_buffer_,
-                                               &ambisonic_mix_bed_);
+    // The encoder reads the selected channels from the input buffer directly.
+    // Silent mix bed channels are disabled, so that the rotator and decoder
+    // can skip them.
+    dsp->ambisonic_encoder->ProcessActivePlanarAudioData(
+        input_buffer, indices, &ambisonic_mix_bed);
   } else {
-    ambisonic_mix_bed_.Clear();
+    for (size_t channel = 0; channel < ambisonic_mix_bed.num_channels();
+         ++channel) {
+      ambisonic_mix_bed[channel].SetEnabled(false);
+    }
   }
+  timer.Lap(&block_timings_.encoder_us);
 
   // Copy Ambisonic input channels to Ambisonic mix bed.
-  for (const auto& audio_element : audio_elements_) {
-    if (IsAmbisonicsType(audio_element.GetType())) {
-      for (size_t channel = 0;
-           channel < audio_element.GetNumberOfInputChannels(); ++channel) {
-        ambisonic_mix_bed_[channel] +=
-            input_buffer[audio_element.GetFirstChannelIndex() + channel];
+  for (const auto& channel_range : dsp->ambisonic_channel_ranges) {
+    for (size_t channel = 0; channel < channel_range.second; ++channel) {
+      const size_t input_channel_index = channel_range.first + channel;
+      if (input_channel_index >= input_buffer.num_channels()) {
+        break;
+      }
+      const auto& input_channel = input_buffer[input_channel_index];
+      if (!input_channel.IsEnabled() ||
+          IsBelowThreshold(input_buffer.num_frames(), kNegative120dbInAmplitude,
+                           input_channel.begin())) {
+        continue;
+      }
+      auto& mix_bed_channel = ambisonic_mix_bed[channel];
+      if (mix_bed_channel.IsEnabled()) {
+        mix_bed_channel += input_channel;
+      } else {
+        mix_bed_channel.SetEnabled(true);
+        mix_bed_channel = input_channel;
       }
     }
   }
+  timer.Lap(&block_timings_.ambisonic_mix_us);
 
-  if (head_tracking_enabled_) {
+  if (head_tracking_enabled) {
     // Pass Ambisonic mix bed through Ambisonic Rotator.
-    ambisonic_rotator_->Process(world_rotation_, ambisonic_mix_bed_,
-                                &ambisonic_mix_bed_);
+    binaural_stage->ambisonic_rotator->Process(
+        world_rotation_.Get(), ambisonic_mix_bed, &ambisonic_mix_bed);
   }
+  timer.Lap(&block_timings_.rotator_us);
 
   // Pass Ambisonic mix bed through Ambisonic Binaural Decoder.
-  ambisonic_binaural_decoder_->ProcessAudioBuffer(ambisonic_mix_bed_,
-                                                  output_buffer);
+  DecodeBlock(ambisonic_mix_bed, binaural_stage, &timer, output_buffer);
+}
 
-  // Peak limit the output.
-  peak_limiter_->Process(*output_buffer, output_buffer);
+void ObrImpl::DecodeBlock(const AudioBuffer& input_buffer,
+                          BinauralStage* binaural_stage, StageTimer* timer,
+                          AudioBuffer* output_buffer) {
+  AmbisonicBinauralDecoder* decoder =
+      binaural_stage->ambisonic_binaural_decoder.get();
+  decoder->ProcessAudioBuffer(input_buffer, output_buffer);
+  timer->Lap(&block_timings_.binaural_decoder_us);
+
+  // Accumulated, as both graphs are decoded during a crossfade.
+  const DecoderStageTimings& stage_timings = decoder->GetStageTimings();
+  block_timings_.forward_fft_us += stage_timings.forward_fft_us;
+  block_timings_.multiply_accumulate_us += stage_timings.multiply_accumulate_us;
+  block_timings_.inverse_fft_us += stage_timings.inverse_fft_us;
+}
+
+void ObrImpl::RecordBlockStats() {
+  block_timer_.Lap(&block_timings_.total_us);
+  if (num_pending_blocks_ < kMaxNumPendingBlocks) {
+    pending_block_timings_[num_pending_blocks_] = block_timings_;
+  }
+  ++num_pending_blocks_;
+  if (!stats_mutex_.TryLock()) {
+    return;
+  }
+  if (resetting_stats_) {
+    stage_stats_.encoder.Reset();
+    stage_stats_.ambisonic_mix.Reset();
+    stage_stats_.rotator.Reset();
+    stage_stats_.binaural_decoder.Reset();
+    stage_stats_.forward_fft.Reset();
+    stage_stats_.multiply_accumulate.Reset();
+    stage_stats_.inverse_fft.Reset();
+    stage_stats_.peak_limiter.Reset();
+    stage_stats_.total.Reset();
+    num_blocks_ = 0;
+    stats_reset_requested_.store(false, std::memory_order_relaxed);
+    resetting_stats_ = false;
+  }
+  for (size_t block = 0;
+       block < std::min(num_pending_blocks_, kMaxNumPendingBlocks); ++block) {
+    const BlockTimings& timings = pending_block_timings_[block];
+    stage_stats_.encoder.Add(timings.encoder_us);
+    stage_stats_.ambisonic_mix.Add(timings.ambisonic_mix_us);
+    stage_stats_.rotator.Add(timings.rotator_us);
+    stage_stats_.binaural_decoder.Add(timings.binaural_decoder_us);
+    stage_stats_.forward_fft.Add(timings.forward_fft_us);
+    stage_stats_.multiply_accumulate.Add(timings.multiply_accumulate_us);
+    stage_stats_.inverse_fft.Add(timings.inverse_fft_us);
+    stage_stats_.peak_limiter.Add(timings.peak_limiter_us);
+    stage_stats_.total.Add(timings.total_us);
+  }
+  num_blocks_ += num_pending_blocks_;
+  num_pending_blocks_ = 0;
+  num_limited_blocks_ = peak_limiter_->GetNumLimitedBuffers();
+  num_limited_frames_ = peak_limiter_->GetNumLimitedFrames();
+  stats_mutex_.Unlock();
 }
 
 int ObrImpl::GetBufferSizePerChannel() const {
@@ -206,8 +803,65 @@ int ObrImpl::GetBufferSizePerChannel() const {
 
 int ObrImpl::GetSamplingRate() const { return sampling_rate_; }
 
+int ObrImpl::GetLatencyInFrames() const {
+  return fifo_engaged_.load(std::memory_order_relaxed)
+             ? buffer_size_per_channel_ - 1
+             : 0;
+}
+
+absl::Status ObrImpl::SetKernelCacheDirectory(const std::string& directory) {
+  std::shared_ptr<const KernelCache> kernel_cache;
+  if (!directory.empty()) {
+    std::error_code error;
+    if (!std::filesystem::is_directory(directory, error)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Kernel cache directory does not exist: ", directory));
+    }
+    kernel_cache = std::make_shared<const KernelCache>(directory);
+  }
+  absl::MutexLock lock(&kernel_cache_mutex_);
+  kernel_cache_ = std::move(kernel_cache);
+  return absl::OkStatus();
+}
+
+KernelPruningStats ObrImpl::GetKernelPruningStats() const {
+  absl::MutexLock lock(&kernel_pruning_stats_mutex_);
+  return kernel_pruning_stats_;
+}
+
 size_t ObrImpl::GetNumberOfOutputChannels() { return kNumBinauralChannels; }
 
+ObrStats ObrImpl::GetStats() const {
+  ObrStats stats;
+  // Nothing has been collected since the pending reset.
+  if (stats_reset_requested_.load(std::memory_order_relaxed)) {
+    return stats;
+  }
+  // The windows are large, so the copy is kept off the stack.
+  std::unique_ptr<const StageStats> stage_stats;
+  {
+    absl::MutexLock lock(&stats_mutex_);
+    stage_stats = std::make_unique<const StageStats>(stage_stats_);
+    stats.num_blocks = num_blocks_;
+    stats.num_limited_blocks = num_limited_blocks_;
+    stats.num_limited_frames = num_limited_frames_;
+  }
+  stats.encoder = stage_stats->encoder.Get();
+  stats.ambisonic_mix = stage_stats->ambisonic_mix.Get();
+  stats.rotator = stage_stats->rotator.Get();
+  stats.binaural_decoder = stage_stats->binaural_decoder.Get();
+  stats.forward_fft = stage_stats->forward_fft.Get();
+  stats.multiply_accumulate = stage_stats->multiply_accumulate.Get();
+  stats.inverse_fft = stage_stats->inverse_fft.Get();
+  stats.peak_limiter = stage_stats->peak_limiter.Get();
+  stats.total = stage_stats->total.Get();
+  return stats;
+}
+
+void ObrImpl::ResetStats() {
+  stats_reset_requested_.store(true, std::memory_order_relaxed);
+}
+
 std::vector<size_t> ObrImpl::GetAmbisonicEncoderSourceChannelIndices() {
   std::vector<size_t> source_channel_indices;
   for (const auto& audio_element : audio_elements_) {
@@ -222,33 +876,57 @@ std::vector<size_t> ObrImpl::GetAmbisonicEncoderSourceChannelIndices() {
   return source_channel_indices;
 }
 
-absl::Status ObrImpl::UpdateAmbisonicEncoder() {
-  // Check if Ambisonic Encoder is initialized, so it can be called.
-  if (ambisonic_encoder_ != nullptr) {
-    // Iterate over audio elements to look for loudspeaker channels/objects
-    // which need to be encoded to Ambisonics. Update Ambisonic encoder
-    // settings.
-    size_t ambisonic_encoder_input_channel_index = 0;
-    for (auto audio_element : audio_elements_) {
-      // Iterate over loudspeaker channels.
-      for (const auto& source : audio_element.GetLoudspeakerChannels()) {
-        ambisonic_encoder_->SetSource(
-            static_cast<int>(ambisonic_encoder_input_channel_index), 1.0f,
-            source.GetAzimuth(), source.GetElevation(), source.GetDistance());
-        ambisonic_encoder_input_channel_index++;
-      }
+std::vector<ObrImpl::SourcePosition>
+ObrImpl::GetAmbisonicEncoderSourcePositions() {
+  // Iterate over audio elements to look for loudspeaker channels/objects which
+  // need to be encoded to Ambisonics.
+  std::vector<SourcePosition> source_positions;
+  for (auto& audio_element : audio_elements_) {
+    // Iterate over loudspeaker channels.
+    for (const auto& source : audio_element.GetLoudspeakerChannels()) {
+      source_positions.push_back(
+          {source.GetAzimuth(), source.GetElevation(), source.GetDistance()});
+    }
 
-      // Iterate over object input channels.
-      for (const auto& source : audio_element.GetObjectChannels()) {
-        ambisonic_encoder_->SetSource(
-            static_cast<int>(ambisonic_encoder_input_channel_index), 1.0f,
-            source.GetAzimuth(), source.GetElevation(), source.GetDistance());
-        ambisonic_encoder_input_channel_index++;
-      }
+    // Iterate over object input channels.
+    for (const auto& source : audio_element.GetObjectChannels()) {
+      source_positions.push_back(
+          {source.GetAzimuth(), source.GetElevation(), source.GetDistance()});
     }
-    return absl::OkStatus();
   }
-  return absl::FailedPreconditionError("Ambisonic encoder not initialized.");
+  return source_positions;
+}
+
+absl::Status ObrImpl::UpdateAmbisonicEncoder() {
+  // Check if an Ambisonic Encoder is initialized for the configuration.
+  if (GetAmbisonicEncoderSourceChannelIndices().empty()) {
+    return absl::FailedPreconditionError("Ambisonic encoder not initialized.");
+  }
+  CollectFinishedDspGraph();
+  absl::MutexLock lock(&parameter_mutex_);
+  source_positions_.Write(GetAmbisonicEncoderSourcePositions());
+  return absl::OkStatus();
+}
+
+void ObrImpl::UpdateParameters() {
+  world_rotation_.Update();
+
+  if (!source_positions_.Update() || dsp_->ambisonic_encoder == nullptr) {
+    return;
+  }
+  // Positions published before the last DSP initialization may belong to
+  // another channel layout. The initialization publishes the current ones.
+  const std::vector<SourcePosition>& source_positions =
+      source_positions_.Get();
+  if (source_positions.size() !=
+      dsp_->encoder_source_channel_indices.size()) {
+    return;
+  }
+  for (size_t i = 0; i < source_positions.size(); ++i) {
+    dsp_->ambisonic_encoder->SetSource(i, 1.0f, source_positions[i].azimuth,
+                                       source_positions[i].elevation,
+                                       source_positions[i].distance);
+  }
 }
 
 size_t ObrImpl::GetNumberOfInputChannels() {
@@ -262,17 +940,6 @@ size_t ObrImpl::GetNumberOfInputChannels() {
 size_t ObrImpl::GetNumberOfAudioElements() { return audio_elements_.size(); }
 
 absl::Status ObrImpl::AddAudioElement(const AudioElementType type) {
-  // Impose a restriction that all audio elements must be of the same type.
-  // This check will be removed in the future to allow for rendering of
-  // different types of audio elements at the same pass of the binaural
-  // Ambisonic decoder.
-  if (!audio_elements_.empty() && audio_elements_.back().GetType() != type) {
-    LOG(ERROR) << "Rendering only the same type of Audio Elements is supported."
-               << " Remove the existing Audio Element before adding a new one.";
-    return absl::FailedPreconditionError(
-        "Only same-typed audio elements are supported.");
-  }
-
   // Create an audio element configuration.
   auto audio_element_config = AudioElementConfig(type);
 
@@ -299,6 +966,9 @@ absl::Status ObrImpl::AddAudioElement(const AudioElementType type) {
   LOG(INFO) << "Added audio element: "
             << GetAudioElementTypeStr(audio_elements_.back().GetType()) << ".";
 
+  if (configuring_) {
+    return absl::OkStatus();
+  }
   RETURN_IF_NOT_OK(InitializeDsp());
 
   return absl::OkStatus();
@@ -319,10 +989,11 @@ absl::Status ObrImpl::RemoveLastAudioElement() {
     return absl::OkStatus();
   }
 
+  if (configuring_) {
+    return absl::OkStatus();
+  }
   RETURN_IF_NOT_OK(InitializeDsp());
 
-  RETURN_IF_NOT_OK(UpdateAmbisonicEncoder());
-
   return absl::OkStatus();
 }
 
@@ -350,21 +1021,86 @@ absl::Status ObrImpl::UpdateObjectPosition(size_t audio_element_index,
     object_ch.SetDistance(distance);
   }
 
+  // Staged positions are applied when the DSP is initialized on commit.
+  if (configuring_) {
+    return absl::OkStatus();
+  }
   RETURN_IF_NOT_OK(UpdateAmbisonicEncoder());
 
   return absl::OkStatus();
 }
 
+absl::Status ObrImpl::BeginConfiguration() {
+  if (configuring_) {
+    return absl::FailedPreconditionError("Configuration already started.");
+  }
+  configuring_ = true;
+  // The configs are not assignable, only copy constructible.
+  committed_audio_elements_ =
+      std::vector<AudioElementConfig>(audio_elements_);
+  committed_binaural_decoder_options_ = binaural_decoder_options_;
+  committed_binaural_stage_outdated_ = binaural_stage_outdated_;
+  return absl::OkStatus();
+}
+
+absl::Status ObrImpl::CommitConfiguration() {
+  if (!configuring_) {
+    return absl::FailedPreconditionError("No configuration started.");
+  }
+  configuring_ = false;
+
+  // Fails without audio elements, as there is nothing to render.
+  const BinauralStage* binaural_stage = binaural_stage_.get();
+  const absl::Status status = InitializeDsp();
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to commit configuration: " << status;
+    audio_elements_ = std::move(committed_audio_elements_);
+    binaural_decoder_options_ = committed_binaural_decoder_options_;
+    // A binaural stage built before the failure uses the discarded options.
+    binaural_stage_outdated_ = committed_binaural_stage_outdated_ ||
+                               binaural_stage_.get() != binaural_stage;
+  }
+  committed_audio_elements_.clear();
+  return status;
+}
+
+absl::Status ObrImpl::AbortConfiguration() {
+  if (!configuring_) {
+    return absl::FailedPreconditionError("No configuration started.");
+  }
+  configuring_ = false;
+  audio_elements_ = std::move(committed_audio_elements_);
+  committed_audio_elements_.clear();
+  binaural_decoder_options_ = committed_binaural_decoder_options_;
+  binaural_stage_outdated_ = committed_binaural_stage_outdated_;
+  return absl::OkStatus();
+}
+
 void ObrImpl::EnableHeadTracking(bool enable_head_tracking) {
-  head_tracking_enabled_ = enable_head_tracking;
+  CollectFinishedDspGraph();
+  head_tracking_enabled_.store(enable_head_tracking, std::memory_order_relaxed);
 }
 
 absl::Status ObrImpl::SetHeadRotation(float w, float x, float y, float z) {
-  world_rotation_ = WorldRotation(w, x, y, z);
+  CollectFinishedDspGraph();
+  absl::MutexLock lock(&parameter_mutex_);
+  world_rotation_.Write(WorldRotation(w, x, y, z));
 
   return absl::OkStatus();
 }
 
+absl::Status ObrImpl::SetBinauralDecoderOptions(
+    const AmbisonicBinauralDecoderOptions& options) {
+  binaural_decoder_options_ = options;
+  binaural_stage_outdated_ = true;
+
+  // The new options take effect with the next DSP initialization.
+  if (audio_elements_.empty() || configuring_) {
+    return absl::OkStatus();
+  }
+  return InitializeDsp();
+}
+
 std::string ObrImpl::GetAudioElementConfigLogMessage() {
   /*!\brief Returns a padded string with a number formatted to two decimal
    * places.
@@ -9,28 +9,72 @@
 #ifndef OBR_RENDERER_OBR_IMPL_H_
 #define OBR_RENDERER_OBR_IMPL_H_
 
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "obr/ambisonic_binaural_decoder/ambisonic_binaural_decoder.h"
 #include "obr/ambisonic_binaural_decoder/fft_manager.h"
+#include "obr/ambisonic_binaural_decoder/kernel_cache.h"
+#include "obr/ambisonic_binaural_decoder/kernel_registry.h"
 #include "obr/ambisonic_binaural_decoder/resampler.h"
 #include "obr/ambisonic_encoder/ambisonic_encoder.h"
 #include "obr/ambisonic_rotator/ambisonic_rotator.h"
 #include "obr/audio_buffer/audio_buffer.h"
 #include "obr/common/misc_math.h"
+#include "obr/common/processing_stats.h"
+#include "obr/common/triple_buffer.h"
 #include "obr/peak_limiter/peak_limiter.h"
 #include "obr/renderer/audio_element_config.h"
 #include "obr/renderer/audio_element_type.h"
 
 namespace obr {
 
+/*!\brief Processing statistics of the renderer, see `ObrImpl::GetStats()`.
+ * The times are in microseconds per block of `buffer_size_per_channel` frames,
+ * over the last `RollingStats::kRollingStatsWindowSize` blocks. They are zero
+ * if `OBR_DISABLE_STATS` is defined.
+ */
+struct ObrStats {
+  // Ambisonic encoding of the loudspeaker channels and objects.
+  RollingStatsSummary encoder;
+
+  // Mixing of the Ambisonic input channels into the mix bed.
+  RollingStatsSummary ambisonic_mix;
+
+  // Head rotation of the mix bed.
+  RollingStatsSummary rotator;
+
+  // Binaural decoding. In the default uniformly partitioned mode, it is split
+  // up further into the following three stages, see `DecoderStageTimings`.
+  RollingStatsSummary binaural_decoder;
+  RollingStatsSummary forward_fft;
+  RollingStatsSummary multiply_accumulate;
+  RollingStatsSummary inverse_fft;
+
+  // Peak limiting, including the conversion to interleaved output.
+  RollingStatsSummary peak_limiter;
+
+  // Whole block, including the crossfade after a DSP graph switch.
+  RollingStatsSummary total;
+
+  // Number of processed blocks, and the number of blocks and frames in which
+  // the peak limiter reduced the gain.
+  size_t num_blocks = 0;
+  size_t num_limited_blocks = 0;
+  size_t num_limited_frames = 0;
+};
+
 /*!\brief Implementation of the obr renderer.*/
 class ObrImpl {
  public:
@@ -52,6 +96,60 @@ class ObrImpl {
    */
   void Process(const AudioBuffer& input_buffer, AudioBuffer* output_buffer);
 
+  /*!\brief Processes the first `num_frames` frames of planar audio data, for
+   * hosts with variable block sizes. Any number of frames up to the size of
+   * the buffers is accepted and re-buffered internally into blocks of
+   * `buffer_size_per_channel` frames, see `GetLatencyInFrames()`. As long as
+   * no frames are buffered, blocks of exactly `buffer_size_per_channel` frames
+   * are processed directly.
+   *
+   * \param input_buffer Input buffer with planar audio data.
+   * \param num_frames Number of frames to process.
+   * \param output_buffer Output buffer with planar audio data.
+   */
+  void Process(const AudioBuffer& input_buffer, size_t num_frames,
+               AudioBuffer* output_buffer);
+
+  /*!\brief Processes one block of `buffer_size_per_channel` frames of
+   * interleaved int16_t audio data. The input is converted while it is
+   * deinterleaved, and the output is converted and interleaved by the peak
+   * limiter, without any intermediate copies.
+   *
+   * \param interleaved_input Interleaved input samples.
+   * \param num_input_channels Number of input channels, which must match
+   *     `GetNumberOfInputChannels()`.
+   * \param interleaved_output Interleaved stereo output samples.
+   */
+  void Process(const int16_t* interleaved_input, size_t num_input_channels,
+               int16_t* interleaved_output);
+
+  /*!\brief Processes one block of `buffer_size_per_channel` frames of
+   * interleaved float audio data, see the int16_t overload.
+   *
+   * \param interleaved_input Interleaved input samples.
+   * \param num_input_channels Number of input channels, which must match
+   *     `GetNumberOfInputChannels()`.
+   * \param interleaved_output Interleaved stereo output samples.
+   */
+  void Process(const float* interleaved_input, size_t num_input_channels,
+               float* interleaved_output);
+
+  /*!\brief Processes `num_frames` frames of planar audio data in external
+   * channel buffers, e.g. of a host mixing graph, with
+   * `GetNumberOfInputChannels()` input and `GetNumberOfOutputChannels()`
+   * output channels. The frames are processed in blocks of
+   * `buffer_size_per_channel` frames, a trailing partial block is re-buffered
+   * like in the `AudioBuffer` overload. Blocks of channels which are aligned
+   * for SIMD are processed in place, others are copied through internal
+   * buffers, see `AudioBuffer::CanWrap()`.
+   *
+   * \param input_channels Pointers to the input channels.
+   * \param output_channels Pointers to the output channels.
+   * \param num_frames Number of frames to process.
+   */
+  void Process(const float* const* input_channels,
+               float* const* output_channels, size_t num_frames);
+
   /*!\brief Returns the buffer size per channel.
    *
    * \return Buffer size per channel.
@@ -85,7 +183,11 @@ class ObrImpl {
   /*!\brief Adds an audio element to the renderer.
    * Creates an instance of AudioElementConfig, conducts all necessary checks,
    * populates with config data and updates renderer's DSP.
-   * This method should handle all necessary DSP resource allocations.
+   * Elements of different types can be combined. They are all encoded into one
+   * Ambisonic mix bed and rendered by a single binaural decoder.
+   * This method should handle all necessary DSP resource allocations. The new
+   * DSP is built on the calling thread without blocking `Process()`, which
+   * switches to it at the next block boundary, see `InitializeDsp()`.
    *
    * \param type Type of the audio element.
    * \param sub_type Subtype of the audio element.
@@ -94,13 +196,15 @@ class ObrImpl {
   absl::Status AddAudioElement(AudioElementType type);
 
   /*!\brief Removes the last added audio element from the renderer.
-   * This method should handle all necessary DSP resource deallocations.
+   * This method should handle all necessary DSP resource deallocations. Like
+   * `AddAudioElement()`, it does not block `Process()`.
    *
    * \return `absl::OkStatus()` if successful. A specific status on failure.
    */
   absl::Status RemoveLastAudioElement();
 
-  /*!\brief Sets the position of an audio object.
+  /*!\brief Sets the position of an audio object. The new position is picked
+   * up at the start of the next `Process()` call without blocking it.
    *
    * \param audio_element_index Index of the audio element containing the
    * object.
@@ -112,6 +216,33 @@ class ObrImpl {
   absl::Status UpdateObjectPosition(size_t audio_element_index, float azimuth,
                                     float elevation, float distance);
 
+  /*!\brief Starts a batch configuration of the renderer. Until
+   * `CommitConfiguration()` is called, `AddAudioElement()`,
+   * `RemoveLastAudioElement()`, `UpdateObjectPosition()` and
+   * `SetBinauralDecoderOptions()` only check and stage their changes. The
+   * DSP is initialized once on commit, which makes loading a scene of N
+   * audio elements a single initialization instead of N. `Process()` keeps
+   * rendering the last committed configuration meanwhile.
+   *
+   * \return `absl::OkStatus()` if successful. A specific status on failure.
+   */
+  absl::Status BeginConfiguration();
+
+  /*!\brief Applies the changes staged since `BeginConfiguration()` with one
+   * DSP initialization. If the initialization fails, or no audio elements are
+   * left, the configuration is rolled back to the state before
+   * `BeginConfiguration()`.
+   *
+   * \return `absl::OkStatus()` if successful. A specific status on failure.
+   */
+  absl::Status CommitConfiguration();
+
+  /*!\brief Discards the changes staged since `BeginConfiguration()`.
+   *
+   * \return `absl::OkStatus()` if successful. A specific status on failure.
+   */
+  absl::Status AbortConfiguration();
+
   /*! \brief Enables or disables head tracking.
    *
    * \param enable_head_tracking True to enable head tracking, false to disable.
@@ -121,7 +252,9 @@ class ObrImpl {
   /*!\brief Sets the head rotation.
    * The head rotation expressed using quaternions is used to counter-rotate the
    * intermediate Ambisonic bed in order to produce stable sound sources in
-   * binaural reproduction.
+   * binaural reproduction. The rotation is picked up at the start of the next
+   * `Process()` call. This method is wait-free for the audio thread and can be
+   * called at a high rate, e.g. from a sensor thread.
    * Use the following reference frame:
    * X - right
    * Y - up
@@ -135,6 +268,63 @@ class ObrImpl {
    */
   absl::Status SetHeadRotation(float w, float x, float y, float z);
 
+  /*!\brief Sets the options of the Ambisonic binaural decoder, e.g. to select
+   * the convolution engine. Reinitializes the DSP if audio elements are
+   * already configured.
+   *
+   * \param options Ambisonic binaural decoder options.
+   * \return `absl::OkStatus()` if successful. A specific status on failure.
+   */
+  absl::Status SetBinauralDecoderOptions(
+      const AmbisonicBinauralDecoderOptions& options);
+
+  /*!\brief Returns the latency which the renderer adds on top of the buffering
+   * of one `buffer_size_per_channel` block by the host. All convolution modes
+   * of the binaural decoder output the response to the current input block
+   * within the same block. Once a block of another size was processed, the
+   * internal re-buffering adds `buffer_size_per_channel - 1` frames.
+   *
+   * \return Latency in frames.
+   */
+  int GetLatencyInFrames() const;
+
+  /*!\brief Returns the convolution work saved by pruning the binaural decoder
+   * kernels, see `AmbisonicBinauralDecoderOptions::prune_kernels`.
+   *
+   * \return Kernel pruning statistics. All counts are zero if no audio
+   *         elements are configured.
+   */
+  KernelPruningStats GetKernelPruningStats() const;
+
+  /*!\brief Returns the processing statistics since construction or the last
+   * `ResetStats()` call. The statistics are copied under a lock which the audio
+   * thread only tries to take, and summarized outside of it, so `Process()`
+   * is never blocked. Blocks processed while the lock is held are counted
+   * from the next block on.
+   *
+   * \return Processing statistics.
+   */
+  ObrStats GetStats() const;
+
+  /*!\brief Discards the processing statistics collected so far, e.g. to
+   * exclude the first blocks after a reconfiguration. The audio thread clears
+   * them with the next block, until then `GetStats()` reports none.
+   */
+  void ResetStats();
+
+  /*!\brief Enables a persistent on-disk cache of the partitioned frequency
+   * domain binaural filters, keyed by Ambisonic order, ear, sampling rate,
+   * buffer size and asset hash. On a cache hit, loading, resampling and
+   * transforming the filters is skipped. The cache is only used in the
+   * default uniformly partitioned decoding mode. Takes effect the next time
+   * the DSP is initialized.
+   *
+   * \param directory Existing directory for the cache files. An empty string
+   *        disables the cache.
+   * \return `absl::OkStatus()` if successful. A specific status on failure.
+   */
+  absl::Status SetKernelCacheDirectory(const std::string& directory);
+
   /*!\brief Returns a log message with the list of audio elements in a form of
    * an ASCII table.
    *
@@ -143,50 +333,339 @@ class ObrImpl {
   std::string GetAudioElementConfigLogMessage();
 
  private:
-  /*!\brief Resets the renderer's DSP to the initial state.
-   *
-   * \return `absl::OkStatus()` if successful. A specific status on failure.
-   */
-  absl::Status ResetDsp();
+  // Rotator and binaural decoder of one Ambisonic order. Shared by
+  // consecutive DSP graphs as long as the order and the decoder options do not
+  // change, which keeps the decoder state and saves rebuilding the filters.
+  struct BinauralStage {
+    BinauralStage(size_t frames_per_buffer, int order);
+
+    const int order;
+    FftManager fft_manager;
+    std::unique_ptr<AmbisonicRotator> ambisonic_rotator;
+    std::unique_ptr<AmbisonicBinauralDecoder> ambisonic_binaural_decoder;
+  };
+
+  // DSP resources of one configuration of audio elements. A new graph is
+  // built on the control thread while the audio thread keeps processing the
+  // current one, and handed over at a block boundary.
+  struct DspGraph {
+    explicit DspGraph(size_t frames_per_buffer);
+
+    size_t num_input_channels;
+
+    // Input channels to be encoded to Ambisonics.
+    std::vector<size_t> encoder_source_channel_indices;
+
+    // First input channel and number of channels of the Ambisonic elements.
+    std::vector<std::pair<size_t, size_t>> ambisonic_channel_ranges;
+
+    // True if a single Ambisonic element fills the mix bed, so the input is
+    // rotated into the bed or decoded directly.
+    bool ambisonic_pass_through;
+
+    AudioBuffer ambisonic_mix_bed;
+    std::unique_ptr<AmbisonicEncoder> ambisonic_encoder;
+    std::shared_ptr<BinauralStage> binaural_stage;
+
+    // Re-buffered input block, see `fifo_output_block_`.
+    AudioBuffer fifo_input_block;
+
+    // Input block of the `Process()` overloads for external buffers, and a
+    // view of one block of the external input channels with its channel
+    // pointers.
+    AudioBuffer external_input_block, external_input_view;
+    std::vector<float*> external_input_ptrs;
+
+    // Output of the graph being faded out after a switch.
+    AudioBuffer crossfade_output;
+
+    // True once a block was processed, i.e. the output may have to be faded.
+    bool has_processed;
+  };
 
   /*!\brief Initializes the renderer's DSP.
-   * First, it resets the DSP, then analyzes the list of requested audio
-   * elements and initializes the necessary DSP resources.
+   * Analyzes the list of requested audio elements and builds a new DSP graph
+   * on the calling thread. The audio thread keeps processing the current
+   * graph meanwhile and switches to the new one at the start of the next
+   * `Process()` call, crossfading the outputs of both over one block. If the
+   * binaural filter order and the decoder options are unchanged, only the
+   * encoder and the channel maps are rebuilt, and the new graph continues
+   * with the binaural stage of the current one without a crossfade.
    *
    * \return `absl::OkStatus()` if successful. A specific status on failure.
    */
   absl::Status InitializeDsp();
 
+  /*!\brief Hands a new DSP graph over to the audio thread. Graphs which are
+   * no longer used by the audio thread are destroyed on the calling thread.
+   *
+   * \param dsp New DSP graph.
+   */
+  void PublishDspGraph(std::unique_ptr<DspGraph> dsp);
+
+  /*!\brief Switches to a published DSP graph. Must be called on the audio
+   * thread with `mutex_` held.
+   */
+  void SwitchDspGraph();
+
+  /*!\brief Hands `previous_dsp_` over to the control thread for destruction
+   * once it is no longer faded out, unless the previously finished graph has
+   * not been collected yet. Must be called on the audio thread with `mutex_`
+   * held.
+   */
+  void FinishPreviousDspGraph();
+
+  /*!\brief Destroys the graph handed over by `FinishPreviousDspGraph()`, if
+   * any. Called by the control methods, so that the graph is released without
+   * waiting for the next reconfiguration.
+   */
+  void CollectFinishedDspGraph();
+
   /*!\brief Gets a vector of channel indices for the Ambisonic encoder.
    *
    * \return Vector of input channel indices.
    */
   std::vector<size_t> GetAmbisonicEncoderSourceChannelIndices();
 
-  /*!\brief Updates the Ambisonic encoder.
+  // Position of a source of the Ambisonic encoder.
+  struct SourcePosition {
+    float azimuth;
+    float elevation;
+    float distance;
+  };
+
+  /*!\brief Gets the positions of the loudspeaker channels and objects to be
+   * encoded, in the order of the Ambisonic encoder input channels.
+   *
+   * \return Vector of source positions.
+   */
+  std::vector<SourcePosition> GetAmbisonicEncoderSourcePositions();
+
+  /*!\brief Publishes the current source positions to the Ambisonic encoder,
+   * which picks them up at the start of the next `Process()` call.
    *
    * \return `absl::OkStatus()` if successful. A specific status on failure.
    */
   absl::Status UpdateAmbisonicEncoder();
 
+  /*!\brief Picks up the latest head rotation and source positions. Must be
+   * called on the audio thread with `mutex_` held.
+   */
+  void UpdateParameters();
+
+  /*!\brief Creates the Ambisonic binaural decoder with the filters of the
+   * given order. In the default uniformly partitioned mode, the filters are
+   * shared with other renderers through the `KernelRegistry`.
+   *
+   * \param binaural_stage Binaural stage to create the decoder for.
+   * \return `absl::OkStatus()` if successful. A specific status on failure.
+   */
+  absl::Status InitializeBinauralDecoder(BinauralStage* binaural_stage);
+
+  /*!\brief Creates the partitioned frequency domain filters of the given
+   * order, from the kernel cache if possible.
+   *
+   * \param order Ambisonic order of the binaural filters.
+   * \param fft_manager FFT manager to transform the filters with.
+   * \return Filters of both ears. A specific status on failure.
+   */
+  absl::StatusOr<ShHrirKernelSet> CreateShHrirKernelSet(
+      int order, FftManager* fft_manager);
+
+  /*!\brief Processes interleaved audio data, see the public overloads.
+   *
+   * \param interleaved_input Interleaved input samples.
+   * \param num_input_channels Number of input channels.
+   * \param interleaved_output Interleaved stereo output samples.
+   */
+  template <typename SampleType>
+  void ProcessInterleaved(const SampleType* interleaved_input,
+                          size_t num_input_channels,
+                          SampleType* interleaved_output);
+
+  /*!\brief Processes `num_frames` frames through the re-buffering if it is
+   * engaged. Must be called with `mutex_` held, after the DSP graph switch.
+   *
+   * \param input_buffer Input buffer with planar audio data.
+   * \param num_frames Number of frames to process.
+   * \param output_buffer Output buffer with planar audio data.
+   */
+  void ProcessFrames(const AudioBuffer& input_buffer, size_t num_frames,
+                     AudioBuffer* output_buffer);
+
+  /*!\brief Processes one block of `buffer_size_per_channel_` frames, fading
+   * out the previous DSP graph after a switch. Must be called with `mutex_`
+   * held.
+   *
+   * \param input_buffer Input buffer with planar audio data.
+   * \param output_buffer Output buffer with planar audio data.
+   */
+  void ProcessBlock(const AudioBuffer& input_buffer,
+                    AudioBuffer* output_buffer);
+
+  /*!\brief Renders one block like `ProcessBlock()`, without peak limiting.
+   *
+   * \param input_buffer Input buffer with planar audio data.
+   * \param output_buffer Output buffer with planar audio data.
+   */
+  void RenderBlock(const AudioBuffer& input_buffer,
+                   AudioBuffer* output_buffer);
+
+  /*!\brief Renders one block with a DSP graph, without peak limiting. The
+   * input may have another channel layout than the graph was built for, as
+   * long as the channels of the shared audio elements are in the same place.
+   * Missing channels are treated as silent.
+   *
+   * \param input_buffer Input buffer with planar audio data.
+   * \param dsp DSP graph.
+   * \param output_buffer Output buffer with planar audio data.
+   */
+  void ProcessDspGraph(const AudioBuffer& input_buffer, DspGraph* dsp,
+                       AudioBuffer* output_buffer);
+
+  /*!\brief Decodes an Ambisonic block binaurally and adds the time of the
+   * decoder stages to `block_timings_`.
+   *
+   * \param input_buffer Ambisonic input buffer.
+   * \param binaural_stage Binaural stage to decode with.
+   * \param timer Timer running since the end of the previous stage.
+   * \param output_buffer Binaural output buffer.
+   */
+  void DecodeBlock(const AudioBuffer& input_buffer,
+                   BinauralStage* binaural_stage, StageTimer* timer,
+                   AudioBuffer* output_buffer);
+
+  /*!\brief Adds the timings of the block which was just processed to the
+   * processing statistics, or keeps them back if `GetStats()` holds
+   * `stats_mutex_`. Completes a `ResetStats()` request started by
+   * `RenderBlock()`. Must be called after peak limiting each block rendered by
+   * `RenderBlock()`.
+   */
+  void RecordBlockStats();
+
   const int buffer_size_per_channel_;
   const int sampling_rate_;
 
-  bool head_tracking_enabled_;
-  WorldRotation world_rotation_;
+  std::atomic<bool> head_tracking_enabled_;
+
+  // Parameters which are updated at a high rate are handed over to the audio
+  // thread without locking `mutex_`. `parameter_mutex_` only serializes the
+  // writing control threads.
+  absl::Mutex parameter_mutex_;
+  TripleBuffer<WorldRotation> world_rotation_;
+  TripleBuffer<std::vector<SourcePosition>> source_positions_;
 
   // Mutex to protect data accessed in different threads.
   mutable absl::Mutex mutex_;
 
   std::vector<AudioElementConfig> audio_elements_;
-  AudioBuffer ambisonic_encoder_input_buffer_, ambisonic_mix_bed_;
-  std::unique_ptr<AmbisonicEncoder> ambisonic_encoder_;
   Resampler resampler_;
-  FftManager fft_manager_;
-  std::unique_ptr<AudioBuffer> sh_hrirs_L_, sh_hrirs_R_;
-  std::unique_ptr<AmbisonicRotator> ambisonic_rotator_;
-  std::unique_ptr<AmbisonicBinauralDecoder> ambisonic_binaural_decoder_;
+  AmbisonicBinauralDecoderOptions binaural_decoder_options_;
+
+  // True between `BeginConfiguration()` and `CommitConfiguration()`, with the
+  // configuration to restore on failure or abort.
+  bool configuring_;
+  std::vector<AudioElementConfig> committed_audio_elements_;
+  AmbisonicBinauralDecoderOptions committed_binaural_decoder_options_;
+  bool committed_binaural_stage_outdated_;
+
+  // Kernel cache used when building binaural decoders on the control thread.
+  // Guarded by its own mutex rather than `mutex_`, so that neither setting
+  // the cache directory nor the cache I/O blocks the audio thread. Users take
+  // a reference and access the cache without holding the lock.
+  absl::Mutex kernel_cache_mutex_;
+  std::shared_ptr<const KernelCache> kernel_cache_;
+
   std::unique_ptr<PeakLimiter> peak_limiter_;
+
+  // DSP graph used by the audio thread, graph published by the control thread
+  // and the graph used before the last switch. The latter is faded out during
+  // the first block after the switch if `crossfade_` is set. It is then handed
+  // over through `finished_dsp_`, or destroyed by the control thread with the
+  // next reconfiguration if that slot is still taken.
+  std::unique_ptr<DspGraph> dsp_, pending_dsp_, previous_dsp_;
+  bool crossfade_;
+
+  // Graph which has been replaced while `previous_dsp_` was still in use.
+  std::unique_ptr<DspGraph> retired_dsp_;
+
+  // Owning pointer to a graph which the audio thread has finished with. Taken
+  // over by the next control method without locking `mutex_`.
+  std::atomic<DspGraph*> finished_dsp_;
+
+  // Binaural stage of the last built graph, for reuse by the next one. Only
+  // accessed by the control thread.
+  std::shared_ptr<BinauralStage> binaural_stage_;
+  bool binaural_stage_outdated_;
+
+  // Pruning statistics of the last published graph. Cached by the control
+  // thread when the graph is built, so that reading them does not lock
+  // `mutex_`.
+  mutable absl::Mutex kernel_pruning_stats_mutex_;
+  KernelPruningStats kernel_pruning_stats_;
+
+  // Re-buffering of blocks with other sizes than `buffer_size_per_channel_`.
+  // Once engaged, `fifo_output_block_` holds the output of the last processed
+  // block, of which the last `buffer_size_per_channel_ - 1 -
+  // num_fifo_input_frames_` frames have not been output yet. Only written by
+  // the audio thread, `fifo_engaged_` is atomic for `GetLatencyInFrames()`.
+  std::atomic<bool> fifo_engaged_;
+  size_t num_fifo_input_frames_;
+  AudioBuffer fifo_output_block_;
+
+  // Output block of the `Process()` overloads for external buffers, and a
+  // view of one block of the external output channels.
+  AudioBuffer external_output_block_, external_output_view_;
+
+  // Processing time of the stages of the current block in microseconds.
+  struct BlockTimings {
+    float encoder_us = 0.0f;
+    float ambisonic_mix_us = 0.0f;
+    float rotator_us = 0.0f;
+    float binaural_decoder_us = 0.0f;
+    float forward_fft_us = 0.0f;
+    float multiply_accumulate_us = 0.0f;
+    float inverse_fft_us = 0.0f;
+    float peak_limiter_us = 0.0f;
+    float total_us = 0.0f;
+  };
+  BlockTimings block_timings_;
+  StageTimer block_timer_;
+
+  // Rolling statistics of the members of `BlockTimings`.
+  struct StageStats {
+    RollingStats encoder;
+    RollingStats ambisonic_mix;
+    RollingStats rotator;
+    RollingStats binaural_decoder;
+    RollingStats forward_fft;
+    RollingStats multiply_accumulate;
+    RollingStats inverse_fft;
+    RollingStats peak_limiter;
+    RollingStats total;
+  };
+
+  // Statistics published by the audio thread, which only updates them if it
+  // gets `stats_mutex_` without waiting. `GetStats()` copies them under the
+  // lock and summarizes the copy.
+  mutable absl::Mutex stats_mutex_;
+  StageStats stage_stats_;
+  size_t num_blocks_;
+  size_t num_limited_blocks_;
+  size_t num_limited_frames_;
+
+  // Blocks which have not been added to `stage_stats_` yet, as the lock was
+  // taken. Only the timings of the first `kMaxNumPendingBlocks` are kept, all
+  // are counted. Only accessed by the audio thread.
+  static constexpr size_t kMaxNumPendingBlocks = 8;
+  std::array<BlockTimings, kMaxNumPendingBlocks> pending_block_timings_;
+  size_t num_pending_blocks_;
+
+  // Set by `ResetStats()` and cleared by the audio thread once the statistics
+  // are reset. `resetting_stats_` is set while the first block after the
+  // request waits to be published, and is only accessed by the audio thread.
+  std::atomic<bool> stats_reset_requested_;
+  bool resetting_stats_;
 };
 
 }  // namespace obr
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2025 Google LLC
+ *
+ * This source code is subject to the terms of the BSD 3-Clause Clear License,
+ * which you can find in the LICENSE file, and the Open Binaural Renderer
+ * Patent License 1.0, which you can find in the PATENTS file.
+ */
+
+// Tests that `ObrImpl::Process()` does not allocate heap memory. The malloc
+// family is replaced for this test binary, which also covers `operator new`,
+// Eigen and the aligned allocator of `AudioBuffer`.
+
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "absl/status/status_matchers.h"
+#include "gtest/gtest.h"
+#include "obr/ambisonic_binaural_decoder/ambisonic_binaural_decoder.h"
+#include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
+#include "obr/renderer/audio_element_type.h"
+#include "obr/renderer/obr_impl.h"
+
+#if defined(__GLIBC__)
+#define OBR_ALLOCATION_HOOK 1
+
+namespace {
+
+// Number of heap allocations of the current thread while counting is enabled.
+thread_local bool count_allocations = false;
+thread_local size_t num_allocations = 0;
+
+void CountAllocation() {
+  if (count_allocations) {
+    ++num_allocations;
+  }
+}
+
+}  // namespace
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) {
+  CountAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size) {
+  CountAllocation();
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  CountAllocation();
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  CountAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  CountAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  CountAllocation();
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr == nullptr ? ENOMEM : 0;
+}
+
+}  // extern "C"
+
+#endif  // defined(__GLIBC__)
+
+namespace obr {
+namespace {
+
+using ::absl_testing::IsOk;
+
+const int kBufferSizePerChannel = 256;
+const int kSamplingRate = 48000;
+const size_t kNumBuffers = 3;
+
+// Counts the heap allocations of the current thread in its scope.
+class ScopedAllocationCounter {
+ public:
+  ScopedAllocationCounter() {
+#if defined(OBR_ALLOCATION_HOOK)
+    num_allocations = 0;
+    count_allocations = true;
+#endif
+  }
+
+  ~ScopedAllocationCounter() {
+#if defined(OBR_ALLOCATION_HOOK)
+    count_allocations = false;
+#endif
+  }
+
+  size_t GetNumAllocations() const {
+#if defined(OBR_ALLOCATION_HOOK)
+    return num_allocations;
+#else
+    return 0;
+#endif
+  }
+};
+
+// Renders a few blocks with moving objects and head rotation and returns the
+// number of heap allocations inside `Process()`.
+size_t CountProcessAllocations(ObrImpl* renderer, bool head_tracking) {
+  renderer->EnableHeadTracking(head_tracking);
+  const size_t num_channels = renderer->GetNumberOfInputChannels();
+  AudioBuffer input(num_channels, kBufferSizePerChannel);
+  AudioBuffer output(kNumBinauralChannels, kBufferSizePerChannel);
+  std::vector<float> float_input(num_channels * kBufferSizePerChannel, 0.01f);
+  std::vector<int16_t> int16_input(float_input.size(), 300);
+  std::vector<float> float_output(kNumBinauralChannels * kBufferSizePerChannel);
+  std::vector<int16_t> int16_output(float_output.size());
+  std::vector<const float*> input_ptrs, unaligned_input_ptrs;
+  for (size_t channel = 0; channel < num_channels; ++channel) {
+    input_ptrs.push_back(input[channel].begin());
+    unaligned_input_ptrs.push_back(input[channel].begin() + 1);
+  }
+  float* output_ptrs[] = {output[0].begin(), output[1].begin()};
+  float* unaligned_output_ptrs[] = {output[0].begin() + 1,
+                                    output[1].begin() + 1};
+  for (size_t channel = 0; channel < num_channels; ++channel) {
+    for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+      input[channel][frame] =
+          0.01f * std::sin(0.02f * static_cast<float>((channel + 1) * frame));
+    }
+  }
+
+  size_t num_process_allocations = 0;
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    const float angle = 10.0f * static_cast<float>(buffer);
+    for (size_t element = 0; element < renderer->GetNumberOfAudioElements();
+         ++element) {
+      // Fails for elements without objects, which is fine.
+      renderer->UpdateObjectPosition(element, angle, 0.0f, 1.0f).IgnoreError();
+    }
+    const float half_angle = 0.5f * angle * kRadiansFromDegrees;
+    EXPECT_THAT(renderer->SetHeadRotation(std::cos(half_angle), 0.0f,
+                                          std::sin(half_angle), 0.0f),
+                IsOk());
+
+    ScopedAllocationCounter counter;
+    renderer->Process(input, &output);
+    renderer->Process(float_input.data(), num_channels, float_output.data());
+    renderer->Process(int16_input.data(), num_channels, int16_output.data());
+    renderer->Process(input_ptrs.data(), output_ptrs, kBufferSizePerChannel);
+    // Unaligned channels are copied.
+    renderer->Process(unaligned_input_ptrs.data(), unaligned_output_ptrs,
+                      kBufferSizePerChannel - 1);
+    // Re-buffering of a partial block, which the next interleaved blocks go
+    // through as well.
+    renderer->Process(input, kBufferSizePerChannel / 2, &output);
+    num_process_allocations += counter.GetNumAllocations();
+  }
+  return num_process_allocations;
+}
+
+class ObrImplAllocationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+#if !defined(OBR_ALLOCATION_HOOK)
+    GTEST_SKIP() << "Allocation hook requires glibc.";
+#endif
+  }
+};
+
+class ObrImplAllocationPerTypeTest
+    : public ObrImplAllocationTest,
+      public ::testing::WithParamInterface<std::tuple<AudioElementType, bool>> {
+ protected:
+  // Keeps the seventh order filters, which most types use, alive in the
+  // `KernelRegistry` for all tests.
+  static void SetUpTestSuite() {
+    seventh_order_renderer_ = new ObrImpl(kBufferSizePerChannel, kSamplingRate);
+    ASSERT_THAT(
+        seventh_order_renderer_->AddAudioElement(AudioElementType::k7OA),
+        IsOk());
+  }
+
+  static void TearDownTestSuite() {
+    delete seventh_order_renderer_;
+    seventh_order_renderer_ = nullptr;
+  }
+
+  static ObrImpl* seventh_order_renderer_;
+};
+
+ObrImpl* ObrImplAllocationPerTypeTest::seventh_order_renderer_ = nullptr;
+
+// Tests that processing each audio element type does not allocate, including
+// the switch to a new DSP graph.
+TEST_P(ObrImplAllocationPerTypeTest, ProcessDoesNotAllocate) {
+  const auto [type, head_tracking] = GetParam();
+  ObrImpl renderer(kBufferSizePerChannel, kSamplingRate);
+  ASSERT_THAT(renderer.AddAudioElement(type), IsOk());
+  EXPECT_EQ(CountProcessAllocations(&renderer, head_tracking), 0U);
+
+  // Switching to and crossfading with a graph of another order.
+  ASSERT_THAT(renderer.AddAudioElement(AudioElementType::k1OA), IsOk());
+  EXPECT_EQ(CountProcessAllocations(&renderer, head_tracking), 0U);
+}
+
+// Tests that the other decoding modes do not allocate either.
+TEST_F(ObrImplAllocationTest, ProcessWithDecoderOptionsDoesNotAllocate) {
+  AmbisonicBinauralDecoderOptions options[5];
+  options[0].convolution_mode = ConvolutionMode::kNonUniformPartitioned;
+  options[1].convolution_mode = ConvolutionMode::kTimeDomainHead;
+  options[2].symmetric_sh_hrirs = true;
+  options[3].prune_kernels = true;
+  options[4].shared_late_tail = true;
+  for (const auto type :
+       {AudioElementType::k3OA, AudioElementType::kObjectMono}) {
+    for (const auto& option : options) {
+      ObrImpl renderer(kBufferSizePerChannel, kSamplingRate);
+      ASSERT_THAT(renderer.SetBinauralDecoderOptions(option), IsOk());
+      ASSERT_THAT(renderer.AddAudioElement(type), IsOk());
+      EXPECT_EQ(CountProcessAllocations(&renderer, true), 0U);
+    }
+  }
+}
+
+std::vector<AudioElementType> GetAudioElementTypes() {
+  std::vector<AudioElementType> types;
+  for (const auto& entry : GetAudioElementTypeStringMap()) {
+    types.push_back(entry.first);
+  }
+  return types;
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AllTypes, ObrImplAllocationPerTypeTest,
+    ::testing::Combine(::testing::ValuesIn(GetAudioElementTypes()),
+                       ::testing::Bool()));
+
+}  // namespace
+}  // namespace obr
@@ -8,16 +8,28 @@
 
 #include "obr/renderer/obr_impl.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "obr/ambisonic_binaural_decoder/ambisonic_binaural_decoder.h"
+#include "obr/ambisonic_binaural_decoder/kernel_registry.h"
+#include "obr/ambisonic_binaural_decoder/sample_type_conversion.h"
 #include "obr/ambisonic_encoder/ambisonic_encoder.h"
 #include "obr/audio_buffer/audio_buffer.h"
+#include "obr/common/constants.h"
 #include "obr/common/test_util.h"
 #include "obr/renderer/audio_element_type.h"
 
@@ -82,6 +94,7 @@ TEST(ObrImplTest, TestInitialization) {
   EXPECT_EQ(renderer.GetSamplingRate(), kSamplingRate);
   EXPECT_EQ(renderer.GetNumberOfInputChannels(), 0);
   EXPECT_EQ(renderer.GetNumberOfOutputChannels(), 2);
+  EXPECT_EQ(renderer.GetLatencyInFrames(), 0);
 }
 
 // Test adding and removing 1 audio element.
@@ -106,14 +119,264 @@ TEST(ObrImplTest, TestAddAudioElements) {
   EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
   EXPECT_EQ(renderer.GetNumberOfInputChannels(), 16);
 
-  // Expect fail.
-  EXPECT_FALSE(
-      renderer.AddAudioElement(AudioElementType::kLayout7_1_4_ch).ok());
+  // Elements of different types share the renderer.
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kLayout7_1_4_ch),
+              IsOk());
+  EXPECT_EQ(renderer.GetNumberOfInputChannels(), 28);
+  EXPECT_THAT(renderer.RemoveLastAudioElement(), IsOk());
   EXPECT_THAT(renderer.RemoveLastAudioElement(), IsOk());
   EXPECT_FALSE(renderer.RemoveLastAudioElement().ok());
   EXPECT_EQ(renderer.GetNumberOfInputChannels(), 0);
 }
 
+// Tests that a scene of mixed audio element types renders the same as the sum
+// of its elements rendered separately at the highest Ambisonic order.
+TEST(ObrImplTest, TestMixedAudioElementTypes) {
+  const int kBufferSizePerChannel = 64;
+  const int kSamplingRate = 48000;
+  const size_t kNumBuffers = 4;
+  const float kEpsilon = 1e-5f;
+
+  // 3OA ambience, dialogue object and 7.1.4 bed in one renderer.
+  ObrImpl renderer(kBufferSizePerChannel, kSamplingRate);
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono), IsOk());
+  EXPECT_THAT(renderer.UpdateObjectPosition(1, 30.0f, 0.0f, 1.0f), IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kLayout7_1_4_ch),
+              IsOk());
+  const size_t num_channels = renderer.GetNumberOfInputChannels();
+  ASSERT_EQ(num_channels, 16 + 1 + 12);
+
+  // The 3OA element is rendered through the 7OA bed required by the others.
+  ObrImpl ambisonic_renderer(kBufferSizePerChannel, kSamplingRate);
+  EXPECT_THAT(ambisonic_renderer.AddAudioElement(AudioElementType::k7OA),
+              IsOk());
+  ObrImpl object_renderer(kBufferSizePerChannel, kSamplingRate);
+  EXPECT_THAT(object_renderer.AddAudioElement(AudioElementType::kObjectMono),
+              IsOk());
+  EXPECT_THAT(object_renderer.UpdateObjectPosition(0, 30.0f, 0.0f, 1.0f),
+              IsOk());
+  ObrImpl layout_renderer(kBufferSizePerChannel, kSamplingRate);
+  EXPECT_THAT(
+      layout_renderer.AddAudioElement(AudioElementType::kLayout7_1_4_ch),
+      IsOk());
+
+  AudioBuffer input(num_channels, kBufferSizePerChannel);
+  AudioBuffer ambisonic_input(64, kBufferSizePerChannel);
+  AudioBuffer object_input(1, kBufferSizePerChannel);
+  AudioBuffer layout_input(12, kBufferSizePerChannel);
+  ambisonic_input.Clear();
+  AudioBuffer output(kNumBinauralChannels, kBufferSizePerChannel);
+  AudioBuffer ambisonic_output(kNumBinauralChannels, kBufferSizePerChannel);
+  AudioBuffer object_output(kNumBinauralChannels, kBufferSizePerChannel);
+  AudioBuffer layout_output(kNumBinauralChannels, kBufferSizePerChannel);
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    // A quiet input keeps the peak limiter transparent.
+    for (size_t channel = 0; channel < num_channels; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        const float time =
+            static_cast<float>(buffer * kBufferSizePerChannel + frame);
+        input[channel][frame] =
+            0.002f * std::sin(0.01f * static_cast<float>(channel + 1) * time);
+      }
+    }
+    for (size_t channel = 0; channel < 16; ++channel) {
+      ambisonic_input[channel] = input[channel];
+    }
+    object_input[0] = input[16];
+    for (size_t channel = 0; channel < 12; ++channel) {
+      layout_input[channel] = input[17 + channel];
+    }
+
+    renderer.Process(input, &output);
+    ambisonic_renderer.Process(ambisonic_input, &ambisonic_output);
+    object_renderer.Process(object_input, &object_output);
+    layout_renderer.Process(layout_input, &layout_output);
+    for (size_t channel = 0; channel < kNumBinauralChannels; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        EXPECT_NEAR(output[channel][frame],
+                    ambisonic_output[channel][frame] +
+                        object_output[channel][frame] +
+                        layout_output[channel][frame],
+                    kEpsilon);
+      }
+    }
+  }
+}
+
+// Tests that a batch configuration renders the same as the equivalent single
+// calls and keeps the last committed configuration until it is committed.
+TEST(ObrImplTest, TestBatchConfiguration) {
+  const int kBufferSizePerChannel = 64;
+  const int kSamplingRate = 48000;
+  const size_t kNumObjects = 3;
+  const float kAzimuths[kNumObjects] = {-60.0f, 20.0f, 90.0f};
+
+  ObrImpl reference_renderer(kBufferSizePerChannel, kSamplingRate);
+  for (size_t object = 0; object < kNumObjects; ++object) {
+    EXPECT_THAT(
+        reference_renderer.AddAudioElement(AudioElementType::kObjectMono),
+        IsOk());
+    EXPECT_THAT(reference_renderer.UpdateObjectPosition(
+                    object, kAzimuths[object], 10.0f, 1.0f),
+                IsOk());
+  }
+
+  ObrImpl renderer(kBufferSizePerChannel, kSamplingRate);
+  EXPECT_FALSE(renderer.CommitConfiguration().ok());
+  EXPECT_FALSE(renderer.AbortConfiguration().ok());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono), IsOk());
+  EXPECT_THAT(renderer.BeginConfiguration(), IsOk());
+  EXPECT_FALSE(renderer.BeginConfiguration().ok());
+  for (size_t object = 1; object < kNumObjects; ++object) {
+    EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono),
+                IsOk());
+  }
+  for (size_t object = 0; object < kNumObjects; ++object) {
+    EXPECT_THAT(
+        renderer.UpdateObjectPosition(object, kAzimuths[object], 10.0f, 1.0f),
+        IsOk());
+  }
+  // Staged changes are still checked.
+  EXPECT_FALSE(
+      renderer.UpdateObjectPosition(kNumObjects, 0.0f, 0.0f, 1.0f).ok());
+  EXPECT_EQ(renderer.GetNumberOfInputChannels(), kNumObjects);
+
+  // The committed configuration with one object is rendered meanwhile. It
+  // only processes silence, so the decoder state matches the reference.
+  AudioBuffer input(1, kBufferSizePerChannel);
+  input.Clear();
+  AudioBuffer output(kNumBinauralChannels, kBufferSizePerChannel);
+  renderer.Process(input, &output);
+  EXPECT_THAT(renderer.CommitConfiguration(), IsOk());
+
+  AudioBuffer scene_input(kNumObjects, kBufferSizePerChannel);
+  for (size_t object = 0; object < kNumObjects; ++object) {
+    for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+      scene_input[object][frame] =
+          0.01f * std::sin(0.1f * static_cast<float>((object + 1) * frame));
+    }
+  }
+  AudioBuffer reference_output(kNumBinauralChannels, kBufferSizePerChannel);
+  for (size_t buffer = 0; buffer < 4; ++buffer) {
+    reference_renderer.Process(scene_input, &reference_output);
+    renderer.Process(scene_input, &output);
+    for (size_t channel = 0; channel < kNumBinauralChannels; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        EXPECT_EQ(output[channel][frame], reference_output[channel][frame]);
+      }
+    }
+  }
+
+  // Aborting restores the committed configuration.
+  EXPECT_THAT(renderer.BeginConfiguration(), IsOk());
+  EXPECT_THAT(renderer.RemoveLastAudioElement(), IsOk());
+  EXPECT_THAT(renderer.RemoveLastAudioElement(), IsOk());
+  EXPECT_EQ(renderer.GetNumberOfAudioElements(), kNumObjects - 2);
+  EXPECT_THAT(renderer.AbortConfiguration(), IsOk());
+  EXPECT_EQ(renderer.GetNumberOfAudioElements(), kNumObjects);
+  renderer.Process(scene_input, &output);
+}
+
+// Tests that committing a configuration without audio elements fails and keeps
+// rendering the committed configuration.
+TEST(ObrImplTest, TestEmptyCommitIsRejected) {
+  const int kBufferSizePerChannel = 64;
+
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kLayoutStereo),
+              IsOk());
+  AmbisonicBinauralDecoderOptions options;
+  options.symmetric_sh_hrirs = true;
+  EXPECT_THAT(renderer.BeginConfiguration(), IsOk());
+  EXPECT_THAT(renderer.RemoveLastAudioElement(), IsOk());
+  EXPECT_THAT(renderer.SetBinauralDecoderOptions(options), IsOk());
+  EXPECT_EQ(renderer.GetNumberOfInputChannels(), 0U);
+  EXPECT_TRUE(absl::IsFailedPrecondition(renderer.CommitConfiguration()));
+
+  // The stereo layout is restored and still rendered.
+  EXPECT_EQ(renderer.GetNumberOfAudioElements(), 1U);
+  EXPECT_EQ(renderer.GetNumberOfInputChannels(), 2U);
+  AudioBuffer input(2, kBufferSizePerChannel);
+  input.Clear();
+  AudioBuffer output(kNumBinauralChannels, kBufferSizePerChannel);
+  renderer.Process(input, &output);
+
+  // A new configuration can be started after the failed commit.
+  EXPECT_THAT(renderer.BeginConfiguration(), IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono),
+              IsOk());
+  EXPECT_THAT(renderer.CommitConfiguration(), IsOk());
+  EXPECT_EQ(renderer.GetNumberOfInputChannels(), 3U);
+}
+
+// Tests that a single Ambisonic element, which is rotated or decoded without
+// copying it to the mix bed, renders like the same element mixed with a
+// silent one.
+TEST(ObrImplTest, TestAmbisonicPassThrough) {
+  const int kBufferSizePerChannel = 64;
+  const size_t kNumBuffers = 8;
+  const int kAmbisonicOrder = 3;
+  const size_t kNumAmbisonicChannels = 16;
+
+  for (const bool head_tracking : {false, true}) {
+    ObrImpl renderer(kBufferSizePerChannel, 48000);
+    ObrImpl pointer_renderer(kBufferSizePerChannel, 48000);
+    ObrImpl mixed_renderer(kBufferSizePerChannel, 48000);
+    EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+    EXPECT_THAT(pointer_renderer.AddAudioElement(AudioElementType::k3OA),
+                IsOk());
+    EXPECT_THAT(mixed_renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+    EXPECT_THAT(mixed_renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+
+    AudioBuffer scene = GetKroneckerDeltaEncodedToAmbisonics(
+        kBufferSizePerChannel, 60.0f, 20.0f, 1.0f, kAmbisonicOrder);
+    AudioBuffer input(kNumAmbisonicChannels, kBufferSizePerChannel);
+    AudioBuffer mixed_input(2 * kNumAmbisonicChannels, kBufferSizePerChannel);
+    mixed_input.Clear();
+    std::vector<const float*> input_ptrs;
+    for (size_t channel = 0; channel < kNumAmbisonicChannels; ++channel) {
+      input_ptrs.push_back(input[channel].begin());
+    }
+    AudioBuffer output(2, kBufferSizePerChannel);
+    AudioBuffer pointer_output(2, kBufferSizePerChannel);
+    float* output_ptrs[] = {pointer_output[0].begin(),
+                            pointer_output[1].begin()};
+    AudioBuffer mixed_output(2, kBufferSizePerChannel);
+    for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+      for (ObrImpl* obr : {&renderer, &pointer_renderer, &mixed_renderer}) {
+        obr->EnableHeadTracking(head_tracking);
+        const float half_angle =
+            2.5f * static_cast<float>(buffer) * kRadiansFromDegrees;
+        EXPECT_THAT(obr->SetHeadRotation(std::cos(half_angle), 0.0f,
+                                         std::sin(half_angle), 0.0f),
+                    IsOk());
+      }
+      if (buffer == 0) {
+        input = scene;
+      } else {
+        input.Clear();
+      }
+      for (size_t channel = 0; channel < kNumAmbisonicChannels; ++channel) {
+        mixed_input[channel] = input[channel];
+      }
+
+      renderer.Process(input, &output);
+      pointer_renderer.Process(input_ptrs.data(), output_ptrs,
+                               kBufferSizePerChannel);
+      mixed_renderer.Process(mixed_input, &mixed_output);
+      for (size_t channel = 0; channel < 2; ++channel) {
+        for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+          EXPECT_NEAR(output[channel][frame], mixed_output[channel][frame],
+                      1e-6f);
+          EXPECT_NEAR(pointer_output[channel][frame],
+                      mixed_output[channel][frame], 1e-6f);
+        }
+      }
+    }
+  }
+}
+
 // Test rendering of Ambisonic scenes containing a Kronecker delta at different
 // azimuths.
 TEST(ObrImplTest, TestRenderAmbisonicsAndMeasureBroadbandILD) {
@@ -155,6 +418,935 @@ TEST(ObrImplTest, TestRenderAmbisonicsAndMeasureBroadbandILD) {
   }
 }
 
+// Tests that pruning the decoder kernels skips part of the convolution work
+// while keeping the error energy of the output close to the pruning threshold
+// below the output energy.
+TEST(ObrImplTest, TestKernelPruning) {
+  const int kBufferSizePerChannel = 256;
+  const size_t kNumBuffers = 40;
+  const int kAmbisonicOrder = 3;
+  const double kMaxErrorToSignalRatioDb = -35.0;
+
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_EQ(renderer.GetKernelPruningStats().num_partitions, 0U);
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+  EXPECT_GT(renderer.GetKernelPruningStats().num_partitions, 0U);
+  EXPECT_EQ(renderer.GetKernelPruningStats().num_skipped_partitions, 0U);
+
+  ObrImpl pruned_renderer(kBufferSizePerChannel, 48000);
+  AmbisonicBinauralDecoderOptions options;
+  options.prune_kernels = true;
+  options.kernel_pruning_threshold_db = -40.0f;
+  EXPECT_THAT(pruned_renderer.SetBinauralDecoderOptions(options), IsOk());
+  EXPECT_THAT(pruned_renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+  const KernelPruningStats stats = pruned_renderer.GetKernelPruningStats();
+  EXPECT_GT(stats.num_skipped_partitions, 0U);
+  EXPECT_GT(stats.saved_flops_per_buffer, 0U);
+  EXPECT_LT(stats.saved_flops_per_buffer, stats.flops_per_buffer);
+
+  AudioBuffer scene = GetKroneckerDeltaEncodedToAmbisonics(
+      kBufferSizePerChannel, 30.0f, 10.0f, 1.0f, kAmbisonicOrder);
+  AudioBuffer silence(scene.num_channels(), kBufferSizePerChannel);
+  silence.Clear();
+  AudioBuffer output(2, kBufferSizePerChannel);
+  AudioBuffer pruned_output(2, kBufferSizePerChannel);
+  double signal_energy = 0.0;
+  double error_energy = 0.0;
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    const AudioBuffer& input = buffer == 0 ? scene : silence;
+    renderer.Process(input, &output);
+    pruned_renderer.Process(input, &pruned_output);
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        const double error =
+            pruned_output[channel][frame] - output[channel][frame];
+        signal_energy += output[channel][frame] * output[channel][frame];
+        error_energy += error * error;
+      }
+    }
+  }
+  EXPECT_LT(10.0 * std::log10(error_energy / signal_energy),
+            kMaxErrorToSignalRatioDb);
+}
+
+// Tests that the hybrid decoder with a shared late tail keeps the early
+// response and approximately preserves the late reverb energy of each ear.
+TEST(ObrImplTest, TestSharedLateTail) {
+  const int kBufferSizePerChannel = 256;
+  const size_t kNumBuffers = 40;
+  const size_t kEarlySize = 1024;
+  const int kAmbisonicOrder = 3;
+  const float kEarlyEpsilon = 1e-4f;
+  const double kMaxLateEnergyErrorDb = 1.5;
+
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+
+  ObrImpl hybrid_renderer(kBufferSizePerChannel, 48000);
+  AmbisonicBinauralDecoderOptions options;
+  options.shared_late_tail = true;
+  options.early_size = kEarlySize;
+  options.late_tail_crossfade_size = 256;
+  EXPECT_THAT(hybrid_renderer.SetBinauralDecoderOptions(options), IsOk());
+  EXPECT_THAT(hybrid_renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+
+  AudioBuffer output(2, kBufferSizePerChannel);
+  AudioBuffer hybrid_output(2, kBufferSizePerChannel);
+  for (const float azimuth : {0.0f, 60.0f, 150.0f, 270.0f}) {
+    AudioBuffer scene = GetKroneckerDeltaEncodedToAmbisonics(
+        kBufferSizePerChannel, azimuth, 0.0f, 1.0f, kAmbisonicOrder);
+    AudioBuffer silence(scene.num_channels(), kBufferSizePerChannel);
+    silence.Clear();
+    double late_energy[2] = {0.0, 0.0};
+    double hybrid_late_energy[2] = {0.0, 0.0};
+    for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+      const AudioBuffer& input = buffer == 0 ? scene : silence;
+      renderer.Process(input, &output);
+      hybrid_renderer.Process(input, &hybrid_output);
+      for (size_t channel = 0; channel < 2; ++channel) {
+        for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+          const size_t time = buffer * kBufferSizePerChannel + frame;
+          if (time < kEarlySize - options.late_tail_crossfade_size) {
+            EXPECT_NEAR(hybrid_output[channel][frame], output[channel][frame],
+                        kEarlyEpsilon);
+          } else if (time >= kEarlySize) {
+            late_energy[channel] +=
+                output[channel][frame] * output[channel][frame];
+            hybrid_late_energy[channel] +=
+                hybrid_output[channel][frame] * hybrid_output[channel][frame];
+          }
+        }
+      }
+    }
+    for (size_t channel = 0; channel < 2; ++channel) {
+      EXPECT_NEAR(10.0 * std::log10(hybrid_late_energy[channel] /
+                                    late_energy[channel]),
+                  0.0, kMaxLateEnergyErrorDb);
+    }
+  }
+}
+
+/*!\brief Renders a Kronecker delta with a new 3OA renderer.
+ *
+ *  \param buffer_size_per_channel Buffer size per channel.
+ *  \param num_buffers Number of buffers to render.
+ *  \param kernel_cache_directory Kernel cache directory, empty to disable the
+ *         kernel cache.
+ *
+ *  \return Rendered left and right channels.
+ */
+std::vector<std::vector<float>> RenderKroneckerDelta(
+    const int buffer_size_per_channel, const size_t num_buffers,
+    const std::string& kernel_cache_directory) {
+  ObrImpl renderer(buffer_size_per_channel, 48000);
+  EXPECT_THAT(renderer.SetKernelCacheDirectory(kernel_cache_directory),
+              IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+
+  AudioBuffer scene = GetKroneckerDeltaEncodedToAmbisonics(
+      buffer_size_per_channel, 30.0f, 10.0f, 1.0f, 3);
+  AudioBuffer silence(scene.num_channels(), buffer_size_per_channel);
+  silence.Clear();
+  AudioBuffer output(2, buffer_size_per_channel);
+  std::vector<std::vector<float>> rendered(2);
+  for (size_t buffer = 0; buffer < num_buffers; ++buffer) {
+    renderer.Process(buffer == 0 ? scene : silence, &output);
+    for (size_t channel = 0; channel < 2; ++channel) {
+      rendered[channel].insert(rendered[channel].end(),
+                               output[channel].begin(), output[channel].end());
+    }
+  }
+  return rendered;
+}
+
+// Tests that renderers loading their kernels from the kernel cache render the
+// same output as a renderer computing them. The renderers run one after the
+// other, so they do not share their kernels through the registry.
+TEST(ObrImplTest, TestKernelCache) {
+  const int kBufferSizePerChannel = 128;
+  const size_t kNumBuffers = 8;
+  const std::filesystem::path cache_directory =
+      std::filesystem::temp_directory_path() / "obr_impl_test_kernel_cache";
+  std::filesystem::remove_all(cache_directory);
+
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_FALSE(renderer.SetKernelCacheDirectory(cache_directory.string()).ok());
+  std::filesystem::create_directories(cache_directory);
+
+  // The first renderer fills the cache, the second one loads from it.
+  const std::vector<std::vector<float>> output = RenderKroneckerDelta(
+      kBufferSizePerChannel, kNumBuffers, cache_directory.string());
+  size_t num_cache_files = 0;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(cache_directory)) {
+    EXPECT_EQ(entry.path().extension(), ".bin");
+    ++num_cache_files;
+  }
+  EXPECT_EQ(num_cache_files, 2);
+  const std::vector<std::vector<float>> cached_output = RenderKroneckerDelta(
+      kBufferSizePerChannel, kNumBuffers, cache_directory.string());
+  const std::vector<std::vector<float>> reference_output =
+      RenderKroneckerDelta(kBufferSizePerChannel, kNumBuffers, "");
+
+  EXPECT_EQ(output, reference_output);
+  EXPECT_EQ(cached_output, reference_output);
+  std::filesystem::remove_all(cache_directory);
+}
+
+// Tests that renderers with the same configuration share one set of kernels
+// and render the same output as a renderer with its own kernels.
+TEST(ObrImplTest, TestSharedKernels) {
+  const int kBufferSizePerChannel = 128;
+  const size_t kNumBuffers = 8;
+  KernelRegistry& registry = KernelRegistry::GetInstance();
+  ASSERT_EQ(registry.GetNumKernelSets(), 0);
+  const std::vector<std::vector<float>> reference_output =
+      RenderKroneckerDelta(kBufferSizePerChannel, kNumBuffers, "");
+  EXPECT_EQ(registry.GetNumKernelSets(), 0);
+
+  std::vector<std::unique_ptr<ObrImpl>> renderers;
+  for (const int buffer_size_per_channel :
+       {kBufferSizePerChannel, kBufferSizePerChannel,
+        2 * kBufferSizePerChannel}) {
+    renderers.push_back(
+        std::make_unique<ObrImpl>(buffer_size_per_channel, 48000));
+    EXPECT_THAT(renderers.back()->AddAudioElement(AudioElementType::k3OA),
+                IsOk());
+  }
+  EXPECT_EQ(registry.GetNumKernelSets(), 2);
+
+  // Modes which need the time domain filters do not use the registry.
+  ObrImpl pruning_renderer(kBufferSizePerChannel, 48000);
+  AmbisonicBinauralDecoderOptions options;
+  options.prune_kernels = true;
+  EXPECT_THAT(pruning_renderer.SetBinauralDecoderOptions(options), IsOk());
+  EXPECT_THAT(pruning_renderer.AddAudioElement(AudioElementType::k3OA),
+              IsOk());
+  EXPECT_EQ(registry.GetNumKernelSets(), 2);
+
+  AudioBuffer scene = GetKroneckerDeltaEncodedToAmbisonics(
+      kBufferSizePerChannel, 30.0f, 10.0f, 1.0f, 3);
+  AudioBuffer silence(scene.num_channels(), kBufferSizePerChannel);
+  silence.Clear();
+  AudioBuffer output(2, kBufferSizePerChannel);
+  for (size_t renderer = 0; renderer < 2; ++renderer) {
+    for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+      renderers[renderer]->Process(buffer == 0 ? scene : silence, &output);
+      for (size_t channel = 0; channel < 2; ++channel) {
+        for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+          EXPECT_EQ(output[channel][frame],
+                    reference_output[channel]
+                                    [buffer * kBufferSizePerChannel + frame]);
+        }
+      }
+    }
+  }
+
+  // Kernel sets are released together with their last user.
+  renderers.pop_back();
+  EXPECT_EQ(registry.GetNumKernelSets(), 1);
+  renderers.clear();
+  EXPECT_EQ(registry.GetNumKernelSets(), 0);
+}
+
+// Tests that the non-uniformly partitioned and the time domain head convolution
+// engines render the same output as the default uniformly partitioned one.
+TEST(ObrImplTest, TestConvolutionModesMatchUniform) {
+  const int kBufferSizePerChannel = 64;
+  const size_t kNumBuffers = 40;
+  const int kAmbisonicOrder = 3;
+  const float kEpsilon = 1e-4f;
+
+  ObrImpl uniform_renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(uniform_renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+
+  ObrImpl non_uniform_renderer(kBufferSizePerChannel, 48000);
+  AmbisonicBinauralDecoderOptions options;
+  options.convolution_mode = ConvolutionMode::kNonUniformPartitioned;
+  options.max_partition_size = 512;
+  EXPECT_THAT(non_uniform_renderer.SetBinauralDecoderOptions(options), IsOk());
+
+  ObrImpl time_domain_head_renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(time_domain_head_renderer.AddAudioElement(AudioElementType::k3OA),
+              IsOk());
+  options.convolution_mode = ConvolutionMode::kTimeDomainHead;
+  options.head_size = 48;
+  EXPECT_THAT(time_domain_head_renderer.SetBinauralDecoderOptions(options),
+              IsOk());
+  EXPECT_EQ(time_domain_head_renderer.GetLatencyInFrames(), 0);
+  EXPECT_THAT(non_uniform_renderer.AddAudioElement(AudioElementType::k3OA),
+              IsOk());
+
+  // The bundled filters are not symmetric, so this falls back to decoding both
+  // ears separately.
+  ObrImpl pruning_renderer(kBufferSizePerChannel, 48000);
+  AmbisonicBinauralDecoderOptions symmetric_options;
+  symmetric_options.symmetric_sh_hrirs = true;
+  EXPECT_THAT(pruning_renderer.SetBinauralDecoderOptions(symmetric_options),
+              IsOk());
+  EXPECT_THAT(pruning_renderer.AddAudioElement(AudioElementType::k3OA),
+              IsOk());
+
+  AudioBuffer scene = GetKroneckerDeltaEncodedToAmbisonics(
+      kBufferSizePerChannel, 90.0f, 0.0f, 1.0f, kAmbisonicOrder);
+  AudioBuffer silence(scene.num_channels(), kBufferSizePerChannel);
+  silence.Clear();
+  AudioBuffer uniform_output(2, kBufferSizePerChannel);
+  AudioBuffer non_uniform_output(2, kBufferSizePerChannel);
+  AudioBuffer time_domain_head_output(2, kBufferSizePerChannel);
+  AudioBuffer symmetric_output(2, kBufferSizePerChannel);
+
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    const AudioBuffer& input = buffer == 0 ? scene : silence;
+    uniform_renderer.Process(input, &uniform_output);
+    non_uniform_renderer.Process(input, &non_uniform_output);
+    time_domain_head_renderer.Process(input, &time_domain_head_output);
+    pruning_renderer.Process(input, &symmetric_output);
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        EXPECT_NEAR(non_uniform_output[channel][frame],
+                    uniform_output[channel][frame], kEpsilon);
+        EXPECT_NEAR(time_domain_head_output[channel][frame],
+                    uniform_output[channel][frame], kEpsilon);
+        EXPECT_EQ(symmetric_output[channel][frame],
+                  uniform_output[channel][frame]);
+      }
+    }
+  }
+}
+
+// Tests that blocks of variable sizes are re-buffered into the internal block
+// size, delaying the output by the reported latency, and that matching blocks
+// are processed without latency.
+TEST(ObrImplTest, TestVariableBlockSizes) {
+  const int kBufferSizePerChannel = 32;
+  const size_t kNumBuffers = 24;
+  const size_t kNumFrames = kNumBuffers * kBufferSizePerChannel;
+  const size_t kMaxFramesPerProcess = 100;
+  const int kAmbisonicOrder = 3;
+  const std::vector<size_t> kBlockSizes = {7, 32, 1, 100, 45, 32, 0, 64, 19};
+
+  ObrImpl reference_renderer(kBufferSizePerChannel, 48000);
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(reference_renderer.AddAudioElement(AudioElementType::k3OA),
+              IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+
+  // Impulses in the first and a later buffer.
+  AudioBuffer scene = GetKroneckerDeltaEncodedToAmbisonics(
+      kBufferSizePerChannel, 30.0f, 10.0f, 1.0f, kAmbisonicOrder);
+  AudioBuffer input(scene.num_channels(), kNumFrames);
+  input.Clear();
+  for (size_t channel = 0; channel < scene.num_channels(); ++channel) {
+    for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+      input[channel][frame] = scene[channel][frame];
+      input[channel][9 * kBufferSizePerChannel + 5 + frame] =
+          -0.5f * scene[channel][frame];
+    }
+  }
+
+  AudioBuffer block_input(scene.num_channels(), kBufferSizePerChannel);
+  AudioBuffer block_output(2, kBufferSizePerChannel);
+  AudioBuffer reference_output(2, kNumFrames);
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    for (size_t channel = 0; channel < input.num_channels(); ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        block_input[channel][frame] =
+            input[channel][buffer * kBufferSizePerChannel + frame];
+      }
+    }
+    reference_renderer.Process(block_input, &block_output);
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        reference_output[channel][buffer * kBufferSizePerChannel + frame] =
+            block_output[channel][frame];
+      }
+    }
+  }
+
+  // The first two buffers match the internal block size and are processed
+  // without latency, the following blocks are re-buffered.
+  AudioBuffer variable_input(scene.num_channels(), kMaxFramesPerProcess);
+  AudioBuffer variable_output(2, kMaxFramesPerProcess);
+  AudioBuffer output(2, kNumFrames);
+  size_t begin_frame = 0;
+  for (size_t block = 0; begin_frame < kNumFrames; ++block) {
+    const size_t num_frames =
+        block < 2 ? kBufferSizePerChannel
+                  : std::min(kBlockSizes[block % kBlockSizes.size()],
+                             kNumFrames - begin_frame);
+    for (size_t channel = 0; channel < input.num_channels(); ++channel) {
+      for (size_t frame = 0; frame < num_frames; ++frame) {
+        variable_input[channel][frame] = input[channel][begin_frame + frame];
+      }
+    }
+    renderer.Process(variable_input, num_frames, &variable_output);
+    if (block == 1) {
+      EXPECT_EQ(renderer.GetLatencyInFrames(), 0);
+    }
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t frame = 0; frame < num_frames; ++frame) {
+        output[channel][begin_frame + frame] = variable_output[channel][frame];
+      }
+    }
+    begin_frame += num_frames;
+  }
+  const size_t latency = static_cast<size_t>(renderer.GetLatencyInFrames());
+  EXPECT_EQ(latency, kBufferSizePerChannel - 1);
+
+  const size_t fifo_begin_frame = 2 * kBufferSizePerChannel;
+  for (size_t channel = 0; channel < 2; ++channel) {
+    for (size_t frame = 0; frame < kNumFrames; ++frame) {
+      float expected = reference_output[channel][frame];
+      if (frame >= fifo_begin_frame) {
+        expected = frame >= fifo_begin_frame + latency
+                       ? reference_output[channel][frame - latency]
+                       : 0.0f;
+      }
+      EXPECT_EQ(output[channel][frame], expected) << frame;
+    }
+  }
+}
+
+// Tests that the interleaved overloads match planar processing, including the
+// peak limiting of a loud signal and the re-buffering after a partial block.
+TEST(ObrImplTest, TestInterleavedProcess) {
+  const int kBufferSizePerChannel = 64;
+  const size_t kNumBuffers = 6;
+
+  for (const auto type :
+       {AudioElementType::kLayoutStereo, AudioElementType::kLayout7_1_4_ch}) {
+    ObrImpl reference_renderer(kBufferSizePerChannel, 48000);
+    ObrImpl float_renderer(kBufferSizePerChannel, 48000);
+    ObrImpl int16_renderer(kBufferSizePerChannel, 48000);
+    EXPECT_THAT(reference_renderer.AddAudioElement(type), IsOk());
+    EXPECT_THAT(float_renderer.AddAudioElement(type), IsOk());
+    EXPECT_THAT(int16_renderer.AddAudioElement(type), IsOk());
+    const size_t num_channels = reference_renderer.GetNumberOfInputChannels();
+
+    std::vector<int16_t> int16_input(num_channels * kBufferSizePerChannel);
+    std::vector<float> float_input(int16_input.size());
+    std::vector<int16_t> int16_output(2 * kBufferSizePerChannel);
+    std::vector<float> float_output(int16_output.size());
+    AudioBuffer input(num_channels, kBufferSizePerChannel);
+    AudioBuffer output(2, kBufferSizePerChannel);
+    for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        for (size_t channel = 0; channel < num_channels; ++channel) {
+          const size_t index = frame * num_channels + channel;
+          const float sample = std::sin(
+              0.05f * static_cast<float>((channel + 1) *
+                                         (buffer * kBufferSizePerChannel +
+                                          frame)));
+          int16_input[index] = static_cast<int16_t>(30000.0f * sample);
+          ConvertSampleToFloatFormat(int16_input[index], &float_input[index]);
+          input[channel][frame] = float_input[index];
+        }
+      }
+
+      // Engages the re-buffering of all renderers.
+      const size_t num_frames = buffer == 3 ? kBufferSizePerChannel / 2
+                                            : kBufferSizePerChannel;
+      if (num_frames < kBufferSizePerChannel) {
+        reference_renderer.Process(input, num_frames, &output);
+        float_renderer.Process(input, num_frames, &output);
+        int16_renderer.Process(input, num_frames, &output);
+        continue;
+      }
+      reference_renderer.Process(input, &output);
+      float_renderer.Process(float_input.data(), num_channels,
+                             float_output.data());
+      int16_renderer.Process(int16_input.data(), num_channels,
+                             int16_output.data());
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        for (size_t channel = 0; channel < 2; ++channel) {
+          const size_t index = frame * 2 + channel;
+          EXPECT_EQ(float_output[index], output[channel][frame]);
+          int16_t expected;
+          ConvertSampleFromFloatFormat(output[channel][frame], &expected);
+          EXPECT_EQ(int16_output[index], expected);
+        }
+      }
+    }
+  }
+}
+
+// Tests that processing external channel buffers matches processing
+// `AudioBuffer`s, both in place for aligned channels and through copies for
+// unaligned ones.
+TEST(ObrImplTest, TestPlanarPointerProcess) {
+  const int kBufferSizePerChannel = 32;
+  const size_t kMaxFramesPerProcess = 64;
+  const std::vector<size_t> kBlockSizes = {32, 32, 20, 45, 32, 64, 7, 0, 40};
+
+  ObrImpl reference_renderer(kBufferSizePerChannel, 48000);
+  ObrImpl aligned_renderer(kBufferSizePerChannel, 48000);
+  ObrImpl unaligned_renderer(kBufferSizePerChannel, 48000);
+  for (ObrImpl* renderer :
+       {&reference_renderer, &aligned_renderer, &unaligned_renderer}) {
+    EXPECT_THAT(renderer->AddAudioElement(AudioElementType::k2OA), IsOk());
+    EXPECT_THAT(renderer->AddAudioElement(AudioElementType::kObjectMono),
+                IsOk());
+  }
+  const size_t num_channels = reference_renderer.GetNumberOfInputChannels();
+
+  AudioBuffer input(num_channels, kMaxFramesPerProcess);
+  AudioBuffer output(2, kMaxFramesPerProcess);
+  AudioBuffer aligned_output(2, kMaxFramesPerProcess);
+  // Offset by one frame from the aligned channel starts.
+  AudioBuffer unaligned_input(num_channels, kMaxFramesPerProcess + 1);
+  AudioBuffer unaligned_output(2, kMaxFramesPerProcess + 1);
+  std::vector<const float*> aligned_input_ptrs, unaligned_input_ptrs;
+  for (size_t channel = 0; channel < num_channels; ++channel) {
+    aligned_input_ptrs.push_back(input[channel].begin());
+    unaligned_input_ptrs.push_back(unaligned_input[channel].begin() + 1);
+  }
+  float* aligned_output_ptrs[] = {aligned_output[0].begin(),
+                                  aligned_output[1].begin()};
+  float* unaligned_output_ptrs[] = {unaligned_output[0].begin() + 1,
+                                    unaligned_output[1].begin() + 1};
+
+  size_t begin_frame = 0;
+  for (const size_t num_frames : kBlockSizes) {
+    for (size_t channel = 0; channel < num_channels; ++channel) {
+      for (size_t frame = 0; frame < num_frames; ++frame) {
+        input[channel][frame] = 0.5f * std::sin(0.1f * static_cast<float>(
+                                                           (channel + 1) *
+                                                           (begin_frame +
+                                                            frame)));
+        unaligned_input[channel][frame + 1] = input[channel][frame];
+      }
+    }
+    reference_renderer.Process(input, num_frames, &output);
+    aligned_renderer.Process(aligned_input_ptrs.data(), aligned_output_ptrs,
+                             num_frames);
+    unaligned_renderer.Process(unaligned_input_ptrs.data(),
+                               unaligned_output_ptrs, num_frames);
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t frame = 0; frame < num_frames; ++frame) {
+        EXPECT_EQ(aligned_output[channel][frame], output[channel][frame]);
+        EXPECT_EQ(unaligned_output[channel][frame + 1],
+                  output[channel][frame]);
+      }
+    }
+    begin_frame += num_frames;
+  }
+}
+
+// Tests that aligned channels with several whole blocks are processed block by
+// block, without engaging the re-buffering.
+TEST(ObrImplTest, TestPlanarPointerProcessKeepsZeroLatency) {
+  const int kBufferSizePerChannel = 32;
+  const size_t kNumBlocksPerProcess = 2;
+  const size_t kNumProcessCalls = 3;
+  const size_t kNumFrames = kNumBlocksPerProcess * kBufferSizePerChannel;
+
+  ObrImpl reference_renderer(kBufferSizePerChannel, 48000);
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(reference_renderer.AddAudioElement(AudioElementType::k1OA),
+              IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k1OA), IsOk());
+  const size_t num_channels = renderer.GetNumberOfInputChannels();
+
+  AudioBuffer input(num_channels, kNumFrames);
+  AudioBuffer output(2, kNumFrames);
+  AudioBuffer reference_input(num_channels, kBufferSizePerChannel);
+  AudioBuffer reference_output(2, kBufferSizePerChannel);
+  std::vector<const float*> input_ptrs;
+  for (size_t channel = 0; channel < num_channels; ++channel) {
+    input_ptrs.push_back(input[channel].begin());
+  }
+  float* output_ptrs[] = {output[0].begin(), output[1].begin()};
+
+  for (size_t call = 0; call < kNumProcessCalls; ++call) {
+    for (size_t channel = 0; channel < num_channels; ++channel) {
+      for (size_t frame = 0; frame < kNumFrames; ++frame) {
+        input[channel][frame] = 0.5f * std::sin(0.1f * static_cast<float>(
+                                                           (channel + 1) *
+                                                           (call * kNumFrames +
+                                                            frame)));
+      }
+    }
+    renderer.Process(input_ptrs.data(), output_ptrs, kNumFrames);
+    EXPECT_EQ(renderer.GetLatencyInFrames(), 0);
+
+    for (size_t block = 0; block < kNumBlocksPerProcess; ++block) {
+      const size_t begin_frame = block * kBufferSizePerChannel;
+      for (size_t channel = 0; channel < num_channels; ++channel) {
+        for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+          reference_input[channel][frame] =
+              input[channel][begin_frame + frame];
+        }
+      }
+      reference_renderer.Process(reference_input, &reference_output);
+      for (size_t channel = 0; channel < 2; ++channel) {
+        for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+          EXPECT_EQ(output[channel][begin_frame + frame],
+                    reference_output[channel][frame]);
+        }
+      }
+    }
+  }
+}
+
+// Tests that the processing statistics count the blocks of all `Process()`
+// overloads, time the stages and count the blocks limited by the peak limiter.
+TEST(ObrImplTest, TestProcessingStats) {
+  const int kBufferSizePerChannel = 128;
+  const size_t kNumBuffers = 8;
+
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono), IsOk());
+  renderer.EnableHeadTracking(true);
+  EXPECT_EQ(renderer.GetStats().num_blocks, 0U);
+
+  const size_t num_channels = renderer.GetNumberOfInputChannels();
+  AudioBuffer input(num_channels, kBufferSizePerChannel);
+  AudioBuffer output(2, kBufferSizePerChannel);
+  std::vector<float> interleaved_input(num_channels * kBufferSizePerChannel);
+  std::vector<float> interleaved_output(2 * kBufferSizePerChannel);
+  for (size_t channel = 0; channel < num_channels; ++channel) {
+    for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+      input[channel][frame] =
+          0.001f * std::sin(0.1f * static_cast<float>((channel + 1) * frame));
+    }
+  }
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    renderer.Process(input, &output);
+  }
+  renderer.Process(interleaved_input.data(), num_channels,
+                   interleaved_output.data());
+  ObrStats stats = renderer.GetStats();
+  EXPECT_EQ(stats.num_blocks, kNumBuffers + 1);
+  EXPECT_EQ(stats.num_limited_blocks, 0U);
+  EXPECT_EQ(stats.num_limited_frames, 0U);
+#if !defined(OBR_DISABLE_STATS)
+  EXPECT_EQ(stats.total.num_values, kNumBuffers + 1);
+  EXPECT_LE(stats.total.min, stats.total.mean);
+  EXPECT_LE(stats.total.mean, stats.total.p99);
+  EXPECT_LE(stats.total.p99, stats.total.max);
+  EXPECT_GT(stats.encoder.max, 0.0f);
+  EXPECT_GT(stats.binaural_decoder.mean, 0.0f);
+  EXPECT_GT(stats.forward_fft.mean, 0.0f);
+  EXPECT_GT(stats.multiply_accumulate.mean, 0.0f);
+  EXPECT_GT(stats.inverse_fft.mean, 0.0f);
+  EXPECT_GE(stats.binaural_decoder.max, stats.inverse_fft.max);
+  EXPECT_GE(stats.total.max, stats.binaural_decoder.max);
+#endif
+
+  // A full scale input drives the peak limiter.
+  for (size_t channel = 0; channel < num_channels; ++channel) {
+    for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+      input[channel][frame] = frame % 2 == 0 ? 1.0f : -1.0f;
+    }
+  }
+  renderer.Process(input, &output);
+  stats = renderer.GetStats();
+  EXPECT_EQ(stats.num_limited_blocks, 1U);
+  EXPECT_GT(stats.num_limited_frames, 0U);
+  EXPECT_LE(stats.num_limited_frames, kBufferSizePerChannel);
+
+  renderer.ResetStats();
+  stats = renderer.GetStats();
+  EXPECT_EQ(stats.num_blocks, 0U);
+  EXPECT_EQ(stats.num_limited_blocks, 0U);
+  EXPECT_EQ(stats.num_limited_frames, 0U);
+  EXPECT_EQ(stats.total.num_values, 0U);
+
+  // The reset is applied by the next block, which is counted on its own.
+  renderer.Process(input, &output);
+  stats = renderer.GetStats();
+  EXPECT_EQ(stats.num_blocks, 1U);
+  EXPECT_EQ(stats.num_limited_blocks, 1U);
+#if !defined(OBR_DISABLE_STATS)
+  EXPECT_EQ(stats.total.num_values, 1U);
+#endif
+}
+
+// Tests that head rotations and object positions can be updated from another
+// thread while processing, and that the last update takes effect.
+TEST(ObrImplTest, TestConcurrentParameterUpdates) {
+  const int kBufferSizePerChannel = 64;
+  const size_t kNumUpdates = 2000;
+  const size_t kNumFlushBuffers = 32;
+  const size_t kNumResponseBuffers = 8;
+
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono), IsOk());
+  renderer.EnableHeadTracking(true);
+
+  AudioBuffer impulse(1, kBufferSizePerChannel);
+  GenerateDiracImpulseFilter(0, &impulse[0]);
+  AudioBuffer silence(1, kBufferSizePerChannel);
+  silence.Clear();
+  AudioBuffer output(2, kBufferSizePerChannel);
+
+  std::atomic<bool> done(false);
+  std::thread control_thread([&renderer, &done]() {
+    for (size_t i = 0; i < kNumUpdates; ++i) {
+      const float angle = 0.01f * static_cast<float>(i);
+      EXPECT_THAT(renderer.SetHeadRotation(std::cos(angle), 0.0f,
+                                           std::sin(angle), 0.0f),
+                  IsOk());
+      EXPECT_THAT(renderer.UpdateObjectPosition(0, 90.0f * std::sin(angle),
+                                                0.0f, 1.0f),
+                  IsOk());
+    }
+    // Leave the object on the left of a head facing front.
+    EXPECT_THAT(renderer.SetHeadRotation(1.0f, 0.0f, 0.0f, 0.0f), IsOk());
+    EXPECT_THAT(renderer.UpdateObjectPosition(0, 90.0f, 0.0f, 1.0f), IsOk());
+    done = true;
+  });
+  while (!done) {
+    renderer.Process(impulse, &output);
+  }
+  control_thread.join();
+
+  // Returns the response to an impulse after the previous output decayed.
+  auto render_impulse_response = [&]() {
+    for (size_t buffer = 0; buffer < kNumFlushBuffers; ++buffer) {
+      renderer.Process(silence, &output);
+    }
+    AudioBuffer response(2, kNumResponseBuffers * kBufferSizePerChannel);
+    for (size_t buffer = 0; buffer < kNumResponseBuffers; ++buffer) {
+      renderer.Process(buffer == 0 ? impulse : silence, &output);
+      for (size_t channel = 0; channel < 2; ++channel) {
+        std::copy_n(output[channel].begin(), kBufferSizePerChannel,
+                    response[channel].begin() + buffer * kBufferSizePerChannel);
+      }
+    }
+    return response;
+  };
+  AudioBuffer response = render_impulse_response();
+  EXPECT_GT(GetBroadbandILD(response[0], response[1]), 10.0);
+
+  // Turning the head around moves the object to the right.
+  EXPECT_THAT(renderer.SetHeadRotation(0.0f, 0.0f, 1.0f, 0.0f), IsOk());
+  response = render_impulse_response();
+  EXPECT_LT(GetBroadbandILD(response[0], response[1]), -10.0);
+}
+
+// Tests that a reconfiguration switches to the new DSP at the next block,
+// crossfading from the old DSP over that block.
+TEST(ObrImplTest, TestReconfigurationCrossfade) {
+  const int kBufferSizePerChannel = 64;
+  const size_t kNumBuffers = 12;
+  const size_t kSwitchBuffer = 8;
+  const size_t kNumChannels = 16;
+  const float kEpsilon = 1e-6f;
+
+  // A quiet input keeps the peak limiter transparent.
+  std::vector<AudioBuffer> inputs;
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    inputs.emplace_back(kNumChannels, kBufferSizePerChannel);
+    for (size_t channel = 0; channel < kNumChannels; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        const float time =
+            static_cast<float>(buffer * kBufferSizePerChannel + frame);
+        inputs.back()[channel][frame] =
+            0.005f * std::sin(0.01f * static_cast<float>(channel + 1) * time);
+      }
+    }
+  }
+
+  ObrImpl reference_renderer(kBufferSizePerChannel, 48000);
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  ObrImpl new_renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(reference_renderer.AddAudioElement(AudioElementType::k3OA),
+              IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+  EXPECT_THAT(new_renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+
+  AudioBuffer reference_output(2, kBufferSizePerChannel);
+  AudioBuffer output(2, kBufferSizePerChannel);
+  AudioBuffer new_output(2, kBufferSizePerChannel);
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    if (buffer == kSwitchBuffer) {
+      // Rebuilds the DSP with the same configuration.
+      EXPECT_THAT(
+          renderer.SetBinauralDecoderOptions(AmbisonicBinauralDecoderOptions()),
+          IsOk());
+    }
+    reference_renderer.Process(inputs[buffer], &reference_output);
+    renderer.Process(inputs[buffer], &output);
+    if (buffer < kSwitchBuffer) {
+      for (size_t channel = 0; channel < 2; ++channel) {
+        for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+          EXPECT_EQ(output[channel][frame], reference_output[channel][frame]);
+        }
+      }
+      continue;
+    }
+
+    // The new DSP starts without the history of the earlier blocks.
+    new_renderer.Process(inputs[buffer], &new_output);
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        float expected = new_output[channel][frame];
+        if (buffer == kSwitchBuffer) {
+          const float gain = static_cast<float>(frame + 1) /
+                             static_cast<float>(kBufferSizePerChannel);
+          expected = (1.0f - gain) * reference_output[channel][frame] +
+                     gain * new_output[channel][frame];
+        }
+        EXPECT_NEAR(output[channel][frame], expected, kEpsilon);
+      }
+    }
+  }
+}
+
+// Tests that the DSP faded out after a reconfiguration is released by the next
+// control call, without waiting for another reconfiguration.
+TEST(ObrImplTest, TestFinishedDspIsReleased) {
+  const int kBufferSizePerChannel = 64;
+  KernelRegistry& registry = KernelRegistry::GetInstance();
+  ASSERT_EQ(registry.GetNumKernelSets(), 0);
+
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k1OA), IsOk());
+  AudioBuffer first_order_input(4, kBufferSizePerChannel);
+  first_order_input.Clear();
+  AudioBuffer output(2, kBufferSizePerChannel);
+  renderer.Process(first_order_input, &output);
+
+  // Switching to third order fades out the first order DSP.
+  EXPECT_THAT(renderer.BeginConfiguration(), IsOk());
+  EXPECT_THAT(renderer.RemoveLastAudioElement(), IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+  EXPECT_THAT(renderer.CommitConfiguration(), IsOk());
+  EXPECT_EQ(registry.GetNumKernelSets(), 2);
+  AudioBuffer third_order_input(16, kBufferSizePerChannel);
+  third_order_input.Clear();
+  renderer.Process(third_order_input, &output);
+  EXPECT_EQ(registry.GetNumKernelSets(), 2);
+
+  renderer.EnableHeadTracking(false);
+  EXPECT_EQ(registry.GetNumKernelSets(), 1);
+}
+
+// Tests that adding audio elements which keep the binaural filter order
+// continues with the decoder state of the current DSP, without a crossfade.
+TEST(ObrImplTest, TestIncrementalReconfiguration) {
+  const int kBufferSizePerChannel = 64;
+  const size_t kNumBuffers = 12;
+  const size_t kFirstAddBuffer = 1;
+
+  ObrImpl reference_renderer(kBufferSizePerChannel, 48000);
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(reference_renderer.AddAudioElement(AudioElementType::kObjectMono),
+              IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono), IsOk());
+
+  // The tail of the binaural filters reaches into the buffers after the first
+  // reconfiguration.
+  AudioBuffer reference_input(1, kBufferSizePerChannel);
+  size_t num_objects = 1;
+
+  AudioBuffer reference_output(2, kBufferSizePerChannel);
+  AudioBuffer output(2, kBufferSizePerChannel);
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    // Add one silent object per buffer.
+    if (buffer >= kFirstAddBuffer) {
+      EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono),
+                  IsOk());
+      ++num_objects;
+    }
+    AudioBuffer input(num_objects, kBufferSizePerChannel);
+    input.Clear();
+    reference_input.Clear();
+    if (buffer == 0) {
+      input[0][0] = 0.5f;
+      reference_input[0][0] = 0.5f;
+    }
+    reference_renderer.Process(reference_input, &reference_output);
+    renderer.Process(input, &output);
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        EXPECT_EQ(output[channel][frame], reference_output[channel][frame]);
+      }
+    }
+  }
+}
+
+// Tests that aborting a configuration discards staged decoder options, so that
+// the next reconfiguration continues with the current decoder.
+TEST(ObrImplTest, TestAbortedDecoderOptionsKeepDecoder) {
+  const int kBufferSizePerChannel = 64;
+  const size_t kNumBuffers = 8;
+  const size_t kAddBuffer = 1;
+
+  ObrImpl reference_renderer(kBufferSizePerChannel, 48000);
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(reference_renderer.AddAudioElement(AudioElementType::kObjectMono),
+              IsOk());
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono), IsOk());
+
+  AudioBuffer reference_output(2, kBufferSizePerChannel);
+  AudioBuffer output(2, kBufferSizePerChannel);
+  size_t num_objects = 1;
+  for (size_t buffer = 0; buffer < kNumBuffers; ++buffer) {
+    if (buffer == kAddBuffer) {
+      EXPECT_THAT(renderer.BeginConfiguration(), IsOk());
+      EXPECT_THAT(renderer.SetBinauralDecoderOptions(
+                      AmbisonicBinauralDecoderOptions()),
+                  IsOk());
+      EXPECT_THAT(renderer.AbortConfiguration(), IsOk());
+      EXPECT_THAT(
+          reference_renderer.AddAudioElement(AudioElementType::kObjectMono),
+          IsOk());
+      EXPECT_THAT(renderer.AddAudioElement(AudioElementType::kObjectMono),
+                  IsOk());
+      ++num_objects;
+    }
+    AudioBuffer input(num_objects, kBufferSizePerChannel);
+    input.Clear();
+    if (buffer == 0) {
+      input[0][0] = 0.5f;
+    }
+    reference_renderer.Process(input, &reference_output);
+    renderer.Process(input, &output);
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        EXPECT_EQ(output[channel][frame], reference_output[channel][frame]);
+      }
+    }
+  }
+}
+
+// Tests that the DSP can be rebuilt while another thread is processing.
+TEST(ObrImplTest, TestReconfigurationWhileProcessing) {
+  const int kBufferSizePerChannel = 64;
+  const size_t kNumReconfigurations = 6;
+
+  ObrImpl renderer(kBufferSizePerChannel, 48000);
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+  AudioBuffer input = GetKroneckerDeltaEncodedToAmbisonics(
+      kBufferSizePerChannel, 30.0f, 0.0f, 1.0f, 3);
+  AudioBuffer output(2, kBufferSizePerChannel);
+
+  std::atomic<bool> done(false);
+  std::thread control_thread([&renderer, &done]() {
+    AmbisonicBinauralDecoderOptions options;
+    for (size_t i = 0; i < kNumReconfigurations; ++i) {
+      options.convolution_mode = i % 2 == 0
+                                     ? ConvolutionMode::kNonUniformPartitioned
+                                     : ConvolutionMode::kUniformPartitioned;
+      EXPECT_THAT(renderer.SetBinauralDecoderOptions(options), IsOk());
+    }
+    done = true;
+  });
+  do {
+    renderer.Process(input, &output);
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t frame = 0; frame < kBufferSizePerChannel; ++frame) {
+        ASSERT_TRUE(std::isfinite(output[channel][frame]));
+      }
+    }
+  } while (!done);
+  control_thread.join();
+}
+
 // Fails when input AudioBuffer has different number of channels than the
 // declared number of input channels.
 TEST(ObrImplTest, TestProcessAudioBufferWithWrongNumberOfChannels) {
@@ -170,6 +1362,21 @@ TEST(ObrImplTest, TestProcessAudioBufferWithWrongNumberOfChannels) {
   EXPECT_DEATH(renderer.Process(input_buffer, &output_buffer), "");
 }
 
+// Fails when interleaved input has a different number of channels than the
+// declared number of input channels.
+TEST(ObrImplTest, TestProcessInterleavedWithWrongNumberOfChannels) {
+  const int kBufferSizePerChannel = 12;
+  const int kSamplingRate = 48000;
+
+  ObrImpl renderer(kBufferSizePerChannel, kSamplingRate);
+  EXPECT_THAT(renderer.AddAudioElement(AudioElementType::k3OA), IsOk());
+
+  std::vector<int16_t> input(17 * kBufferSizePerChannel);
+  std::vector<int16_t> output(2 * kBufferSizePerChannel);
+
+  EXPECT_DEATH(renderer.Process(input.data(), 17, output.data()), "");
+}
+
 // Fails when input AudioBuffer has different number of frames than the declared
 // buffer size.
 TEST(ObrImplTest, TestProcessAudioBufferWithWrongBufferSize) {